@@ -5,4 +5,4 @@
 
 void handleModuleSpecificConfig(const JsonObject& doc);
 void handleModuleSpecificModule(const JsonObject& doc);
-void handleModuleSpecificErrors(const String& message);
\ No newline at end of file
+void handleModuleSpecificErrors(const char* payload, size_t len);
\ No newline at end of file
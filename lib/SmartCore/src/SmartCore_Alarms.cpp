@@ -0,0 +1,490 @@
+#include "SmartCore_Alarms.h"
+#include <ArduinoJson.h>
+#include <LittleFS.h>
+#include "SmartCore_MQTT.h"
+#include "SmartCore_RPC.h"
+#include "SmartCore_System.h"
+#include "SmartCore_Network.h"
+#include "SmartCore_Log.h"
+#include "SmartCore_Hash.h"
+
+namespace SmartCore_Alarms
+{
+    TaskHandle_t alarmsTaskHandle = NULL;
+
+    struct Alarm
+    {
+        char id[ALARM_ID_LEN];
+        char signal[ALARM_SIGNAL_LEN];
+        char message[ALARM_MESSAGE_LEN];
+        uint32_t hash;
+        uint16_t errorNumber;
+        bool above;          // true → trips above threshold, false → below
+        float threshold;
+        float hysteresis;
+        uint32_t debounceMs;
+        bool latching;
+
+        bool raw;            // hysteresis-filtered condition
+        bool condition;      // debounced condition
+        bool pending;        // raw != condition, debounce timer running
+        uint32_t pendingSince;
+        float lastValue;
+        AlarmState state;
+    };
+
+    static Alarm alarms[ALARMS_MAX];
+    static uint8_t alarmsLoaded = 0;
+    static SemaphoreHandle_t alarmsMutex = nullptr;
+
+    static uint32_t hashName(const char *name)
+    {
+        return SmartCore_Hash::fnv1a(name);
+    }
+
+    static const char *stateToStr(AlarmState state)
+    {
+        switch (state)
+        {
+        case ALARM_NORMAL:  return "normal";
+        case ALARM_ACTIVE:  return "active";
+        case ALARM_ACKED:   return "acknowledged";
+        case ALARM_LATCHED: return "latched";
+        default:            return "unknown";
+        }
+    }
+
+    static void publishTransition(const Alarm &alarm, const char *status)
+    {
+        String text = String(alarm.message) + " (" + String(alarm.lastValue, 2) + ")";
+
+        SmartCore_MQTT::publishModuleError(
+            text,
+            alarm.errorNumber,
+            "alarm",
+            alarm.id,
+            status);
+    }
+
+    // ======================================================================================
+    //  ALARM STATE MACHINE (caller holds alarmsMutex)
+    // ======================================================================================
+    //
+    //   NORMAL ──raise──▶ ACTIVE ──ack──▶ ACKED ──clear──▶ NORMAL
+    //                       │                               ▲
+    //                       └─clear (latching)─▶ LATCHED ─ack┘
+    //                       └─clear (non-latching)──────────┘
+    //
+    //  Only transitions are published (module/error, category "alarm"):
+    //      raise → "active", clear → "cleared", ack → "acknowledged"
+    //
+    //  Thresholds use hysteresis (trip at threshold, release at threshold ∓ hysteresis)
+    //  and every change of the filtered condition must persist for debounceMs.
+    //
+    // ======================================================================================
+
+    static void applyCondition(Alarm &alarm, bool condition)
+    {
+        alarm.condition = condition;
+
+        if (condition)
+        {
+            if (alarm.state == ALARM_NORMAL)
+            {
+                alarm.state = ALARM_ACTIVE;
+                publishTransition(alarm, "active");
+            }
+            else if (alarm.state == ALARM_LATCHED)
+            {
+                // Still unacknowledged — condition came back, stay raised
+                alarm.state = ALARM_ACTIVE;
+            }
+            return;
+        }
+
+        if (alarm.state == ALARM_ACKED || (alarm.state == ALARM_ACTIVE && !alarm.latching))
+        {
+            alarm.state = ALARM_NORMAL;
+            publishTransition(alarm, "cleared");
+        }
+        else if (alarm.state == ALARM_ACTIVE)
+        {
+            alarm.state = ALARM_LATCHED;
+        }
+    }
+
+    static void evaluate(Alarm &alarm, float value, uint32_t now)
+    {
+        alarm.lastValue = value;
+
+        bool raw;
+        if (alarm.above)
+            raw = alarm.raw ? value >= alarm.threshold - alarm.hysteresis : value > alarm.threshold;
+        else
+            raw = alarm.raw ? value <= alarm.threshold + alarm.hysteresis : value < alarm.threshold;
+
+        alarm.raw = raw;
+
+        if (raw == alarm.condition)
+        {
+            alarm.pending = false; // bounced back before debounce expired
+            return;
+        }
+
+        if (alarm.debounceMs == 0)
+        {
+            alarm.pending = false;
+            applyCondition(alarm, raw);
+        }
+        else if (!alarm.pending)
+        {
+            alarm.pending = true;
+            alarm.pendingSince = now;
+        }
+    }
+
+    void updateValue(const char *signal, float value)
+    {
+        if (!alarmsMutex || alarmsLoaded == 0)
+            return;
+
+        uint32_t hash = hashName(signal);
+
+        if (xSemaphoreTake(alarmsMutex, pdMS_TO_TICKS(50)) != pdTRUE)
+            return;
+
+        uint32_t now = millis();
+        for (uint8_t i = 0; i < alarmsLoaded; i++)
+        {
+            Alarm &alarm = alarms[i];
+            if (alarm.hash == hash && !strcmp(alarm.signal, signal))
+                evaluate(alarm, value, now);
+        }
+
+        xSemaphoreGive(alarmsMutex);
+    }
+
+    static bool ackLocked(Alarm &alarm)
+    {
+        if (alarm.state == ALARM_ACTIVE)
+        {
+            alarm.state = ALARM_ACKED;
+            publishTransition(alarm, "acknowledged");
+            return true;
+        }
+
+        if (alarm.state == ALARM_LATCHED)
+        {
+            alarm.state = ALARM_NORMAL;
+            publishTransition(alarm, "acknowledged");
+            publishTransition(alarm, "cleared");
+            return true;
+        }
+
+        return false;
+    }
+
+    bool acknowledge(const char *id)
+    {
+        if (!alarmsMutex || xSemaphoreTake(alarmsMutex, pdMS_TO_TICKS(200)) != pdTRUE)
+            return false;
+
+        bool found = false;
+        for (uint8_t i = 0; i < alarmsLoaded; i++)
+        {
+            if (!strcmp(alarms[i].id, id))
+            {
+                found = ackLocked(alarms[i]);
+                break;
+            }
+        }
+
+        xSemaphoreGive(alarmsMutex);
+        return found;
+    }
+
+    void acknowledgeAll()
+    {
+        if (!alarmsMutex || xSemaphoreTake(alarmsMutex, pdMS_TO_TICKS(200)) != pdTRUE)
+            return;
+
+        for (uint8_t i = 0; i < alarmsLoaded; i++)
+            ackLocked(alarms[i]);
+
+        xSemaphoreGive(alarmsMutex);
+    }
+
+    // ======================================================================================
+    //  DEFINITIONS
+    // ======================================================================================
+    //
+    //    { "alarms": [
+    //        { "id": "shallow", "signal": "depth", "below": 2.0, "hysteresis": 0.3,
+    //          "debounce": 2000, "latching": true, "message": "Shallow water",
+    //          "errorNumber": 2001 },
+    //        { "id": "engineTemp", "signal": "temperature", "above": 95, "hysteresis": 3 }
+    //    ] }
+    //
+    //  Reloading keeps the state of alarms whose id is unchanged, so a config push does
+    //  not re-raise (or silently drop) an alarm the crew already knows about.
+    //
+    // ======================================================================================
+
+    static bool applyAlarms(JsonArrayConst list, String &error)
+    {
+        if (list.size() > ALARMS_MAX)
+        {
+            error = "too many alarms (max " + String(ALARMS_MAX) + ")";
+            return false;
+        }
+
+        static Alarm staged[ALARMS_MAX];
+        uint8_t count = 0;
+
+        for (JsonVariantConst src : list)
+        {
+            Alarm &a = staged[count];
+            memset(&a, 0, sizeof(a));
+
+            const char *id = src["id"] | "";
+            const char *signal = src["signal"] | "";
+
+            if (strlen(id) == 0 || strlen(id) >= ALARM_ID_LEN ||
+                strlen(signal) == 0 || strlen(signal) >= ALARM_SIGNAL_LEN)
+            {
+                error = "alarm " + String(count) + ": bad id/signal";
+                return false;
+            }
+
+            strncpy(a.id, id, ALARM_ID_LEN - 1);
+            strncpy(a.signal, signal, ALARM_SIGNAL_LEN - 1);
+            strncpy(a.message, src["message"] | id, ALARM_MESSAGE_LEN - 1);
+            a.hash = hashName(a.signal);
+
+            if (src["above"].is<float>())
+            {
+                a.above = true;
+                a.threshold = src["above"].as<float>();
+            }
+            else if (src["below"].is<float>())
+            {
+                a.above = false;
+                a.threshold = src["below"].as<float>();
+            }
+            else
+            {
+                error = String(id) + ": needs 'above' or 'below'";
+                return false;
+            }
+
+            a.hysteresis = fabsf(src["hysteresis"] | 0.0f);
+            a.debounceMs = src["debounce"] | 0;
+            a.latching = src["latching"] | false;
+            a.errorNumber = src["errorNumber"] | (ERR_ALARM_BASE + count);
+            a.state = ALARM_NORMAL;
+
+            count++;
+        }
+
+        if (xSemaphoreTake(alarmsMutex, pdMS_TO_TICKS(500)) != pdTRUE)
+        {
+            error = "alarm engine busy";
+            return false;
+        }
+
+        // Carry runtime state across for unchanged ids
+        for (uint8_t i = 0; i < count; i++)
+        {
+            for (uint8_t j = 0; j < alarmsLoaded; j++)
+            {
+                if (!strcmp(staged[i].id, alarms[j].id))
+                {
+                    staged[i].raw = alarms[j].raw;
+                    staged[i].condition = alarms[j].condition;
+                    staged[i].lastValue = alarms[j].lastValue;
+                    staged[i].state = alarms[j].state;
+                    break;
+                }
+            }
+        }
+
+        memcpy(alarms, staged, sizeof(Alarm) * count);
+        alarmsLoaded = count;
+
+        xSemaphoreGive(alarmsMutex);
+
+        logMessage(LOG_INFO, "🚨 Alarm definitions loaded: " + String(alarmsLoaded));
+        return true;
+    }
+
+    bool loadAlarms(const char *json, size_t len, bool persist)
+    {
+        if (!alarmsMutex)
+            return false;
+
+        DynamicJsonDocument doc(ALARMS_DOC_SIZE);
+        DeserializationError err = deserializeJson(doc, json, len);
+
+        if (err)
+        {
+            logMessage(LOG_WARN, String("❌ Failed to parse alarm definitions: ") + err.c_str());
+            return false;
+        }
+
+        String error;
+        if (!applyAlarms(doc["alarms"].as<JsonArrayConst>(), error))
+        {
+            logMessage(LOG_WARN, "❌ Alarm definitions rejected: " + error);
+            return false;
+        }
+
+        if (persist)
+        {
+            File f = LittleFS.open(ALARMS_FILE, "w");
+            if (f)
+            {
+                f.write((const uint8_t *)json, len);
+                f.close();
+            }
+        }
+
+        return true;
+    }
+
+    uint8_t alarmCount()
+    {
+        return alarmsLoaded;
+    }
+
+    static void publishAlarmStatus(const char *status, const String &error)
+    {
+        DynamicJsonDocument doc(1024);
+        doc["serialNumber"] = serialNumber;
+        doc["status"] = status;
+        if (error.length())
+            doc["error"] = error;
+
+        JsonArray list = doc.createNestedArray("alarms");
+
+        if (xSemaphoreTake(alarmsMutex, pdMS_TO_TICKS(200)) == pdTRUE)
+        {
+            for (uint8_t i = 0; i < alarmsLoaded; i++)
+            {
+                JsonObject a = list.createNestedObject();
+                a["id"] = alarms[i].id;
+                a["state"] = stateToStr(alarms[i].state);
+                a["value"] = alarms[i].lastValue;
+            }
+            xSemaphoreGive(alarmsMutex);
+        }
+
+        String payload;
+        serializeJson(doc, payload);
+        SmartCore_RPC::respond("module/alarms", 1, false, payload.c_str());
+    }
+
+    void handleAlarmsMessage(const char *payload, size_t len)
+    {
+        Serial.println("🚨 Alarms message received");
+
+        if (!alarmsMutex)
+            return;
+
+        DynamicJsonDocument doc(ALARMS_DOC_SIZE);
+        DeserializationError err = deserializeJson(doc, payload, len);
+
+        if (err)
+        {
+            publishAlarmStatus("error", String("bad JSON: ") + err.c_str());
+            return;
+        }
+
+        const char *action = doc["action"] | "set";
+
+        if (!strcmp(action, "ack"))
+        {
+            const char *id = doc["id"] | "";
+            if (strlen(id) == 0)
+                acknowledgeAll();
+            else if (!acknowledge(id))
+                Serial.printf("⚠️ Nothing to acknowledge for alarm '%s'\n", id);
+        }
+        else if (!strcmp(action, "status"))
+        {
+            publishAlarmStatus("status", "");
+        }
+        else if (!strcmp(action, "set"))
+        {
+            String error;
+            if (!applyAlarms(doc["alarms"].as<JsonArrayConst>(), error))
+            {
+                publishAlarmStatus("error", error);
+                return;
+            }
+
+            File f = LittleFS.open(ALARMS_FILE, "w");
+            if (f)
+            {
+                f.write((const uint8_t *)payload, len);
+                f.close();
+            }
+
+            publishAlarmStatus("loaded", "");
+        }
+        else
+        {
+            publishAlarmStatus("error", String("unsupported action '") + action + "'");
+        }
+    }
+
+    void alarmsTask(void *parameter)
+    {
+        for (;;)
+        {
+            if (alarmsLoaded && xSemaphoreTake(alarmsMutex, pdMS_TO_TICKS(50)) == pdTRUE)
+            {
+                uint32_t now = millis();
+
+                for (uint8_t i = 0; i < alarmsLoaded; i++)
+                {
+                    Alarm &alarm = alarms[i];
+                    if (alarm.pending && now - alarm.pendingSince >= alarm.debounceMs)
+                    {
+                        alarm.pending = false;
+                        applyCondition(alarm, alarm.raw);
+                    }
+                }
+
+                xSemaphoreGive(alarmsMutex);
+            }
+
+            vTaskDelay(pdMS_TO_TICKS(ALARMS_TICK_MS));
+        }
+    }
+
+    void init()
+    {
+        if (!alarmsMutex)
+            alarmsMutex = xSemaphoreCreateMutex();
+
+        if (!alarmsMutex)
+        {
+            logMessage(LOG_ERROR, "❌ Failed to create alarms mutex");
+            return;
+        }
+
+        if (LittleFS.exists(ALARMS_FILE))
+        {
+            File f = LittleFS.open(ALARMS_FILE, "r");
+            if (f)
+            {
+                String json = f.readString();
+                f.close();
+                loadAlarms(json.c_str(), json.length(), false);
+            }
+        }
+
+        if (!alarmsTaskHandle)
+            xTaskCreatePinnedToCore(alarmsTask, "Alarms Task", 3072, NULL, 1, &alarmsTaskHandle, 1);
+    }
+}
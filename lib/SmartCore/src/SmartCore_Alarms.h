@@ -0,0 +1,47 @@
+#pragma once
+
+#include <Arduino.h>
+
+#ifndef ALARMS_MAX
+#define ALARMS_MAX 16
+#endif
+
+#define ALARM_ID_LEN 24
+#define ALARM_SIGNAL_LEN 32
+#define ALARM_MESSAGE_LEN 48
+#define ALARMS_TICK_MS 100
+
+#define ALARMS_FILE "/alarms.json"
+#define ALARMS_DOC_SIZE 4096
+
+enum AlarmState : uint8_t
+{
+    ALARM_NORMAL,    // condition clear, nothing outstanding
+    ALARM_ACTIVE,    // raised, not yet acknowledged
+    ALARM_ACKED,     // raised, acknowledged, condition still present
+    ALARM_LATCHED    // condition gone, latched until acknowledged
+};
+
+namespace SmartCore_Alarms
+{
+    extern TaskHandle_t alarmsTaskHandle;
+
+    // Startup (loads persisted alarm definitions from LittleFS)
+    void init();
+
+    // Definitions
+    bool loadAlarms(const char *json, size_t len, bool persist);
+    uint8_t alarmCount();
+
+    // Inputs — same signal names as SmartCore_Rules::updateValue()
+    void updateValue(const char *signal, float value);
+
+    // Operator acknowledge
+    bool acknowledge(const char *id);
+    void acknowledgeAll();
+
+    // MQTT entry point (<serialNumber>/alarms)
+    void handleAlarmsMessage(const char *payload, size_t len);
+
+    void alarmsTask(void *parameter);
+}
@@ -0,0 +1,43 @@
+#include "SmartCore_Backoff.h"
+#include "SmartCore_Hash.h"
+
+namespace SmartCore_Backoff
+{
+    uint32_t hashMac(const uint8_t mac[6])
+    {
+        return SmartCore_Hash::fnv1aBytes(mac, 6);
+    }
+
+    uint32_t seed(uint32_t macHash, uint32_t entropy)
+    {
+        uint32_t state = macHash ^ entropy;
+        return state ? state : 0x9E3779B9UL;
+    }
+
+    // xorshift32 — uniform enough for scheduling, no heap, no locks
+    uint32_t between(uint32_t &state, uint32_t lo, uint32_t hi)
+    {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+
+        return hi > lo ? lo + state % (hi - lo + 1) : lo;
+    }
+
+    uint32_t decorrelated(uint32_t &state, uint32_t prevMs, uint32_t baseMs, uint32_t capMs)
+    {
+        uint32_t hi = prevMs * 3 < capMs ? prevMs * 3 : capMs;
+        uint32_t next = between(state, baseMs, hi);
+        return next < capMs ? next : capMs;
+    }
+
+    uint32_t firstDelay(uint32_t &state, uint32_t macHash, uint32_t windowMs, uint16_t slots,
+                        uint32_t spreadMs)
+    {
+        if (windowMs == 0 || slots == 0)
+            return between(state, 0, spreadMs);
+
+        uint32_t width = windowMs / slots;
+        return (macHash % slots) * width + between(state, 0, width);
+    }
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Reconnect backoff math used by SmartCore_Reconnect.
+// Framework-free on purpose: the fleet simulation in test/native runs the same code.
+
+namespace SmartCore_Backoff
+{
+    // FNV-1a of the MAC — picks the admission slot
+    uint32_t hashMac(const uint8_t mac[6]);
+
+    // xorshift32 state from the MAC hash and some entropy (never 0)
+    uint32_t seed(uint32_t macHash, uint32_t entropy);
+
+    // Uniform in [lo, hi]; advances state
+    uint32_t between(uint32_t &state, uint32_t lo, uint32_t hi);
+
+    // Decorrelated jitter: min(cap, random(base, prev·3))
+    uint32_t decorrelated(uint32_t &state, uint32_t prevMs, uint32_t baseMs, uint32_t capMs);
+
+    // First attempt of an outage: own slot of an admission window (slot·W/N + jitter
+    // within the slot), or [0, spreadMs] when no window is known (windowMs or slots 0)
+    uint32_t firstDelay(uint32_t &state, uint32_t macHash, uint32_t windowMs, uint16_t slots,
+                        uint32_t spreadMs);
+}
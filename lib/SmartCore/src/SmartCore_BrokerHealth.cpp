@@ -0,0 +1,288 @@
+#include "SmartCore_BrokerHealth.h"
+#include <LittleFS.h>
+#include <math.h>
+#include "SmartCore_Network.h"
+#include "SmartCore_System.h"
+#include "SmartCore_Log.h"
+
+namespace SmartCore_BrokerHealth
+{
+    // ======================================================================================
+    //  BROKER HEALTH RECORDS
+    // ======================================================================================
+    //
+    //  One small record per mqttPriorityList entry, fed by the prober and the
+    //  connection manager:
+    //
+    //      probe answered     → rtt EWMA, failScore halved
+    //      probe unanswered   → failScore += 0.5
+    //      connect failed     → failScore += 1
+    //      connected          → rtt EWMA (connect time), connects++
+    //      session ended      → session-length EWMA
+    //
+    //  failScore halves every BROKER_HEALTH_HALFLIFE_MS of uptime (and once per reboot,
+    //  since the downtime is unknown), so yesterday's flaky SmartBox is remembered but
+    //  forgiven over time. It is capped at BROKER_HEALTH_FAIL_MAX, so a long outage
+    //  counts no more than a short one: once the broker answers probes again, two or
+    //  three answered rounds bring it back under BROKER_HEALTH_FAIL_LIMIT.
+    //
+    //  rank() keeps the configured primary-first policy: priority 0 leads whenever it
+    //  is not flaky. Only the order of the backups — and a flaky primary — is learned:
+    //
+    //      score = rtt + 250·failScore − 2·min(session minutes, 60)    (lower = better)
+    //
+    //  Records are keyed by IP, so a re-provisioned list starts those entries fresh.
+    //  Flash writes: only when dirty, at most every BROKER_HEALTH_SAVE_MS (forced after
+    //  a failover).
+    //
+    // ======================================================================================
+
+    static constexpr uint8_t FILE_VERSION = 1;
+
+    static BrokerHealth records[BROKER_PROBE_MAX];
+    static portMUX_TYPE healthMux = portMUX_INITIALIZER_UNLOCKED;
+    static bool loaded = false;
+    static bool dirty = false;
+    static uint32_t lastDecayMs = 0;
+    static uint32_t lastSaveMs = 0;
+
+    static void load()
+    {
+        loaded = true;
+        memset(records, 0, sizeof(records));
+
+        for (uint8_t i = 0; i < BROKER_PROBE_MAX; i++)
+            strlcpy(records[i].ip, mqttPriorityList[i], sizeof(records[i].ip));
+
+        if (SmartCore_System::bootSafeMode || !LittleFS.exists(BROKER_HEALTH_FILE))
+            return;
+
+        File f = LittleFS.open(BROKER_HEALTH_FILE, "r");
+        if (!f)
+            return;
+
+        uint8_t version = 0;
+        BrokerHealth saved[BROKER_PROBE_MAX];
+
+        if (f.read(&version, 1) != 1 || version != FILE_VERSION ||
+            f.read((uint8_t *)saved, sizeof(saved)) != sizeof(saved))
+        {
+            f.close();
+            logMessage(LOG_WARN, "⚠️ Broker health file invalid — starting fresh");
+            return;
+        }
+        f.close();
+
+        // Match by address — priorities may have been reordered since
+        for (uint8_t i = 0; i < BROKER_PROBE_MAX; i++)
+        {
+            for (uint8_t j = 0; j < BROKER_PROBE_MAX; j++)
+            {
+                if (records[i].ip[0] && !strncmp(records[i].ip, saved[j].ip, sizeof(saved[j].ip)))
+                {
+                    records[i] = saved[j];
+                    records[i].failScore = min(records[i].failScore, BROKER_HEALTH_FAIL_MAX) *
+                                           0.5f; // downtime unknown → one half-life
+                    break;
+                }
+            }
+        }
+
+        logMessage(LOG_INFO, "🩺 Broker health restored");
+    }
+
+    // Called outside the critical section before every access
+    static void prepare()
+    {
+        if (!loaded)
+            load();
+
+        uint32_t now = millis();
+        uint32_t elapsed = now - lastDecayMs;
+        if (elapsed < 60000)
+            return;
+
+        float factor = powf(0.5f, (float)elapsed / (float)BROKER_HEALTH_HALFLIFE_MS);
+
+        portENTER_CRITICAL(&healthMux);
+        for (uint8_t i = 0; i < BROKER_PROBE_MAX; i++)
+            records[i].failScore *= factor;
+        lastDecayMs = now;
+        portEXIT_CRITICAL(&healthMux);
+    }
+
+    static void addRtt(BrokerHealth &r, uint16_t rttMs)
+    {
+        if (r.rttMs == 0)
+            r.rttMs = rttMs;
+        else
+            r.rttMs += (int32_t)(BROKER_HEALTH_RTT_ALPHA * ((int32_t)rttMs - (int32_t)r.rttMs));
+    }
+
+    static void addFailure(BrokerHealth &r, float amount)
+    {
+        r.failScore = min(r.failScore + amount, BROKER_HEALTH_FAIL_MAX);
+    }
+
+    void recordProbe(uint8_t i, bool answered, uint16_t rttMs)
+    {
+        if (i >= BROKER_PROBE_MAX)
+            return;
+        prepare();
+
+        portENTER_CRITICAL(&healthMux);
+        if (answered)
+        {
+            addRtt(records[i], rttMs);
+            records[i].failScore *= 0.5f; // it is back — forgive quickly
+        }
+        else
+        {
+            addFailure(records[i], 0.5f);
+        }
+        dirty = true;
+        portEXIT_CRITICAL(&healthMux);
+    }
+
+    void recordConnect(uint8_t i, uint16_t connectMs)
+    {
+        if (i >= BROKER_PROBE_MAX)
+            return;
+        prepare();
+
+        portENTER_CRITICAL(&healthMux);
+        addRtt(records[i], connectMs);
+        records[i].connects++;
+        dirty = true;
+        portEXIT_CRITICAL(&healthMux);
+    }
+
+    void recordFailure(uint8_t i)
+    {
+        if (i >= BROKER_PROBE_MAX)
+            return;
+        prepare();
+
+        portENTER_CRITICAL(&healthMux);
+        addFailure(records[i], 1.0f);
+        dirty = true;
+        portEXIT_CRITICAL(&healthMux);
+    }
+
+    void recordSessionEnd(uint8_t i, uint32_t durationMs)
+    {
+        if (i >= BROKER_PROBE_MAX)
+            return;
+        prepare();
+
+        uint32_t s = durationMs / 1000;
+
+        portENTER_CRITICAL(&healthMux);
+        BrokerHealth &r = records[i];
+        r.sessionS = r.sessionS == 0 ? s : (r.sessionS * 3 + s) / 4;
+        dirty = true;
+        portEXIT_CRITICAL(&healthMux);
+    }
+
+    static int32_t score(const BrokerHealth &r)
+    {
+        int32_t rtt = r.rttMs ? r.rttMs : 500; // unknown → assume mediocre
+        int32_t minutes = min<uint32_t>(r.sessionS / 60, 60);
+        return rtt + (int32_t)(250.0f * r.failScore) - 2 * minutes;
+    }
+
+    uint8_t rank(uint8_t out[BROKER_PROBE_MAX])
+    {
+        prepare();
+
+        uint8_t count = min<uint8_t>(mqttPriorityCount, BROKER_PROBE_MAX);
+        BrokerHealth snap[BROKER_PROBE_MAX];
+
+        portENTER_CRITICAL(&healthMux);
+        memcpy(snap, records, sizeof(snap));
+        portEXIT_CRITICAL(&healthMux);
+
+        uint8_t n = 0;
+
+        // 1) Primary, unless flaky
+        if (count > 0 && snap[0].failScore < BROKER_HEALTH_FAIL_LIMIT)
+            out[n++] = 0;
+
+        // 2) Other healthy brokers, best score first (insertion sort, ≤ 3 entries)
+        uint8_t healthyStart = n;
+        for (uint8_t i = 1; i < count; i++)
+        {
+            if (snap[i].failScore >= BROKER_HEALTH_FAIL_LIMIT)
+                continue;
+
+            uint8_t pos = n++;
+            while (pos > healthyStart && score(snap[out[pos - 1]]) > score(snap[i]))
+            {
+                out[pos] = out[pos - 1];
+                pos--;
+            }
+            out[pos] = i;
+        }
+
+        // 3) Flaky brokers, in configured order
+        for (uint8_t i = 0; i < count; i++)
+        {
+            if (snap[i].failScore >= BROKER_HEALTH_FAIL_LIMIT)
+                out[n++] = i;
+        }
+
+        return n;
+    }
+
+    int8_t indexOf(const String &ip)
+    {
+        for (uint8_t i = 0; i < mqttPriorityCount && i < BROKER_PROBE_MAX; i++)
+        {
+            if (ip == mqttPriorityList[i])
+                return i;
+        }
+        return -1;
+    }
+
+    bool get(uint8_t i, BrokerHealth &out)
+    {
+        if (i >= BROKER_PROBE_MAX)
+            return false;
+        prepare();
+
+        portENTER_CRITICAL(&healthMux);
+        out = records[i];
+        portEXIT_CRITICAL(&healthMux);
+        return true;
+    }
+
+    void persist(bool force)
+    {
+        if (!loaded || !dirty || SmartCore_System::bootSafeMode)
+            return;
+
+        uint32_t now = millis();
+        if (!force && lastSaveMs != 0 && now - lastSaveMs < BROKER_HEALTH_SAVE_MS)
+            return;
+
+        BrokerHealth snap[BROKER_PROBE_MAX];
+
+        portENTER_CRITICAL(&healthMux);
+        memcpy(snap, records, sizeof(snap));
+        dirty = false;
+        portEXIT_CRITICAL(&healthMux);
+
+        File f = LittleFS.open(BROKER_HEALTH_FILE, "w");
+        if (!f)
+        {
+            logMessage(LOG_WARN, "⚠️ Could not write broker health");
+            return;
+        }
+
+        f.write(&FILE_VERSION, 1);
+        f.write((const uint8_t *)snap, sizeof(snap));
+        f.close();
+
+        lastSaveMs = now;
+    }
+}
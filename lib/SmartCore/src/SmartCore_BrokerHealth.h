@@ -0,0 +1,46 @@
+#pragma once
+
+#include <Arduino.h>
+#include "SmartCore_BrokerProbe.h"
+
+#define BROKER_HEALTH_FILE "/mqtt_health.bin"
+
+#ifndef BROKER_HEALTH_HALFLIFE_MS
+#define BROKER_HEALTH_HALFLIFE_MS (6UL * 3600UL * 1000UL) // failure score halves every 6 h
+#endif
+#define BROKER_HEALTH_FAIL_LIMIT 3.0f                      // above this a broker is "flaky"
+#define BROKER_HEALTH_FAIL_MAX (2.0f * BROKER_HEALTH_FAIL_LIMIT) // failScore never exceeds this
+#define BROKER_HEALTH_SAVE_MS (30UL * 60UL * 1000UL)       // at most one flash write per 30 min
+#define BROKER_HEALTH_RTT_ALPHA 0.25f
+
+struct BrokerHealth
+{
+    char ip[17];       // record belongs to this address (list may be re-provisioned)
+    uint16_t rttMs;    // EWMA of probe / connect RTT (0 = never measured)
+    float failScore;   // +1 per failed connect, +0.5 per unanswered probe, halved per
+                       // answered probe, capped at BROKER_HEALTH_FAIL_MAX, decays
+    uint32_t sessionS; // EWMA of connected-session length
+    uint16_t connects;
+};
+
+namespace SmartCore_BrokerHealth
+{
+    // Samples (i = mqttPriorityList index)
+    void recordProbe(uint8_t i, bool answered, uint16_t rttMs);
+    void recordConnect(uint8_t i, uint16_t connectMs);
+    void recordFailure(uint8_t i);
+    void recordSessionEnd(uint8_t i, uint32_t durationMs);
+
+    // Selection order: priority 0 first while it is healthy, other healthy
+    // brokers by score, flaky brokers last in priority order. Returns count.
+    uint8_t rank(uint8_t out[BROKER_PROBE_MAX]);
+
+    // mqttPriorityList index of an address, or -1
+    int8_t indexOf(const String &ip);
+
+    bool get(uint8_t i, BrokerHealth &out);
+
+    // Write to LittleFS if something changed and BROKER_HEALTH_SAVE_MS has passed
+    // (force = ignore the interval, e.g. right after a failover)
+    void persist(bool force = false);
+}
@@ -0,0 +1,230 @@
+#include "SmartCore_BrokerProbe.h"
+#include <AsyncTCP.h>
+#include <freertos/event_groups.h>
+#include "SmartCore_Network.h"
+#include "SmartCore_BrokerHealth.h"
+#include "SmartCore_Log.h"
+
+namespace SmartCore_BrokerProbe
+{
+    // ======================================================================================
+    //  PARALLEL BROKER PROBE
+    // ======================================================================================
+    //
+    //  Instead of trying brokers one connect timeout at a time, open a bare TCP
+    //  connection to every entry of mqttPriorityList at once:
+    //
+    //      t=0    SYN → priority 0, 1, 2
+    //      t=rtt  first SYN/ACK … each answer closes its socket immediately
+    //
+    //  "Best" follows SmartCore_BrokerHealth::rank() — priority 0 first unless it has
+    //  been flaky, then the backups by learned score. The round ends as soon as the
+    //  answer is known — the best broker that answered, with every better-ranked one
+    //  already refused/unreachable — or after BROKER_PROBE_TIMEOUT_MS. A healthy primary
+    //  decides the round in one RTT. Every result is fed back into the health records.
+    //
+    //  • One AsyncClient per priority slot, created on first use and reused for every
+    //    round (never deleted, so closing a straggler can't race a delete). A callback
+    //    only counts while its slot is still PENDING.
+    //  • A TCP answer only says the port is open; the MQTT CONNECT that follows is
+    //    still covered by the connection manager's timeout.
+    //
+    // ======================================================================================
+
+    enum ProbeState : uint8_t
+    {
+        PROBE_IDLE = 0,
+        PROBE_PENDING,
+        PROBE_ANSWERED,
+        PROBE_FAILED
+    };
+
+    struct ProbeSlot
+    {
+        AsyncClient *client;
+        uint32_t startMs;
+        uint16_t rttMs;
+        volatile ProbeState state;
+        uint8_t index;
+    };
+
+    static ProbeSlot slots[BROKER_PROBE_MAX];
+    static portMUX_TYPE probeMux = portMUX_INITIALIZER_UNLOCKED;
+    static EventGroupHandle_t probeEvents = nullptr;
+    static SemaphoreHandle_t probeMutex = nullptr;
+
+    static void finish(ProbeSlot *s, AsyncClient *c, ProbeState result)
+    {
+        bool mine = false;
+
+        portENTER_CRITICAL(&probeMux);
+        if (s->state == PROBE_PENDING)
+        {
+            s->state = result;
+            s->rttMs = millis() - s->startMs;
+            mine = true;
+        }
+        portEXIT_CRITICAL(&probeMux);
+
+        if (mine)
+            xEventGroupSetBits(probeEvents, BIT(s->index));
+    }
+
+    static void onProbeConnect(void *arg, AsyncClient *c)
+    {
+        finish((ProbeSlot *)arg, c, PROBE_ANSWERED);
+        c->close(true);
+    }
+
+    static void onProbeError(void *arg, AsyncClient *c, int8_t error)
+    {
+        finish((ProbeSlot *)arg, c, PROBE_FAILED);
+    }
+
+    static void onProbeDisconnect(void *arg, AsyncClient *c)
+    {
+        finish((ProbeSlot *)arg, c, PROBE_FAILED);
+    }
+
+    // -1 = undecided yet, otherwise the pick (or BROKER_PROBE_MAX = nobody)
+    static int8_t decide(const uint8_t *order, uint8_t count, int8_t exclude, bool final)
+    {
+        for (uint8_t k = 0; k < count; k++)
+        {
+            uint8_t i = order[k];
+            ProbeState st = slots[i].state;
+
+            if (st == PROBE_PENDING && !final && i != exclude)
+                return -1; // a higher-priority answer may still come
+
+            if (st == PROBE_ANSWERED && i != exclude)
+                return i;
+        }
+
+        if (exclude >= 0 && exclude < count && slots[exclude].state == PROBE_ANSWERED)
+            return exclude; // the only one alive
+
+        if (!final && exclude >= 0 && exclude < count && slots[exclude].state == PROBE_PENDING)
+            return -1;
+
+        return BROKER_PROBE_MAX;
+    }
+
+    int8_t probeAll(BrokerProbeResult out[BROKER_PROBE_MAX], int8_t exclude)
+    {
+        if (!probeEvents)
+        {
+            probeEvents = xEventGroupCreate();
+            probeMutex = xSemaphoreCreateMutex();
+            if (!probeEvents || !probeMutex)
+                return -1;
+        }
+
+        xSemaphoreTake(probeMutex, portMAX_DELAY);
+
+        uint8_t count = min<uint8_t>(mqttPriorityCount, BROKER_PROBE_MAX);
+        xEventGroupClearBits(probeEvents, 0xFF);
+
+        for (uint8_t i = 0; i < count; i++)
+        {
+            ProbeSlot &s = slots[i];
+            IPAddress ip;
+
+            s.index = i;
+            s.rttMs = 0;
+            s.state = PROBE_FAILED;
+
+            if (!ip.fromString(mqttPriorityList[i]) || ip == IPAddress(0, 0, 0, 0))
+                continue;
+
+            if (!s.client)
+            {
+                s.client = new AsyncClient();
+                if (!s.client)
+                    continue;
+
+                s.client->onConnect(onProbeConnect, &s);
+                s.client->onError(onProbeError, &s);
+                s.client->onDisconnect(onProbeDisconnect, &s);
+            }
+
+            s.client->close(true); // leftover from an earlier round, if any
+
+            portENTER_CRITICAL(&probeMux);
+            s.startMs = millis();
+            s.state = PROBE_PENDING;
+            portEXIT_CRITICAL(&probeMux);
+
+            if (!s.client->connect(ip, mqtt_port))
+            {
+                // Never reached lwIP — no callbacks will come
+                portENTER_CRITICAL(&probeMux);
+                s.state = PROBE_FAILED;
+                portEXIT_CRITICAL(&probeMux);
+            }
+        }
+
+        uint8_t order[BROKER_PROBE_MAX];
+        uint8_t ranked = SmartCore_BrokerHealth::rank(order);
+
+        uint32_t start = millis();
+        int8_t pick;
+
+        while ((pick = decide(order, ranked, exclude, false)) < 0)
+        {
+            uint32_t elapsed = millis() - start;
+            if (elapsed >= BROKER_PROBE_TIMEOUT_MS)
+            {
+                pick = decide(order, ranked, exclude, true);
+                break;
+            }
+
+            xEventGroupWaitBits(probeEvents, 0xFF, pdTRUE, pdFALSE,
+                                pdMS_TO_TICKS(BROKER_PROBE_TIMEOUT_MS - elapsed));
+        }
+
+        // Abandon whatever is still in flight
+        String summary;
+        for (uint8_t i = 0; i < BROKER_PROBE_MAX; i++)
+        {
+            bool abandon = false;
+            bool answered = false;
+            uint16_t rtt = 0;
+
+            if (i < count)
+            {
+                portENTER_CRITICAL(&probeMux);
+                if (slots[i].state == PROBE_PENDING)
+                {
+                    slots[i].state = PROBE_FAILED;
+                    abandon = true;
+                }
+                answered = slots[i].state == PROBE_ANSWERED;
+                rtt = slots[i].rttMs;
+                portEXIT_CRITICAL(&probeMux);
+
+                if (abandon)
+                    slots[i].client->close(true);
+
+                summary += " " + String(i) + ":" + (answered ? String(rtt) + "ms" : String("—"));
+            }
+
+            out[i].answered = answered;
+            out[i].rttMs = rtt;
+        }
+
+        xSemaphoreGive(probeMutex);
+
+        for (uint8_t i = 0; i < count; i++)
+            SmartCore_BrokerHealth::recordProbe(i, out[i].answered, out[i].rttMs);
+
+        if (pick >= BROKER_PROBE_MAX)
+            pick = -1;
+
+        logMessage(pick >= 0 ? LOG_INFO : LOG_WARN,
+                   "📡 Broker probe" + summary + " → " + (pick >= 0 ? "priority " + String(pick) : String("none")) +
+                       " (" + String(millis() - start) + " ms)");
+
+        return pick;
+    }
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <Arduino.h>
+
+#ifndef BROKER_PROBE_TIMEOUT_MS
+#define BROKER_PROBE_TIMEOUT_MS 1500 // one probe round never takes longer than this
+#endif
+#define BROKER_PROBE_MAX 3           // == size of mqttPriorityList
+
+struct BrokerProbeResult
+{
+    bool answered; // TCP handshake to the broker port completed
+    uint16_t rttMs;
+};
+
+namespace SmartCore_BrokerProbe
+{
+    // Open a TCP connection to every configured broker at once and wait for the
+    // answers (at most BROKER_PROBE_TIMEOUT_MS). Returns the best-ranked index
+    // (SmartCore_BrokerHealth::rank) that answered, skipping `exclude` unless it is
+    // the only one, or -1.
+    // Blocks the caller only — safe from any task except the AsyncTCP task.
+    int8_t probeAll(BrokerProbeResult out[BROKER_PROBE_MAX], int8_t exclude = -1);
+}
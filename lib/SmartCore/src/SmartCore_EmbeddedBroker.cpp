@@ -0,0 +1,851 @@
+#include "SmartCore_EmbeddedBroker.h"
+#include <AsyncTCP.h>
+#include "SmartCore_Log.h"
+
+#ifdef SMARTBOX_BUILD
+
+namespace SmartCore_EmbeddedBroker
+{
+    // ======================================================================================
+    //  EMBEDDED MQTT BROKER (last resort)
+    // ======================================================================================
+    //
+    //  Started by SmartCore_Fallback on the SmartBox that wins the election when no
+    //  broker of mqttPriorityList answers. Just enough MQTT 3.1.1 to keep local
+    //  control and alarms flowing between modules on the same WiFi:
+    //
+    //      CONNECT / CONNACK        clean sessions only (sessionPresent is always 0),
+    //                               will messages, client-id takeover
+    //      PUBLISH  QoS 0 / 1       QoS 1 is PUBACKed; QoS 2 closes the connection
+    //      SUBSCRIBE / UNSUBSCRIBE  '+' and '#' filters, granted QoS ≤ 1
+    //      retained messages        stored up to EMB_BROKER_RETAINED_BYTES each
+    //      PINGREQ, DISCONNECT, keepalive (1.5× the client's value)
+    //
+    //  Outgoing QoS 1 deliveries carry a packet id but are not stored for
+    //  retransmission: with clean sessions a lost TCP connection loses them anyway.
+    //  A subscriber whose send buffer is full misses that message (counted in
+    //  EmbeddedBrokerStats::dropped) instead of stalling everybody else.
+    //
+    //  Everything runs on the AsyncTCP task; brokerMutex only guards against
+    //  start()/stop() from other tasks. Fixed tables, no per-message heap except the
+    //  receive buffers and stored retained payloads.
+    //
+    //  AsyncClient::close() runs onDisconnect() synchronously, which takes the lock
+    //  and frees the session. So under the lock a session is only marked closing;
+    //  unlockAndClose() issues the close() calls once the lock is released, and only
+    //  ever from the AsyncTCP task. stop() marks every session and leaves the
+    //  closing to each client's next poll.
+    //
+    // ======================================================================================
+
+    enum : uint8_t
+    {
+        PKT_CONNECT = 1,
+        PKT_CONNACK = 2,
+        PKT_PUBLISH = 3,
+        PKT_PUBACK = 4,
+        PKT_SUBSCRIBE = 8,
+        PKT_SUBACK = 9,
+        PKT_UNSUBSCRIBE = 10,
+        PKT_UNSUBACK = 11,
+        PKT_PINGREQ = 12,
+        PKT_PINGRESP = 13,
+        PKT_DISCONNECT = 14
+    };
+
+    struct Session
+    {
+        AsyncClient *tcp; // nullptr = free slot
+        bool connected;   // CONNECT accepted
+        bool closing;     // marked under the lock
+        bool closeIssued; // close() called (after the lock was released)
+        char id[EMB_BROKER_ID_LEN];
+        uint8_t *rx;
+        size_t rxLen;
+        size_t rxCap;
+        uint16_t keepAliveS;
+        uint32_t openedMs;
+        uint32_t lastRxMs;
+        uint16_t nextPacketId;
+
+        bool hasWill;
+        uint8_t willQos;
+        bool willRetain;
+        char willTopic[EMB_BROKER_TOPIC_LEN];
+        uint8_t *willPayload;
+        uint16_t willLen;
+    };
+
+    struct Subscription
+    {
+        int8_t session; // -1 = free
+        uint8_t qos;
+        char filter[EMB_BROKER_TOPIC_LEN];
+    };
+
+    struct Retained
+    {
+        char topic[EMB_BROKER_TOPIC_LEN]; // "" = free
+        uint8_t *payload;
+        uint16_t len;
+        uint8_t qos;
+    };
+
+    static AsyncServer server(EMB_BROKER_PORT);
+    static SemaphoreHandle_t brokerMutex = nullptr;
+    static volatile bool isRunning = false;
+    static bool serverHooked = false;
+
+    static Session sessions[EMB_BROKER_MAX_CLIENTS];
+    static Subscription subs[EMB_BROKER_MAX_SUBS];
+    static Retained retained[EMB_BROKER_MAX_RETAINED];
+    static EmbeddedBrokerStats stats;
+
+    static void lock() { xSemaphoreTake(brokerMutex, portMAX_DELAY); }
+    static void unlock() { xSemaphoreGive(brokerMutex); }
+
+    // ---------------------------------------------------------------------------------
+    //  Encoding helpers
+    // ---------------------------------------------------------------------------------
+
+    static size_t encodeLength(uint8_t *out, size_t len)
+    {
+        size_t n = 0;
+        do
+        {
+            uint8_t b = len % 128;
+            len /= 128;
+            out[n++] = len ? (b | 0x80) : b;
+        } while (len && n < 4);
+        return n;
+    }
+
+    // Length-prefixed UTF-8 string → NUL-terminated copy. False if malformed or too long.
+    static bool readString(const uint8_t *&p, const uint8_t *end, char *out, size_t outLen)
+    {
+        if (end - p < 2)
+            return false;
+
+        size_t n = (p[0] << 8) | p[1];
+        p += 2;
+        if ((size_t)(end - p) < n || n >= outLen)
+            return false;
+
+        memcpy(out, p, n);
+        out[n] = '\0';
+        p += n;
+        return true;
+    }
+
+    static bool topicMatches(const char *filter, const char *topic)
+    {
+        if (topic[0] == '$' && (filter[0] == '+' || filter[0] == '#'))
+            return false;
+
+        while (*filter)
+        {
+            if (*filter == '#')
+                return true;
+
+            if (*filter == '+')
+            {
+                while (*topic && *topic != '/')
+                    topic++;
+                filter++;
+                continue;
+            }
+
+            if (*filter != *topic)
+            {
+                // "a/#" also matches "a"
+                return *topic == '\0' && filter[0] == '/' && filter[1] == '#' && filter[2] == '\0';
+            }
+
+            filter++;
+            topic++;
+        }
+
+        return *topic == '\0';
+    }
+
+    static bool validFilter(const char *f)
+    {
+        for (const char *c = f; *c; c++)
+        {
+            if (*c == '#' && (c[1] != '\0' || (c != f && c[-1] != '/')))
+                return false;
+            if (*c == '+' && ((c != f && c[-1] != '/') || (c[1] != '\0' && c[1] != '/')))
+                return false;
+        }
+        return *f != '\0';
+    }
+
+    static bool send(Session &s, const uint8_t *data, size_t len)
+    {
+        if (!s.tcp || s.closing || s.tcp->space() < len)
+            return false;
+
+        s.tcp->add((const char *)data, len);
+        s.tcp->send();
+        return true;
+    }
+
+    // Marks only — see unlockAndClose()
+    static void closeSession(Session &s)
+    {
+        if (s.tcp)
+            s.closing = true;
+    }
+
+    // Releases brokerMutex, then closes every session marked closing. AsyncTCP task only;
+    // neither a session nor its client may be touched after this returns.
+    static void unlockAndClose()
+    {
+        AsyncClient *doomed[EMB_BROKER_MAX_CLIENTS];
+        uint8_t n = 0;
+
+        for (uint8_t i = 0; i < EMB_BROKER_MAX_CLIENTS; i++)
+        {
+            Session &s = sessions[i];
+            if (s.tcp && s.closing && !s.closeIssued)
+            {
+                s.closeIssued = true;
+                doomed[n++] = s.tcp;
+            }
+        }
+
+        unlock();
+
+        for (uint8_t i = 0; i < n; i++)
+            doomed[i]->close(); // → onDisconnect(), which takes the lock itself
+    }
+
+    static bool sendPublish(Session &s, const char *topic, const uint8_t *payload, size_t len,
+                            uint8_t qos, bool retain)
+    {
+        size_t topicLen = strlen(topic);
+        size_t remaining = 2 + topicLen + (qos ? 2 : 0) + len;
+
+        uint8_t header[5 + 2 + EMB_BROKER_TOPIC_LEN + 2];
+        size_t h = 0;
+        header[h++] = (PKT_PUBLISH << 4) | (qos << 1) | (retain ? 1 : 0);
+        h += encodeLength(header + h, remaining);
+        header[h++] = topicLen >> 8;
+        header[h++] = topicLen & 0xFF;
+        memcpy(header + h, topic, topicLen);
+        h += topicLen;
+
+        if (qos)
+        {
+            if (++s.nextPacketId == 0)
+                s.nextPacketId = 1;
+            header[h++] = s.nextPacketId >> 8;
+            header[h++] = s.nextPacketId & 0xFF;
+        }
+
+        if (!s.tcp || s.closing || s.tcp->space() < h + len)
+        {
+            stats.dropped++;
+            return false;
+        }
+
+        s.tcp->add((const char *)header, h);
+        if (len)
+            s.tcp->add((const char *)payload, len);
+        s.tcp->send();
+
+        stats.delivered++;
+        return true;
+    }
+
+    // ---------------------------------------------------------------------------------
+    //  Routing
+    // ---------------------------------------------------------------------------------
+
+    static void storeRetained(const char *topic, const uint8_t *payload, size_t len, uint8_t qos)
+    {
+        Retained *slot = nullptr;
+        Retained *empty = nullptr;
+
+        for (uint8_t i = 0; i < EMB_BROKER_MAX_RETAINED; i++)
+        {
+            if (retained[i].topic[0] == '\0')
+            {
+                if (!empty)
+                    empty = &retained[i];
+            }
+            else if (!strcmp(retained[i].topic, topic))
+            {
+                slot = &retained[i];
+                break;
+            }
+        }
+
+        // Empty payload (or one we can't keep) clears the topic
+        if (slot && (len == 0 || len > EMB_BROKER_RETAINED_BYTES))
+        {
+            free(slot->payload);
+            memset(slot, 0, sizeof(*slot));
+            stats.retained--;
+            return;
+        }
+        if (len == 0 || len > EMB_BROKER_RETAINED_BYTES)
+            return;
+
+        if (!slot)
+        {
+            if (!empty)
+                return; // table full — still delivered live
+            slot = empty;
+            strlcpy(slot->topic, topic, sizeof(slot->topic));
+            stats.retained++;
+        }
+
+        uint8_t *copy = (uint8_t *)realloc(slot->payload, len);
+        if (!copy)
+        {
+            free(slot->payload);
+            memset(slot, 0, sizeof(*slot));
+            stats.retained--;
+            return;
+        }
+
+        memcpy(copy, payload, len);
+        slot->payload = copy;
+        slot->len = len;
+        slot->qos = qos;
+    }
+
+    static void route(const char *topic, const uint8_t *payload, size_t len, uint8_t qos, bool retain)
+    {
+        if (retain)
+            storeRetained(topic, payload, len, qos);
+
+        // Once per session, at the highest QoS any of its matching filters granted
+        for (uint8_t i = 0; i < EMB_BROKER_MAX_CLIENTS; i++)
+        {
+            if (!sessions[i].connected || sessions[i].closing)
+                continue;
+
+            int8_t granted = -1;
+            for (uint8_t k = 0; k < EMB_BROKER_MAX_SUBS; k++)
+            {
+                if (subs[k].session == i && (int8_t)subs[k].qos > granted &&
+                    topicMatches(subs[k].filter, topic))
+                    granted = subs[k].qos;
+            }
+
+            if (granted >= 0)
+                sendPublish(sessions[i], topic, payload, len, min<uint8_t>(qos, granted), false);
+        }
+    }
+
+    static void dropSubscriptions(int8_t session)
+    {
+        for (uint8_t k = 0; k < EMB_BROKER_MAX_SUBS; k++)
+        {
+            if (subs[k].session == session)
+                subs[k].session = -1;
+        }
+    }
+
+    // ---------------------------------------------------------------------------------
+    //  Packet handlers (false = protocol error → close)
+    // ---------------------------------------------------------------------------------
+
+    static bool handleConnect(Session &s, int8_t self, const uint8_t *p, const uint8_t *end)
+    {
+        char proto[8];
+        if (!readString(p, end, proto, sizeof(proto)) || end - p < 4)
+            return false;
+
+        uint8_t level = p[0];
+        uint8_t flags = p[1];
+        s.keepAliveS = (p[2] << 8) | p[3];
+        p += 4;
+
+        if (strcmp(proto, "MQTT") != 0 || level != 4)
+        {
+            static const uint8_t refused[] = {PKT_CONNACK << 4, 2, 0, 1}; // bad protocol version
+            send(s, refused, sizeof(refused));
+            return false;
+        }
+
+        if (!readString(p, end, s.id, sizeof(s.id)))
+            return false;
+        if (s.id[0] == '\0')
+            snprintf(s.id, sizeof(s.id), "anon-%u", (unsigned)self);
+
+        if (flags & 0x04)
+        {
+            if (!readString(p, end, s.willTopic, sizeof(s.willTopic)) || end - p < 2)
+                return false;
+
+            size_t n = (p[0] << 8) | p[1];
+            p += 2;
+            if ((size_t)(end - p) < n)
+                return false;
+
+            s.willPayload = n ? (uint8_t *)malloc(n) : nullptr;
+            if (n && !s.willPayload)
+                return false;
+            memcpy(s.willPayload, p, n);
+            s.willLen = n;
+            s.willQos = min<uint8_t>((flags >> 3) & 0x03, 1);
+            s.willRetain = flags & 0x20;
+            s.hasWill = true;
+        }
+        // Username / password are not checked on the fallback broker
+
+        // Same client id already connected → the new connection takes over
+        for (uint8_t i = 0; i < EMB_BROKER_MAX_CLIENTS; i++)
+        {
+            Session &o = sessions[i];
+            if (i != self && o.connected && !strcmp(o.id, s.id))
+            {
+                o.hasWill = false; // it's the same device — no "offline" after it reconnected
+                o.connected = false;
+                dropSubscriptions(i);
+                stats.clients--;
+                closeSession(o);
+            }
+        }
+
+        static const uint8_t accepted[] = {PKT_CONNACK << 4, 2, 0, 0};
+        send(s, accepted, sizeof(accepted));
+
+        s.connected = true;
+        stats.clients++;
+        return true;
+    }
+
+    static bool handlePublish(Session &s, uint8_t flags, const uint8_t *p, const uint8_t *end)
+    {
+        uint8_t qos = (flags >> 1) & 0x03;
+        bool retain = flags & 0x01;
+
+        char topic[EMB_BROKER_TOPIC_LEN];
+        bool topicOk = readString(p, end, topic, sizeof(topic));
+        if (!topicOk || qos > 1 || strpbrk(topic, "+#"))
+            return false;
+
+        if (qos)
+        {
+            if (end - p < 2)
+                return false;
+
+            uint8_t ack[] = {PKT_PUBACK << 4, 2, p[0], p[1]};
+            p += 2;
+            send(s, ack, sizeof(ack));
+        }
+
+        stats.published++;
+        route(topic, p, end - p, qos, retain);
+        return true;
+    }
+
+    static bool handleSubscribe(Session &s, int8_t self, const uint8_t *p, const uint8_t *end)
+    {
+        if (end - p < 2)
+            return false;
+
+        // AsyncMqttClient sends one filter per SUBSCRIBE; a few more are accepted
+        constexpr uint8_t MAX_FILTERS = 8;
+
+        uint8_t ack[4 + 2 + MAX_FILTERS];
+        uint8_t codes[MAX_FILTERS];
+        uint8_t count = 0;
+        uint16_t packetId = (p[0] << 8) | p[1];
+        p += 2;
+
+        char filters[MAX_FILTERS][EMB_BROKER_TOPIC_LEN];
+
+        while (p < end && count < MAX_FILTERS)
+        {
+            char *filter = filters[count];
+            if (!readString(p, end, filter, EMB_BROKER_TOPIC_LEN))
+                return false;
+            if (p >= end)
+                return false;
+
+            uint8_t qos = min<uint8_t>(*p++ & 0x03, 1);
+            uint8_t code = 0x80;
+
+            if (validFilter(filter))
+            {
+                int8_t slot = -1;
+                for (uint8_t k = 0; k < EMB_BROKER_MAX_SUBS; k++)
+                {
+                    if (subs[k].session == self && !strcmp(subs[k].filter, filter))
+                    {
+                        slot = k; // re-subscribe replaces the QoS
+                        break;
+                    }
+                    if (slot < 0 && subs[k].session < 0)
+                        slot = k;
+                }
+
+                if (slot >= 0)
+                {
+                    subs[slot].session = self;
+                    subs[slot].qos = qos;
+                    strlcpy(subs[slot].filter, filter, sizeof(subs[slot].filter));
+                    code = qos;
+                }
+            }
+
+            codes[count++] = code;
+        }
+
+        if (count == 0)
+            return false;
+
+        size_t h = 0;
+        ack[h++] = PKT_SUBACK << 4;
+        h += encodeLength(ack + h, 2 + count);
+        ack[h++] = packetId >> 8;
+        ack[h++] = packetId & 0xFF;
+        memcpy(ack + h, codes, count);
+        send(s, ack, h + count);
+
+        // Retained messages for every filter just granted
+        for (uint8_t f = 0; f < count; f++)
+        {
+            if (codes[f] == 0x80)
+                continue;
+
+            for (uint8_t i = 0; i < EMB_BROKER_MAX_RETAINED; i++)
+            {
+                Retained &r = retained[i];
+                if (r.topic[0] && topicMatches(filters[f], r.topic))
+                    sendPublish(s, r.topic, r.payload, r.len, min<uint8_t>(r.qos, codes[f]), true);
+            }
+        }
+        return true;
+    }
+
+    static bool handleUnsubscribe(Session &s, int8_t self, const uint8_t *p, const uint8_t *end)
+    {
+        if (end - p < 2)
+            return false;
+
+        uint8_t ack[] = {PKT_UNSUBACK << 4, 2, p[0], p[1]};
+        p += 2;
+
+        char filter[EMB_BROKER_TOPIC_LEN];
+        while (p < end)
+        {
+            if (!readString(p, end, filter, sizeof(filter)))
+                return false;
+
+            for (uint8_t k = 0; k < EMB_BROKER_MAX_SUBS; k++)
+            {
+                if (subs[k].session == self && !strcmp(subs[k].filter, filter))
+                    subs[k].session = -1;
+            }
+        }
+
+        send(s, ack, sizeof(ack));
+        return true;
+    }
+
+    static bool handlePacket(Session &s, int8_t self, uint8_t b0, const uint8_t *p, size_t len)
+    {
+        uint8_t type = b0 >> 4;
+        const uint8_t *end = p + len;
+
+        if (!s.connected && type != PKT_CONNECT)
+            return false;
+
+        switch (type)
+        {
+        case PKT_CONNECT:
+            return !s.connected && handleConnect(s, self, p, end);
+
+        case PKT_PUBLISH:
+            return handlePublish(s, b0 & 0x0F, p, end);
+
+        case PKT_PUBACK:
+            return true; // deliveries are not retransmitted — nothing to release
+
+        case PKT_SUBSCRIBE:
+            return (b0 & 0x0F) == 0x02 && handleSubscribe(s, self, p, end);
+
+        case PKT_UNSUBSCRIBE:
+            return (b0 & 0x0F) == 0x02 && handleUnsubscribe(s, self, p, end);
+
+        case PKT_PINGREQ:
+        {
+            static const uint8_t pong[] = {PKT_PINGRESP << 4, 0};
+            send(s, pong, sizeof(pong));
+            return true;
+        }
+
+        case PKT_DISCONNECT:
+            s.hasWill = false; // clean goodbye
+            closeSession(s);
+            return true;
+
+        default:
+            return false;
+        }
+    }
+
+    // ---------------------------------------------------------------------------------
+    //  AsyncTCP callbacks
+    // ---------------------------------------------------------------------------------
+
+    static void releaseSession(Session &s)
+    {
+        free(s.rx);
+        free(s.willPayload);
+        memset(&s, 0, sizeof(s));
+    }
+
+    static void onData(void *arg, AsyncClient *c, void *data, size_t len)
+    {
+        Session &s = *(Session *)arg;
+        int8_t self = &s - sessions;
+
+        lock();
+
+        if (s.closing)
+        {
+            unlockAndClose();
+            return;
+        }
+
+        s.lastRxMs = millis();
+
+        // Append (receive buffer grows up to one maximum packet)
+        if (s.rxLen + len > s.rxCap)
+        {
+            size_t cap = max<size_t>(s.rxCap ? s.rxCap * 2 : 256, s.rxLen + len);
+            uint8_t *grown = cap <= EMB_BROKER_MAX_PACKET + 5 ? (uint8_t *)realloc(s.rx, cap) : nullptr;
+            if (!grown)
+            {
+                stats.protocolErrors++;
+                closeSession(s);
+                unlockAndClose();
+                return;
+            }
+            s.rx = grown;
+            s.rxCap = cap;
+        }
+
+        memcpy(s.rx + s.rxLen, data, len);
+        s.rxLen += len;
+
+        // Every complete packet in the buffer
+        size_t pos = 0;
+        while (!s.closing && s.rxLen - pos >= 2)
+        {
+            size_t remaining = 0;
+            size_t lenBytes = 0;
+            bool complete = false;
+
+            for (size_t i = 0; i < 4 && pos + 1 + i < s.rxLen; i++)
+            {
+                uint8_t b = s.rx[pos + 1 + i];
+                remaining |= (size_t)(b & 0x7F) << (7 * i);
+                lenBytes++;
+                if (!(b & 0x80))
+                {
+                    complete = true;
+                    break;
+                }
+            }
+
+            if (!complete)
+            {
+                if (lenBytes == 4)
+                {
+                    stats.protocolErrors++;
+                    closeSession(s); // malformed length
+                }
+                break;
+            }
+
+            if (remaining > EMB_BROKER_MAX_PACKET)
+            {
+                stats.protocolErrors++;
+                closeSession(s);
+                break;
+            }
+
+            size_t total = 1 + lenBytes + remaining;
+            if (s.rxLen - pos < total)
+                break;
+
+            if (!handlePacket(s, self, s.rx[pos], s.rx + pos + 1 + lenBytes, remaining))
+            {
+                stats.protocolErrors++;
+                closeSession(s);
+            }
+            pos += total;
+        }
+
+        if (pos)
+        {
+            s.rxLen = pos < s.rxLen ? s.rxLen - pos : 0;
+            memmove(s.rx, s.rx + pos, s.rxLen);
+        }
+
+        unlockAndClose(); // s and c may be gone after this
+    }
+
+    static void onDisconnect(void *arg, AsyncClient *c)
+    {
+        Session &s = *(Session *)arg;
+        int8_t self = &s - sessions;
+
+        lock();
+
+        // The slot belongs to this client until released here; never free it twice
+        if (s.tcp == c)
+        {
+            if (s.connected)
+            {
+                s.connected = false;
+                stats.clients--;
+                dropSubscriptions(self);
+
+                if (s.hasWill && isRunning)
+                    route(s.willTopic, s.willPayload, s.willLen, s.willQos, s.willRetain);
+            }
+
+            releaseSession(s);
+        }
+
+        unlock();
+
+        delete c;
+    }
+
+    static void onPoll(void *arg, AsyncClient *c)
+    {
+        Session &s = *(Session *)arg;
+        uint32_t now = millis();
+
+        lock();
+        if (!s.connected && now - s.openedMs > EMB_BROKER_CONNECT_TIMEOUT_MS)
+            closeSession(s);
+        else if (s.connected && s.keepAliveS && now - s.lastRxMs > s.keepAliveS * 1500UL)
+            closeSession(s);
+        unlockAndClose(); // also picks up sessions marked by stop()
+    }
+
+    static void onRejectedDisconnect(void *, AsyncClient *c)
+    {
+        delete c;
+    }
+
+    static void onClient(void *, AsyncClient *c)
+    {
+        lock();
+
+        Session *s = nullptr;
+        for (uint8_t i = 0; i < EMB_BROKER_MAX_CLIENTS && !s; i++)
+        {
+            if (!sessions[i].tcp)
+                s = &sessions[i];
+        }
+
+        if (!s || !isRunning)
+        {
+            stats.rejected++;
+            unlock();
+            c->onDisconnect(onRejectedDisconnect, nullptr);
+            c->close(true);
+            return;
+        }
+
+        memset(s, 0, sizeof(*s));
+        s->tcp = c;
+        s->openedMs = millis();
+        s->lastRxMs = s->openedMs;
+        stats.accepted++;
+
+        c->setNoDelay(true);
+        c->onData(onData, s);
+        c->onDisconnect(onDisconnect, s);
+        c->onPoll(onPoll, s);
+
+        unlock();
+    }
+
+    // ---------------------------------------------------------------------------------
+    //  Public API
+    // ---------------------------------------------------------------------------------
+
+    bool start()
+    {
+        if (isRunning)
+            return true;
+
+        if (!brokerMutex)
+        {
+            brokerMutex = xSemaphoreCreateMutex();
+            for (uint8_t k = 0; k < EMB_BROKER_MAX_SUBS; k++)
+                subs[k].session = -1;
+        }
+
+        if (!serverHooked)
+        {
+            server.onClient(onClient, nullptr);
+            server.setNoDelay(true);
+            serverHooked = true;
+        }
+
+        isRunning = true;
+        server.begin();
+
+        logMessage(LOG_WARN, "🛟 Embedded MQTT broker listening on port " + String(EMB_BROKER_PORT));
+        return true;
+    }
+
+    void stop()
+    {
+        if (!isRunning)
+            return;
+
+        isRunning = false;
+        server.end();
+
+        lock();
+
+        // Closed from each client's next onPoll() on the AsyncTCP task, not from here
+        for (uint8_t i = 0; i < EMB_BROKER_MAX_CLIENTS; i++)
+        {
+            sessions[i].hasWill = false; // the broker is leaving, not the module
+            closeSession(sessions[i]);
+        }
+
+        for (uint8_t i = 0; i < EMB_BROKER_MAX_RETAINED; i++)
+        {
+            free(retained[i].payload);
+            memset(&retained[i], 0, sizeof(retained[i]));
+        }
+        stats.retained = 0;
+
+        unlock();
+
+        logMessage(LOG_INFO, "🛟 Embedded MQTT broker stopped");
+    }
+
+    bool running()
+    {
+        return isRunning;
+    }
+
+    void getStats(EmbeddedBrokerStats &out)
+    {
+        if (brokerMutex)
+            lock();
+        out = stats;
+        if (brokerMutex)
+            unlock();
+    }
+}
+
+#endif // SMARTBOX_BUILD
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Embedded last-resort MQTT 3.1.1 broker (SMARTBOX_BUILD only; override externally if needed)
+#ifndef EMB_BROKER_PORT
+#define EMB_BROKER_PORT 1884 // not 1883: must never be mistaken for a priority-list broker
+#endif
+#ifndef EMB_BROKER_MAX_CLIENTS
+#define EMB_BROKER_MAX_CLIENTS 12
+#endif
+#ifndef EMB_BROKER_MAX_SUBS
+#define EMB_BROKER_MAX_SUBS 48
+#endif
+#ifndef EMB_BROKER_MAX_RETAINED
+#define EMB_BROKER_MAX_RETAINED 48
+#endif
+#ifndef EMB_BROKER_MAX_PACKET
+#define EMB_BROKER_MAX_PACKET 4096 // larger packets close the connection
+#endif
+#define EMB_BROKER_RETAINED_BYTES 512 // larger retained payloads are forwarded, not stored
+#define EMB_BROKER_TOPIC_LEN 64
+#define EMB_BROKER_ID_LEN 24
+#define EMB_BROKER_CONNECT_TIMEOUT_MS 10000
+
+struct EmbeddedBrokerStats
+{
+    uint32_t accepted;     // TCP connections taken
+    uint32_t rejected;     // ...turned away (client table full)
+    uint32_t published;    // PUBLISH packets received
+    uint32_t delivered;    // PUBLISH packets sent to subscribers
+    uint32_t dropped;      // deliveries skipped (subscriber's send buffer full)
+    uint32_t protocolErrors;
+    uint8_t clients;       // CONNECT accepted, currently connected
+    uint8_t retained;
+};
+
+namespace SmartCore_EmbeddedBroker
+{
+    // Start / stop listening on EMB_BROKER_PORT. stop() drops every client and
+    // forgets retained messages.
+    bool start();
+    void stop();
+
+    bool running();
+
+    void getStats(EmbeddedBrokerStats &out);
+}
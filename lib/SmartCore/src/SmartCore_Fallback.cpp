@@ -0,0 +1,283 @@
+#include "SmartCore_Fallback.h"
+#include <WiFi.h>
+#include <AsyncUDP.h>
+#include "SmartCore_EmbeddedBroker.h"
+#include "SmartCore_BrokerProbe.h"
+#include "SmartCore_Log.h"
+
+namespace SmartCore_Fallback
+{
+    TaskHandle_t fallbackTaskHandle = NULL;
+
+    // ======================================================================================
+    //  LAST-RESORT BROKER ELECTION
+    // ======================================================================================
+    //
+    //  When every broker of mqttPriorityList is down, modules on the same WiFi can
+    //  still reach each other. SmartBox builds carry an embedded broker
+    //  (SmartCore_EmbeddedBroker); exactly one of them should run it. UDP broadcast
+    //  beacons on FALLBACK_UDP_PORT decide which:
+    //
+    //      "SBFB1 CAND <mac>"                  candidate (SmartBox in total outage)
+    //      "SBFB1 LEAD <mac> <ip> <port>"      running the fallback broker
+    //
+    //  SmartBox, on onTotalOutage():
+    //      leader already announced → follow it
+    //      else CANDIDATE: send CAND every second for FALLBACK_ELECTION_MS, then
+    //           lowest MAC heard == ours → start broker, LEADING
+    //           otherwise → idle (the winner announces itself)
+    //      LEADING: LEAD every FALLBACK_BEACON_MS; step down when a lower-MAC leader
+    //           shows up (split brain) or a priority-list broker answers again
+    //           (probed every FALLBACK_RECHECK_MS) — modules then fail back as usual.
+    //
+    //  Every build listens for LEAD beacons; handleMQTTFailover() uses the announced
+    //  broker as its last-resort entry when no priority-list broker answered.
+    //  A running leader is never displaced by a late candidate.
+    //
+    // ======================================================================================
+
+    static AsyncUDP udp;
+    static bool listening = false;
+    static portMUX_TYPE fbMux = portMUX_INITIALIZER_UNLOCKED;
+
+    static uint64_t ownMac = 0;
+
+    static char leaderIp[16];
+    static uint16_t leaderPort = 0;
+    static uint64_t leaderMac = 0;
+    static uint32_t leaderSeenMs = 0;
+
+    static uint64_t lowestCandidate = 0; // during our own election
+    static volatile bool isLeading = false;
+
+    static uint64_t readMac()
+    {
+        uint8_t mac[6];
+        WiFi.macAddress(mac);
+
+        uint64_t v = 0;
+        for (uint8_t i = 0; i < 6; i++)
+            v = (v << 8) | mac[i];
+        return v;
+    }
+
+    // Caller holds fbMux
+    static bool leaderFresh(uint32_t now)
+    {
+        return leaderMac != 0 && now - leaderSeenMs < FALLBACK_LEADER_TTL_MS;
+    }
+
+    static void onBeacon(AsyncUDPPacket &packet)
+    {
+        char msg[64];
+        size_t n = min<size_t>(packet.length(), sizeof(msg) - 1);
+        memcpy(msg, packet.data(), n);
+        msg[n] = '\0';
+
+        char type[5];
+        char macHex[13];
+        char ip[16];
+        unsigned port = 0;
+
+        int fields = sscanf(msg, "SBFB1 %4s %12s %15s %u", type, macHex, ip, &port);
+        if (fields < 2)
+            return;
+
+        uint64_t mac = strtoull(macHex, nullptr, 16);
+        if (mac == 0 || mac == ownMac)
+            return;
+
+        uint32_t now = millis();
+
+        portENTER_CRITICAL(&fbMux);
+        if (!strcmp(type, "LEAD") && fields == 4 && port > 0 && port <= 65535)
+        {
+            // Two leaders (partition healed) → the lower MAC wins everywhere
+            if (!leaderFresh(now) || mac <= leaderMac)
+            {
+                strlcpy(leaderIp, ip, sizeof(leaderIp));
+                leaderPort = port;
+                leaderMac = mac;
+                leaderSeenMs = now;
+            }
+        }
+        else if (!strcmp(type, "CAND"))
+        {
+            if (lowestCandidate == 0 || mac < lowestCandidate)
+                lowestCandidate = mac;
+        }
+        portEXIT_CRITICAL(&fbMux);
+    }
+
+    void init()
+    {
+        if (listening)
+            return;
+
+        ownMac = readMac();
+
+        if (!udp.listen(FALLBACK_UDP_PORT))
+        {
+            logMessage(LOG_WARN, "⚠️ Fallback beacon listener could not start");
+            return;
+        }
+
+        udp.onPacket([](AsyncUDPPacket &packet)
+                     { onBeacon(packet); });
+        listening = true;
+
+#ifdef SMARTBOX_BUILD
+        xTaskCreatePinnedToCore(fallbackTask, "Fallback Elect", 4096, NULL, 1, &fallbackTaskHandle, 0);
+#endif
+    }
+
+    void onTotalOutage()
+    {
+#ifdef SMARTBOX_BUILD
+        if (fallbackTaskHandle && !isLeading)
+            xTaskNotifyGive(fallbackTaskHandle);
+#endif
+    }
+
+    bool leader(String &ip, uint16_t &port)
+    {
+        if (isLeading)
+        {
+            ip = WiFi.localIP().toString();
+            port = EMB_BROKER_PORT;
+            return true;
+        }
+
+        bool fresh = false;
+        char copy[16];
+
+        portENTER_CRITICAL(&fbMux);
+        fresh = leaderFresh(millis());
+        if (fresh)
+        {
+            memcpy(copy, leaderIp, sizeof(copy));
+            port = leaderPort;
+        }
+        portEXIT_CRITICAL(&fbMux);
+
+        if (fresh)
+            ip = copy;
+        return fresh;
+    }
+
+    bool leading()
+    {
+        return isLeading;
+    }
+
+#ifdef SMARTBOX_BUILD
+
+    static void beacon(const char *type)
+    {
+        char msg[64];
+        if (!strcmp(type, "LEAD"))
+            snprintf(msg, sizeof(msg), "SBFB1 LEAD %012llX %s %u", (unsigned long long)ownMac,
+                     WiFi.localIP().toString().c_str(), (unsigned)EMB_BROKER_PORT);
+        else
+            snprintf(msg, sizeof(msg), "SBFB1 %s %012llX", type, (unsigned long long)ownMac);
+
+        udp.broadcastTo(msg, FALLBACK_UDP_PORT);
+    }
+
+    static void stepDown(const char *why)
+    {
+        isLeading = false;
+        SmartCore_EmbeddedBroker::stop();
+        logMessage(LOG_INFO, String("🛟 Fallback broker stepping down — ") + why);
+    }
+
+    void fallbackTask(void *parameter)
+    {
+        for (;;)
+        {
+            // ---- Idle until a failover finds nobody ----
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+            uint32_t now = millis();
+            bool follow;
+
+            portENTER_CRITICAL(&fbMux);
+            follow = leaderFresh(now);
+            lowestCandidate = 0;
+            portEXIT_CRITICAL(&fbMux);
+
+            if (follow || WiFi.status() != WL_CONNECTED)
+                continue;
+
+            // ---- Candidate ----
+            logMessage(LOG_WARN, "🗳️ No MQTT broker reachable — fallback election started");
+
+            uint32_t start = millis();
+            while (millis() - start < FALLBACK_ELECTION_MS && !follow)
+            {
+                beacon("CAND");
+                vTaskDelay(pdMS_TO_TICKS(1000));
+
+                portENTER_CRITICAL(&fbMux);
+                follow = leaderFresh(millis());
+                portEXIT_CRITICAL(&fbMux);
+            }
+
+            uint64_t lowest;
+            portENTER_CRITICAL(&fbMux);
+            lowest = lowestCandidate;
+            portEXIT_CRITICAL(&fbMux);
+
+            if (follow)
+            {
+                logMessage(LOG_INFO, "🗳️ Fallback broker already elected — following it");
+                continue;
+            }
+            if (lowest != 0 && lowest < ownMac)
+            {
+                logMessage(LOG_INFO, "🗳️ Another SmartBox wins the fallback election");
+                continue;
+            }
+
+            // ---- Leader ----
+            if (!SmartCore_EmbeddedBroker::start())
+                continue;
+
+            isLeading = true;
+            logMessage(LOG_WARN, "🛟 Elected fallback MQTT broker (" + WiFi.localIP().toString() +
+                                     ":" + String(EMB_BROKER_PORT) + ")");
+
+            uint32_t lastRecheck = millis();
+
+            while (isLeading)
+            {
+                beacon("LEAD");
+                vTaskDelay(pdMS_TO_TICKS(FALLBACK_BEACON_MS));
+
+                bool outranked;
+                portENTER_CRITICAL(&fbMux);
+                outranked = leaderFresh(millis()) && leaderMac < ownMac;
+                portEXIT_CRITICAL(&fbMux);
+
+                if (outranked)
+                {
+                    stepDown("another SmartBox leads");
+                    break;
+                }
+
+                if (WiFi.status() == WL_CONNECTED && millis() - lastRecheck >= FALLBACK_RECHECK_MS)
+                {
+                    lastRecheck = millis();
+
+                    BrokerProbeResult probe[BROKER_PROBE_MAX];
+                    if (SmartCore_BrokerProbe::probeAll(probe) >= 0)
+                        stepDown("a priority broker is back");
+                }
+            }
+
+            ulTaskNotifyTake(pdTRUE, 0); // outages reported while leading are stale
+        }
+    }
+
+#endif // SMARTBOX_BUILD
+}
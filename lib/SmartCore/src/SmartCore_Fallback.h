@@ -0,0 +1,32 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Last-resort broker election (override externally if needed)
+#ifndef FALLBACK_UDP_PORT
+#define FALLBACK_UDP_PORT 47883
+#endif
+#define FALLBACK_BEACON_MS 2000     // leader announcement interval
+#define FALLBACK_LEADER_TTL_MS 7000 // no announcement for this long → no leader
+#define FALLBACK_ELECTION_MS 5000   // candidates listen this long before deciding
+#define FALLBACK_RECHECK_MS 30000   // leader checks whether a real broker is back
+
+namespace SmartCore_Fallback
+{
+    extern TaskHandle_t fallbackTaskHandle; // SMARTBOX_BUILD only
+
+    // Beacon listener (every build) + election task (SMARTBOX_BUILD); idempotent
+    void init();
+
+    // Failover found no broker of mqttPriorityList answering. A SmartBox joins /
+    // starts an election; other builds only listen.
+    void onTotalOutage();
+
+    // Elected fallback broker, if one announced itself within FALLBACK_LEADER_TTL_MS
+    bool leader(String &ip, uint16_t &port);
+
+    // This node runs the fallback broker
+    bool leading();
+
+    void fallbackTask(void *parameter);
+}
@@ -0,0 +1,257 @@
+#include "SmartCore_Gorilla.h"
+#include <string.h>
+
+namespace SmartCore_Gorilla
+{
+    // ======================================================================================
+    //  BLOCK LAYOUT
+    // ======================================================================================
+    //
+    //   t0 (32 bits) | v0 (32 bits)
+    //   then per sample:
+    //
+    //   Timestamp — delta-of-delta (previous delta starts at 0):
+    //      '0'                      dod == 0
+    //      '10'   + 7 bits          dod in [-64, 63]
+    //      '110'  + 9 bits          dod in [-256, 255]
+    //      '1110' + 12 bits         dod in [-2048, 2047]
+    //      '1111' + 32 bits         anything else
+    //
+    //   Value — XOR with previous float bits:
+    //      '0'                      identical value
+    //      '10'   + meaningful bits fits inside the previous leading/trailing window
+    //      '11'   + 5 bits leading zeros + 5 bits (length - 1) + meaningful bits
+    //
+    //  Regular sampling (our tiers) makes most timestamps a single '0' bit and slowly
+    //  changing sensor values collapse to a handful of bits each.
+    //
+    // ======================================================================================
+
+    struct BitWriter
+    {
+        uint8_t *buf;
+        size_t cap;
+        size_t bitPos;
+        bool overflow;
+
+        void write(uint32_t value, uint8_t bits)
+        {
+            while (bits--)
+            {
+                size_t byte = bitPos >> 3;
+                if (byte >= cap)
+                {
+                    overflow = true;
+                    return;
+                }
+
+                uint8_t mask = 0x80 >> (bitPos & 7);
+                if ((value >> bits) & 1)
+                    buf[byte] |= mask;
+                else
+                    buf[byte] &= ~mask;
+
+                bitPos++;
+            }
+        }
+    };
+
+    struct BitReader
+    {
+        const uint8_t *buf;
+        size_t len;
+        size_t bitPos;
+        bool underflow;
+
+        uint32_t read(uint8_t bits)
+        {
+            uint32_t value = 0;
+            while (bits--)
+            {
+                size_t byte = bitPos >> 3;
+                if (byte >= len)
+                {
+                    underflow = true;
+                    return 0;
+                }
+
+                value = (value << 1) | ((buf[byte] >> (7 - (bitPos & 7))) & 1);
+                bitPos++;
+            }
+            return value;
+        }
+    };
+
+    static inline uint32_t floatBits(float v)
+    {
+        uint32_t bits;
+        memcpy(&bits, &v, sizeof(bits));
+        return bits;
+    }
+
+    static inline float bitsFloat(uint32_t bits)
+    {
+        float v;
+        memcpy(&v, &bits, sizeof(v));
+        return v;
+    }
+
+    static inline int32_t signExtend(uint32_t value, uint8_t bits)
+    {
+        uint32_t sign = 1UL << (bits - 1);
+        return (int32_t)((value ^ sign) - sign);
+    }
+
+    size_t encode(const GorillaSample *samples, uint16_t count, uint8_t *out, size_t cap)
+    {
+        if (count == 0)
+            return 0;
+
+        BitWriter w = {out, cap, 0, false};
+
+        w.write(samples[0].t, 32);
+        w.write(floatBits(samples[0].v), 32);
+
+        uint32_t prevT = samples[0].t;
+        int32_t prevDelta = 0;
+        uint32_t prevBits = floatBits(samples[0].v);
+        uint8_t prevLeading = 0xFF; // no window yet
+        uint8_t prevTrailing = 0;
+
+        for (uint16_t i = 1; i < count && !w.overflow; i++)
+        {
+            // --- timestamp ---
+            int32_t delta = (int32_t)(samples[i].t - prevT);
+            int32_t dod = delta - prevDelta;
+
+            if (dod == 0)
+                w.write(0, 1);
+            else if (dod >= -64 && dod <= 63)
+            {
+                w.write(0x2, 2);
+                w.write((uint32_t)dod & 0x7F, 7);
+            }
+            else if (dod >= -256 && dod <= 255)
+            {
+                w.write(0x6, 3);
+                w.write((uint32_t)dod & 0x1FF, 9);
+            }
+            else if (dod >= -2048 && dod <= 2047)
+            {
+                w.write(0xE, 4);
+                w.write((uint32_t)dod & 0xFFF, 12);
+            }
+            else
+            {
+                w.write(0xF, 4);
+                w.write((uint32_t)dod, 32);
+            }
+
+            prevT = samples[i].t;
+            prevDelta = delta;
+
+            // --- value ---
+            uint32_t bits = floatBits(samples[i].v);
+            uint32_t x = bits ^ prevBits;
+            prevBits = bits;
+
+            if (x == 0)
+            {
+                w.write(0, 1);
+                continue;
+            }
+
+            uint8_t leading = __builtin_clz(x);
+            uint8_t trailing = __builtin_ctz(x);
+            if (leading > 31)
+                leading = 31;
+
+            if (prevLeading != 0xFF && leading >= prevLeading && trailing >= prevTrailing)
+            {
+                uint8_t meaningful = 32 - prevLeading - prevTrailing;
+                w.write(0x2, 2);
+                w.write(x >> prevTrailing, meaningful);
+            }
+            else
+            {
+                uint8_t meaningful = 32 - leading - trailing;
+                w.write(0x3, 2);
+                w.write(leading, 5);
+                w.write(meaningful - 1, 5);
+                w.write(x >> trailing, meaningful);
+
+                prevLeading = leading;
+                prevTrailing = trailing;
+            }
+        }
+
+        if (w.overflow)
+            return 0;
+
+        // Zero the padding bits of the last byte so identical input → identical bytes
+        if (w.bitPos & 7)
+            out[w.bitPos >> 3] &= (uint8_t)(0xFF << (8 - (w.bitPos & 7)));
+
+        return (w.bitPos + 7) >> 3;
+    }
+
+    bool decode(const uint8_t *in, size_t len, uint16_t count, GorillaSample *out)
+    {
+        if (count == 0)
+            return true;
+
+        BitReader r = {in, len, 0, false};
+
+        uint32_t t = r.read(32);
+        uint32_t bits = r.read(32);
+        out[0].t = t;
+        out[0].v = bitsFloat(bits);
+
+        int32_t delta = 0;
+        uint8_t leading = 0;
+        uint8_t trailing = 0;
+
+        for (uint16_t i = 1; i < count; i++)
+        {
+            // --- timestamp ---
+            int32_t dod;
+            if (r.read(1) == 0)
+                dod = 0;
+            else if (r.read(1) == 0)
+                dod = signExtend(r.read(7), 7);
+            else if (r.read(1) == 0)
+                dod = signExtend(r.read(9), 9);
+            else if (r.read(1) == 0)
+                dod = signExtend(r.read(12), 12);
+            else
+                dod = (int32_t)r.read(32);
+
+            delta += dod;
+            t += delta;
+
+            // --- value ---
+            if (r.read(1) == 1)
+            {
+                if (r.read(1) == 1)
+                {
+                    leading = r.read(5);
+                    uint8_t meaningful = r.read(5) + 1;
+                    if (leading + meaningful > 32)
+                        return false;
+                    trailing = 32 - leading - meaningful;
+                }
+
+                uint8_t meaningful = 32 - leading - trailing;
+                bits ^= r.read(meaningful) << trailing;
+            }
+
+            if (r.underflow)
+                return false;
+
+            out[i].t = t;
+            out[i].v = bitsFloat(bits);
+        }
+
+        return !r.underflow;
+    }
+}
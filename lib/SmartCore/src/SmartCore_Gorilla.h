@@ -0,0 +1,28 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Gorilla-style block codec for (timestamp, float) series.
+// Framework-free on purpose: builds for the ESP32 and on a host PC alike.
+
+struct GorillaSample
+{
+    uint32_t t; // seconds
+    float v;
+};
+
+namespace SmartCore_Gorilla
+{
+    // Worst case for one block (first sample 8 bytes, then <= 80 bits per sample)
+    constexpr size_t maxEncodedSize(uint16_t count)
+    {
+        return count == 0 ? 0 : 8 + ((size_t)(count - 1) * 80 + 7) / 8;
+    }
+
+    // Returns encoded length, or 0 if it does not fit in cap
+    size_t encode(const GorillaSample *samples, uint16_t count, uint8_t *out, size_t cap);
+
+    // Decodes exactly count samples; false on truncated/corrupt input
+    bool decode(const uint8_t *in, size_t len, uint16_t count, GorillaSample *out);
+}
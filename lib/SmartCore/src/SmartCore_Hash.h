@@ -0,0 +1,35 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+// 32-bit FNV-1a — the one string / bytes hash used for table lookups and dedup.
+// Framework-free on purpose: the native tests build SmartCore_Backoff with it.
+
+namespace SmartCore_Hash
+{
+    constexpr uint32_t FNV1A_SEED = 2166136261UL;
+    constexpr uint32_t FNV1A_PRIME = 16777619UL;
+
+    // One byte into a running hash (for loops that hash while they scan)
+    inline uint32_t fnv1aStep(uint32_t h, uint8_t b)
+    {
+        return (h ^ b) * FNV1A_PRIME;
+    }
+
+    // NUL-terminated string; pass a previous result as h to continue it
+    inline uint32_t fnv1a(const char *str, uint32_t h = FNV1A_SEED)
+    {
+        while (*str)
+            h = fnv1aStep(h, (uint8_t)*str++);
+        return h;
+    }
+
+    inline uint32_t fnv1aBytes(const void *data, size_t len, uint32_t h = FNV1A_SEED)
+    {
+        const uint8_t *p = (const uint8_t *)data;
+        for (size_t i = 0; i < len; i++)
+            h = fnv1aStep(h, p[i]);
+        return h;
+    }
+}
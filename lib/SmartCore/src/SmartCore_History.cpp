@@ -0,0 +1,784 @@
+#include "SmartCore_History.h"
+#include <ArduinoJson.h>
+#include <LittleFS.h>
+#include <mbedtls/base64.h>
+#include "SmartCore_MQTT.h"
+#include "SmartCore_RPC.h"
+#include "SmartCore_Network.h"
+#include "SmartCore_Time.h"
+#include "SmartCore_Log.h"
+#include "SmartCore_Hash.h"
+
+#define HISTORY_SEGMENT_MAGIC 0x48535431UL // "HST1"
+#define HISTORY_BLOCK_MAGIC 0x4842          // "HB"
+
+#define HISTORY_CODEC_RAW 0
+#define HISTORY_CODEC_GORILLA 1
+
+namespace SmartCore_History
+{
+    TaskHandle_t historyTaskHandle = NULL;
+
+    const HistoryTier tiers[HISTORY_TIER_COUNT] = {
+        {1, 3600},       // 1 s   for 1 hour
+        {60, 86400},     // 1 min for 1 day
+        {600, 2592000},  // 10 min for 30 days
+    };
+
+    struct SegmentHeader
+    {
+        uint32_t magic;
+        uint32_t segStart; // first second covered by this segment
+    };
+
+    struct BlockHeader
+    {
+        uint16_t magic;
+        uint8_t codec;
+        uint8_t reserved;
+        uint16_t count;
+        uint16_t bytes;
+        uint32_t tFirst;
+        uint32_t tLast;
+    };
+
+    struct TierBuffer
+    {
+        // Downsampling accumulator (average over one step)
+        uint32_t bucket;
+        float sum;
+        uint16_t accCount;
+
+        // Pending samples not yet on LittleFS
+        HistorySample samples[HISTORY_BLOCK_SAMPLES];
+        uint8_t count;
+    };
+
+    struct Field
+    {
+        char name[HISTORY_FIELD_LEN];
+        uint32_t hash;
+        TierBuffer tiers[HISTORY_TIER_COUNT];
+    };
+
+    struct HistoryQuery
+    {
+        char reqId[24];
+        char field[HISTORY_FIELD_LEN];
+        uint32_t from;
+        uint32_t to;
+        int8_t tier; // -1 → auto
+        bool packed; // "format": "gorilla"
+    };
+
+    static Field fields[HISTORY_MAX_FIELDS];
+    static uint8_t fieldsLoaded = 0;
+    static SemaphoreHandle_t historyMutex = nullptr;
+    static QueueHandle_t queryQueue = nullptr;
+
+    // Scratch buffers (history task only)
+    static HistorySample flushScratch[HISTORY_BLOCK_SAMPLES];
+    static HistorySample decodeScratch[HISTORY_BLOCK_SAMPLES];
+    static uint8_t blockScratch[HISTORY_BLOCK_SAMPLES * sizeof(HistorySample)];
+
+    static uint32_t hashName(const char *name)
+    {
+        return SmartCore_Hash::fnv1a(name);
+    }
+
+    static int findField(const char *name)
+    {
+        uint32_t hash = hashName(name);
+        for (uint8_t i = 0; i < fieldsLoaded; i++)
+        {
+            if (fields[i].hash == hash && !strcmp(fields[i].name, name))
+                return i;
+        }
+        return -1;
+    }
+
+    static uint32_t segmentSpan(uint8_t tier)
+    {
+        // N-1 full segments always cover the retention window, the N-th is being filled
+        return tiers[tier].retentionSec / (HISTORY_SEGMENTS_PER_TIER - 1);
+    }
+
+    static void segmentPath(char *out, size_t len, const char *field, uint8_t tier, uint8_t slot)
+    {
+        snprintf(out, len, "%s/%s.%u.%u", HISTORY_DIR, field, tier, slot);
+    }
+
+    // ======================================================================================
+    //  BLOCK CODEC
+    // ======================================================================================
+    //
+    //  Blocks are Gorilla-compressed (delta-of-delta timestamps, XOR'd floats). Regular
+    //  steps and slow-moving sensors typically land at 1–2 bytes per sample instead of 8.
+    //  A block that would not shrink (noisy data) is stored raw — the codec byte in the
+    //  block header tells the reader which one it got, so old raw segments stay readable.
+    //
+    // ======================================================================================
+
+    static size_t encodeBlock(const HistorySample *samples, uint16_t count, uint8_t *out, size_t cap, uint8_t &codec)
+    {
+        size_t bytes = count * sizeof(HistorySample);
+        if (bytes > cap)
+            return 0;
+
+        // Never let the compressed form grow past the raw size
+        size_t packed = SmartCore_Gorilla::encode(samples, count, out, bytes - 1);
+        if (packed)
+        {
+            codec = HISTORY_CODEC_GORILLA;
+            return packed;
+        }
+
+        codec = HISTORY_CODEC_RAW;
+        memcpy(out, samples, bytes);
+        return bytes;
+    }
+
+    static bool decodeBlock(const BlockHeader &hdr, const uint8_t *in, HistorySample *out)
+    {
+        switch (hdr.codec)
+        {
+        case HISTORY_CODEC_RAW:
+            if (hdr.bytes != hdr.count * sizeof(HistorySample))
+                return false;
+            memcpy(out, in, hdr.bytes);
+            return true;
+
+        case HISTORY_CODEC_GORILLA:
+            return SmartCore_Gorilla::decode(in, hdr.bytes, hdr.count, out);
+
+        default:
+            return false;
+        }
+    }
+
+    // ======================================================================================
+    //  APPEND PATH
+    // ======================================================================================
+    //
+    //  record()      → averages into the current step of every tier (RAM only)
+    //  step rollover → averaged sample is pushed into the tier's block buffer
+    //  buffer full   → history task writes one block to the tier's current segment file
+    //
+    //  Each field/tier owns a ring of HISTORY_SEGMENTS_PER_TIER files. The slot for a
+    //  timestamp is (t / span) % N; when a slot still holds an older segment it is
+    //  truncated and reused — classic round-robin, so LittleFS usage is bounded.
+    //
+    // ======================================================================================
+
+    static void pushSample(TierBuffer &buf, uint32_t t, float v)
+    {
+        if (buf.count >= HISTORY_BLOCK_SAMPLES)
+        {
+            // History task is behind — drop the oldest pending sample
+            memmove(&buf.samples[0], &buf.samples[1], sizeof(HistorySample) * (HISTORY_BLOCK_SAMPLES - 1));
+            buf.count--;
+        }
+
+        buf.samples[buf.count].t = t;
+        buf.samples[buf.count].v = v;
+        buf.count++;
+    }
+
+    void record(const char *field, float value)
+    {
+        if (!historyMutex || fieldsLoaded == 0)
+            return;
+
+        // Timestamps must share one time base — wait for the SmartBoat clock
+        if (!smartBoatTimeValid())
+            return;
+
+        uint32_t now = getCurrentSmartBoatTime();
+
+        if (xSemaphoreTake(historyMutex, pdMS_TO_TICKS(20)) != pdTRUE)
+            return;
+
+        int idx = findField(field);
+        if (idx >= 0)
+        {
+            for (uint8_t t = 0; t < HISTORY_TIER_COUNT; t++)
+            {
+                TierBuffer &buf = fields[idx].tiers[t];
+                uint32_t bucket = now - (now % tiers[t].stepSec);
+
+                if (buf.accCount && bucket != buf.bucket)
+                {
+                    pushSample(buf, buf.bucket, buf.sum / buf.accCount);
+                    buf.accCount = 0;
+                    buf.sum = 0;
+                }
+
+                if (buf.accCount == 0)
+                    buf.bucket = bucket;
+
+                buf.sum += value;
+                buf.accCount++;
+            }
+        }
+
+        xSemaphoreGive(historyMutex);
+    }
+
+    static bool openSegmentForAppend(File &f, const char *field, uint8_t tier, uint32_t t)
+    {
+        uint32_t span = segmentSpan(tier);
+        uint32_t segStart = t - (t % span);
+        uint8_t slot = (t / span) % HISTORY_SEGMENTS_PER_TIER;
+
+        char path[48];
+        segmentPath(path, sizeof(path), field, tier, slot);
+
+        SegmentHeader hdr = {0, 0};
+        if (LittleFS.exists(path))
+        {
+            File r = LittleFS.open(path, "r");
+            if (r)
+            {
+                r.read((uint8_t *)&hdr, sizeof(hdr));
+                r.close();
+            }
+        }
+
+        if (hdr.magic == HISTORY_SEGMENT_MAGIC && hdr.segStart == segStart)
+        {
+            f = LittleFS.open(path, "a");
+            return (bool)f;
+        }
+
+        // Slot holds an expired segment (or nothing) → start it over
+        f = LittleFS.open(path, "w");
+        if (!f)
+            return false;
+
+        hdr.magic = HISTORY_SEGMENT_MAGIC;
+        hdr.segStart = segStart;
+        f.write((const uint8_t *)&hdr, sizeof(hdr));
+        return true;
+    }
+
+    static void writeBlocks(const char *field, uint8_t tier, const HistorySample *samples, uint16_t count)
+    {
+        uint32_t span = segmentSpan(tier);
+        uint16_t start = 0;
+
+        while (start < count)
+        {
+            // Samples of one block must fall in the same segment
+            uint32_t segStart = samples[start].t - (samples[start].t % span);
+            uint16_t end = start + 1;
+            while (end < count && samples[end].t - (samples[end].t % span) == segStart)
+                end++;
+
+            BlockHeader hdr;
+            memset(&hdr, 0, sizeof(hdr));
+            hdr.magic = HISTORY_BLOCK_MAGIC;
+            hdr.count = end - start;
+            hdr.tFirst = samples[start].t;
+            hdr.tLast = samples[end - 1].t;
+            hdr.bytes = encodeBlock(&samples[start], hdr.count, blockScratch, sizeof(blockScratch), hdr.codec);
+
+            File f;
+            if (hdr.bytes && openSegmentForAppend(f, field, tier, hdr.tFirst))
+            {
+                f.write((const uint8_t *)&hdr, sizeof(hdr));
+                f.write(blockScratch, hdr.bytes);
+                f.close();
+            }
+            else
+            {
+                logMessage(LOG_WARN, String("⚠️ History write failed for ") + field);
+            }
+
+            start = end;
+        }
+    }
+
+    static void flushFields(bool force)
+    {
+        for (uint8_t i = 0; i < fieldsLoaded; i++)
+        {
+            for (uint8_t t = 0; t < HISTORY_TIER_COUNT; t++)
+            {
+                char name[HISTORY_FIELD_LEN];
+                uint16_t count = 0;
+
+                // Copy out under the lock, write outside it
+                if (xSemaphoreTake(historyMutex, pdMS_TO_TICKS(100)) != pdTRUE)
+                    return;
+
+                TierBuffer &buf = fields[i].tiers[t];
+                if (buf.count && (force || buf.count >= HISTORY_BLOCK_SAMPLES))
+                {
+                    count = buf.count;
+                    memcpy(flushScratch, buf.samples, sizeof(HistorySample) * count);
+                    strncpy(name, fields[i].name, sizeof(name));
+                    buf.count = 0;
+                }
+
+                xSemaphoreGive(historyMutex);
+
+                if (count)
+                    writeBlocks(name, t, flushScratch, count);
+            }
+        }
+    }
+
+    void flush()
+    {
+        if (historyMutex)
+            flushFields(true);
+    }
+
+    // ======================================================================================
+    //  RANGE QUERIES
+    // ======================================================================================
+    //
+    //  Request  (<serialNumber>/history):
+    //      { "action": "query", "reqId": "r1", "field": "depth",
+    //        "from": 1718000000, "to": 1718003600, "tier": 0 }      // tier optional
+    //
+    //  Response (module/history), one message per HISTORY_CHUNK_SAMPLES samples:
+    //      { "serialNumber": "...", "reqId": "r1", "field": "depth", "tier": 0,
+    //        "step": 1, "seq": 0, "last": false, "t": [...], "v": [...] }
+    //
+    //  Bulk uploads can ask for "format": "gorilla" — each chunk then carries the same
+    //  block codec used on disk, base64-encoded, instead of the two JSON arrays:
+    //      { ..., "format": "gorilla", "count": 64, "data": "<base64>" }
+    //
+    //  Chunks are published from the history task and paced, so a large backfill never
+    //  runs inside the MQTT callback or floods the TCP send buffer.
+    //
+    // ======================================================================================
+
+    struct ChunkWriter
+    {
+        const HistoryQuery *query;
+        uint8_t tier;
+        HistorySample samples[HISTORY_CHUNK_SAMPLES];
+        uint8_t count;
+        uint16_t seq;
+        uint32_t total;
+        bool aborted;
+    };
+
+    static void publishChunk(ChunkWriter &w, bool last)
+    {
+        if (w.aborted)
+            return;
+
+        DynamicJsonDocument doc(3072);
+        doc["serialNumber"] = serialNumber;
+        doc["reqId"] = w.query->reqId;
+        doc["field"] = w.query->field;
+        doc["tier"] = w.tier;
+        doc["step"] = tiers[w.tier].stepSec;
+        doc["seq"] = w.seq++;
+        doc["last"] = last;
+
+        if (w.query->packed)
+        {
+            static uint8_t packed[SmartCore_Gorilla::maxEncodedSize(HISTORY_CHUNK_SAMPLES)];
+            static char encoded[(sizeof(packed) + 2) / 3 * 4 + 1];
+
+            size_t bytes = SmartCore_Gorilla::encode(w.samples, w.count, packed, sizeof(packed));
+            size_t outLen = 0;
+            mbedtls_base64_encode((unsigned char *)encoded, sizeof(encoded), &outLen, packed, bytes);
+            encoded[outLen] = '\0';
+
+            doc["format"] = "gorilla";
+            doc["count"] = w.count;
+            doc["data"] = (const char *)encoded;
+        }
+        else
+        {
+            JsonArray ts = doc.createNestedArray("t");
+            JsonArray vs = doc.createNestedArray("v");
+            for (uint8_t i = 0; i < w.count; i++)
+            {
+                ts.add(w.samples[i].t);
+                vs.add(w.samples[i].v);
+            }
+        }
+
+        String payload;
+        serializeJson(doc, payload);
+
+        // Publish slots are shared — wait briefly for one rather than abort a long backfill
+        bool queued = false;
+        for (uint8_t attempt = 0; attempt < 10 && !queued && mqttIsConnected; attempt++)
+        {
+            queued = SmartCore_MQTT::mqttSafePublish("module/history", 1, false, payload.c_str());
+            if (!queued)
+                vTaskDelay(pdMS_TO_TICKS(50));
+        }
+
+        if (!queued)
+        {
+            logMessage(LOG_WARN, "⚠️ History query aborted — MQTT unavailable");
+            w.aborted = true;
+        }
+
+        w.count = 0;
+        vTaskDelay(pdMS_TO_TICKS(20)); // pace the backfill
+    }
+
+    static void emitSample(ChunkWriter &w, const HistorySample &s)
+    {
+        if (s.t < w.query->from || s.t > w.query->to)
+            return;
+
+        w.samples[w.count++] = s;
+        w.total++;
+
+        if (w.count >= HISTORY_CHUNK_SAMPLES)
+            publishChunk(w, false);
+    }
+
+    static void scanSegment(ChunkWriter &w, const char *path)
+    {
+        File f = LittleFS.open(path, "r");
+        if (!f)
+            return;
+
+        f.seek(sizeof(SegmentHeader));
+
+        BlockHeader hdr;
+        while (!w.aborted && f.read((uint8_t *)&hdr, sizeof(hdr)) == sizeof(hdr))
+        {
+            if (hdr.magic != HISTORY_BLOCK_MAGIC || hdr.count > HISTORY_BLOCK_SAMPLES ||
+                hdr.bytes > sizeof(blockScratch))
+                break; // torn write at the tail — stop here
+
+            if (hdr.tLast < w.query->from || hdr.tFirst > w.query->to)
+            {
+                f.seek(f.position() + hdr.bytes);
+                continue;
+            }
+
+            if (f.read(blockScratch, hdr.bytes) != hdr.bytes ||
+                !decodeBlock(hdr, blockScratch, decodeScratch))
+                break;
+
+            for (uint16_t i = 0; i < hdr.count && !w.aborted; i++)
+                emitSample(w, decodeScratch[i]);
+        }
+
+        f.close();
+    }
+
+    static void runQuery(const HistoryQuery &q)
+    {
+        int idx = findField(q.field);
+
+        uint8_t tier = 0;
+        if (q.tier >= 0 && q.tier < HISTORY_TIER_COUNT)
+        {
+            tier = q.tier;
+        }
+        else
+        {
+            // Finest tier whose retention still reaches back to "from". A "from" in the
+            // future (client clock ahead, or ours stepped back) counts as "now".
+            uint32_t now = getCurrentSmartBoatTime();
+            uint32_t age = q.from < now ? now - q.from : 0;
+            while (tier < HISTORY_TIER_COUNT - 1 && age > tiers[tier].retentionSec)
+                tier++;
+        }
+
+        static ChunkWriter w;
+        memset(&w, 0, sizeof(w));
+        w.query = &q;
+        w.tier = tier;
+
+        if (idx < 0)
+        {
+            publishChunk(w, true);
+            return;
+        }
+
+        // Anything still in RAM goes to disk first so the scan sees it
+        flushFields(true);
+
+        // Order the ring by segment start
+        uint32_t span = segmentSpan(tier);
+        uint32_t starts[HISTORY_SEGMENTS_PER_TIER];
+        uint8_t order[HISTORY_SEGMENTS_PER_TIER];
+        uint8_t n = 0;
+
+        for (uint8_t slot = 0; slot < HISTORY_SEGMENTS_PER_TIER; slot++)
+        {
+            char path[48];
+            segmentPath(path, sizeof(path), q.field, tier, slot);
+            if (!LittleFS.exists(path))
+                continue;
+
+            File f = LittleFS.open(path, "r");
+            SegmentHeader hdr = {0, 0};
+            if (f)
+            {
+                f.read((uint8_t *)&hdr, sizeof(hdr));
+                f.close();
+            }
+
+            if (hdr.magic != HISTORY_SEGMENT_MAGIC ||
+                hdr.segStart + span <= q.from || hdr.segStart > q.to)
+                continue;
+
+            uint8_t pos = n++;
+            while (pos > 0 && starts[pos - 1] > hdr.segStart)
+            {
+                starts[pos] = starts[pos - 1];
+                order[pos] = order[pos - 1];
+                pos--;
+            }
+            starts[pos] = hdr.segStart;
+            order[pos] = slot;
+        }
+
+        for (uint8_t i = 0; i < n && !w.aborted; i++)
+        {
+            char path[48];
+            segmentPath(path, sizeof(path), q.field, tier, order[i]);
+            scanSegment(w, path);
+        }
+
+        publishChunk(w, true);
+        logMessage(LOG_INFO, String("📚 History query ") + q.reqId + " → " + String(w.total) +
+                                 " samples in " + String(w.seq) + " chunks");
+    }
+
+    // ======================================================================================
+    //  FIELD SELECTION
+    // ======================================================================================
+
+    static void removeFieldFiles(const char *name)
+    {
+        char path[48];
+        for (uint8_t t = 0; t < HISTORY_TIER_COUNT; t++)
+        {
+            for (uint8_t slot = 0; slot < HISTORY_SEGMENTS_PER_TIER; slot++)
+            {
+                segmentPath(path, sizeof(path), name, t, slot);
+                if (LittleFS.exists(path))
+                    LittleFS.remove(path);
+            }
+        }
+    }
+
+    bool setFields(const char *const *names, uint8_t count)
+    {
+        if (!historyMutex || count > HISTORY_MAX_FIELDS)
+            return false;
+
+        for (uint8_t i = 0; i < count; i++)
+        {
+            if (strlen(names[i]) == 0 || strlen(names[i]) >= HISTORY_FIELD_LEN)
+                return false;
+        }
+
+        static Field staged[HISTORY_MAX_FIELDS];
+        char dropped[HISTORY_MAX_FIELDS][HISTORY_FIELD_LEN];
+        uint8_t droppedCount = 0;
+
+        if (xSemaphoreTake(historyMutex, pdMS_TO_TICKS(500)) != pdTRUE)
+            return false;
+
+        for (uint8_t i = 0; i < count; i++)
+        {
+            // Kept fields carry their pending buffers across
+            int old = findField(names[i]);
+            if (old >= 0)
+            {
+                staged[i] = fields[old];
+                continue;
+            }
+
+            memset(&staged[i], 0, sizeof(Field));
+            strncpy(staged[i].name, names[i], HISTORY_FIELD_LEN - 1);
+            staged[i].hash = hashName(staged[i].name);
+        }
+
+        for (uint8_t i = 0; i < fieldsLoaded; i++)
+        {
+            bool kept = false;
+            for (uint8_t j = 0; j < count && !kept; j++)
+                kept = !strcmp(fields[i].name, staged[j].name);
+
+            if (!kept)
+                strncpy(dropped[droppedCount++], fields[i].name, HISTORY_FIELD_LEN);
+        }
+
+        memcpy(fields, staged, sizeof(Field) * count);
+        fieldsLoaded = count;
+
+        xSemaphoreGive(historyMutex);
+
+        // Drop storage of fields that are no longer recorded
+        for (uint8_t i = 0; i < droppedCount; i++)
+            removeFieldFiles(dropped[i]);
+
+        logMessage(LOG_INFO, "📚 History recording " + String(fieldsLoaded) + " fields");
+        return true;
+    }
+
+    uint8_t fieldCount()
+    {
+        return fieldsLoaded;
+    }
+
+    static bool setFieldsFromJson(JsonArrayConst list)
+    {
+        const char *names[HISTORY_MAX_FIELDS];
+        uint8_t count = 0;
+
+        for (JsonVariantConst v : list)
+        {
+            if (count >= HISTORY_MAX_FIELDS || !v.is<const char *>())
+                return false;
+            names[count++] = v.as<const char *>();
+        }
+
+        return setFields(names, count);
+    }
+
+    static void publishHistoryStatus(const char *status)
+    {
+        StaticJsonDocument<512> doc;
+        doc["serialNumber"] = serialNumber;
+        doc["status"] = status;
+        doc["usedBytes"] = LittleFS.usedBytes();
+        doc["totalBytes"] = LittleFS.totalBytes();
+
+        JsonArray list = doc.createNestedArray("fields");
+        for (uint8_t i = 0; i < fieldsLoaded; i++)
+            list.add(fields[i].name);
+
+        char payload[512];
+        size_t len = serializeJson(doc, payload, sizeof(payload));
+        SmartCore_RPC::respond("module/history", 1, false, payload, len);
+    }
+
+    void handleHistoryMessage(const char *payload, size_t len)
+    {
+        Serial.println("📚 History message received");
+
+        if (!historyMutex)
+            return;
+
+        StaticJsonDocument<512> doc;
+        DeserializationError err = deserializeJson(doc, payload, len);
+
+        if (err)
+        {
+            Serial.printf("❌ Failed to parse history JSON: %s\n", err.c_str());
+            return;
+        }
+
+        const char *action = doc["action"] | "";
+
+        if (!strcmp(action, "query"))
+        {
+            HistoryQuery q;
+            memset(&q, 0, sizeof(q));
+            strncpy(q.reqId, doc["reqId"] | "", sizeof(q.reqId) - 1);
+            strncpy(q.field, doc["field"] | "", sizeof(q.field) - 1);
+            q.from = doc["from"] | 0;
+            q.to = doc["to"] | 0xFFFFFFFFUL;
+            q.tier = doc["tier"] | -1;
+            q.packed = !strcmp(doc["format"] | "", "gorilla");
+
+            // Served by the history task — never block the MQTT callback. The
+            // streamed answer carries reqId itself, so there is no RPC reply to cache.
+            if (xQueueSend(queryQueue, &q, 0) != pdTRUE)
+            {
+                logMessage(LOG_WARN, "⚠️ History query queue full — request dropped");
+                SmartCore_RPC::fail("busy");
+            }
+            else
+            {
+                SmartCore_RPC::deferred();
+            }
+        }
+        else if (!strcmp(action, "fields"))
+        {
+            if (!setFieldsFromJson(doc["fields"].as<JsonArrayConst>()))
+            {
+                publishHistoryStatus("error");
+                return;
+            }
+
+            File f = LittleFS.open(HISTORY_FIELDS_FILE, "w");
+            if (f)
+            {
+                serializeJson(doc["fields"], f);
+                f.close();
+            }
+
+            publishHistoryStatus("fields");
+        }
+        else if (!strcmp(action, "status"))
+        {
+            publishHistoryStatus("status");
+        }
+        else
+        {
+            Serial.println("⚠️ Unsupported action in history message.");
+        }
+    }
+
+    void historyTask(void *parameter)
+    {
+        uint32_t lastFlush = millis();
+
+        for (;;)
+        {
+            HistoryQuery q;
+            if (xQueueReceive(queryQueue, &q, pdMS_TO_TICKS(1000)) == pdTRUE)
+                runQuery(q);
+
+            bool periodic = millis() - lastFlush >= HISTORY_FLUSH_INTERVAL_MS;
+            flushFields(periodic);
+
+            if (periodic)
+                lastFlush = millis();
+        }
+    }
+
+    void init()
+    {
+        if (!historyMutex)
+            historyMutex = xSemaphoreCreateMutex();
+
+        if (!queryQueue)
+            queryQueue = xQueueCreate(HISTORY_QUERY_QUEUE_LEN, sizeof(HistoryQuery));
+
+        if (!historyMutex || !queryQueue)
+        {
+            logMessage(LOG_ERROR, "❌ Failed to create history mutex/queue");
+            return;
+        }
+
+        if (!LittleFS.exists(HISTORY_DIR))
+            LittleFS.mkdir(HISTORY_DIR);
+
+        if (LittleFS.exists(HISTORY_FIELDS_FILE))
+        {
+            File f = LittleFS.open(HISTORY_FIELDS_FILE, "r");
+            if (f)
+            {
+                StaticJsonDocument<512> doc;
+                if (!deserializeJson(doc, f))
+                    setFieldsFromJson(doc.as<JsonArrayConst>());
+                f.close();
+            }
+        }
+
+        if (!historyTaskHandle)
+            xTaskCreatePinnedToCore(historyTask, "History Task", 6144, NULL, 1, &historyTaskHandle, 1);
+    }
+}
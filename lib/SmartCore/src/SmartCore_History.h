@@ -0,0 +1,54 @@
+#pragma once
+
+#include <Arduino.h>
+#include "SmartCore_Gorilla.h"
+
+// History store limits (override externally if needed)
+#ifndef HISTORY_MAX_FIELDS
+#define HISTORY_MAX_FIELDS 8
+#endif
+
+#define HISTORY_FIELD_LEN 24
+#define HISTORY_TIER_COUNT 3
+#define HISTORY_SEGMENTS_PER_TIER 7       // ring of segment files per field/tier
+#define HISTORY_BLOCK_SAMPLES 60          // RAM buffer per field/tier before flush
+#define HISTORY_FLUSH_INTERVAL_MS 60000   // partial blocks are flushed at least this often
+#define HISTORY_CHUNK_SAMPLES 64          // samples per MQTT response chunk
+#define HISTORY_QUERY_QUEUE_LEN 4
+
+#define HISTORY_DIR "/hist"
+#define HISTORY_FIELDS_FILE "/hist/fields.json"
+
+// One stored point (SmartBoat epoch seconds, value) — same layout the block codec uses
+typedef GorillaSample HistorySample;
+
+// RRD-style tiers: 1 s for an hour, 1 min for a day, 10 min for a month
+struct HistoryTier
+{
+    uint32_t stepSec;
+    uint32_t retentionSec;
+};
+
+namespace SmartCore_History
+{
+    extern TaskHandle_t historyTaskHandle;
+    extern const HistoryTier tiers[HISTORY_TIER_COUNT];
+
+    // Startup (loads the selected field list, starts the flush/query task)
+    void init();
+
+    // Field selection
+    bool setFields(const char *const *names, uint8_t count);
+    uint8_t fieldCount();
+
+    // Buffered append — cheap, safe to call from any task
+    void record(const char *field, float value);
+
+    // Force all RAM buffers to LittleFS
+    void flush();
+
+    // MQTT entry point (<serialNumber>/history)
+    void handleHistoryMessage(const char *payload, size_t len);
+
+    void historyTask(void *parameter);
+}
@@ -2,6 +2,9 @@
 #include "SmartCore_Network.h"
 #include "SmartCore_System.h"
 #include "SmartCore_MQTT.h"
+#include "SmartCore_MQTTConn.h"
+#include "SmartCore_Liveness.h"
+#include "SmartCore_Reconnect.h"
 #include "SmartCore_Log.h"
 #include "SmartCore_EEPROM.h"
 #include "SmartCore_Wifi.h"
@@ -296,19 +299,28 @@ namespace SmartCore_LED
     // --------------------------------------------------------------------------------------
     //
     // 1) mqttIsConnected == false AND WiFi == connected:
-    //        mqttFailCount++
+    //        First reconnect after SmartCore_Reconnect::firstDelay() — this module's
+    //        slot in the broker's admission window, or a random spread — so a whole
+    //        boat does not reconnect in the same second after a SmartBox restart.
     //
-    //        Every mqttBackoff interval:
+    //        From then on mqttFailCount++ every second, and every mqttBackoff interval:
     //            → Attempt reconnect to *currentBrokerIP/currentBrokerPort*.
     //
-    //        mqttBackoff doubles each time (max 5 minutes).
+    //        mqttBackoff = SmartCore_Reconnect::nextDelay() (decorrelated jitter,
+    //        5 s … 5 minutes).
     //
-    // 2) mqttFailCount == 8
-    //        → Hard-reset MQTT client (destroy client, recreate from scratch).
+    //        Attempts are non-blocking. While SmartCore_MQTTConn::busy() (an attempt
+    //        or a boot/failover connect plan is still running) no new attempt, hard
+    //        reset or failover is started — the count keeps running.
     //
-    // 3) mqttFailCount > 10
+    // 2) mqttFailCount >= 8 (once per outage)
+    //        → Hard-reset MQTT client (drop the socket, reconfigure it in place).
+    //
+    // 3) mqttFailCount > 10, or the liveness probe declared the broker dead
+    //    (SmartCore_Liveness::takeDeadVerdict — TCP up but pings unanswered)
     //        → Trigger SmartCore_MQTT::handleMQTTFailover()
     //        → mqttFailCount is reset to 0 after calling failover handler.
+    //        → mqttBackoff restarts from the jitter base for the new broker.
     //
     // --------------------------------------------------------------------------------------
     //  FAILOVER SAFETY
@@ -337,7 +349,7 @@ namespace SmartCore_LED
     //  • WiFi DOWN  → exponential reconnect (no AP).
     //  • MQTT DOWN → reconnect attempts → hard reset → failover.
     //  • Failover pauses reconnect attempts until Pi ACKs.
-    //  • On successful connection (handled inside onMqttConnect()):
+    //  • On successful connection (onMqttConnect() + SmartCore_MQTTConn):
     //        → Priority index is persisted
     //        → Normal monitoring resumes.
     //
@@ -348,12 +360,14 @@ namespace SmartCore_LED
     {
         static int wifiFailCount = 0;
         static int mqttFailCount = 0;
+        static bool hardResetDone = false;
+        static bool mqttOutage = false;        // first reconnect of this outage scheduled
+        static bool mqttOutageAttempt = false; // ...and made
 
         static uint32_t wifiBackoff = 2000; // 2 sec
-        static uint32_t mqttBackoff = 5000; // 5 sec
+        static uint32_t mqttBackoff = RECONNECT_BASE_MS; // SmartCore_Reconnect decides
 
         const uint32_t WIFI_BACKOFF_MAX = 5 * 60 * 1000UL; // 5 min
-        const uint32_t MQTT_BACKOFF_MAX = 5 * 60 * 1000UL; // 5 min
 
         uint32_t lastWiFiAttempt = 0;
         uint32_t lastMQTTAttempt = 0;
@@ -435,42 +449,69 @@ namespace SmartCore_LED
                     continue;
                 }
 
-                mqttFailCount++;
+                // Outage start: the whole boat may have lost this broker at once — wait
+                // for our admission slot / jitter before the first reconnect. The down
+                // count (hard reset, failover) starts with that attempt.
+                if (!mqttOutage)
+                {
+                    mqttOutage = true;
+                    mqttOutageAttempt = false;
+                    lastMQTTAttempt = now;
+                    mqttBackoff = SmartCore_Reconnect::firstDelay();
+                }
+
+                if (mqttOutageAttempt)
+                    mqttFailCount++;
 
                 logMessage(LOG_WARN,
                            "[MQTTCheck] MQTT DOWN. Count=" + String(mqttFailCount) +
                                " | Backoff=" + String(mqttBackoff / 1000) + "s");
 
-                if (now - lastMQTTAttempt >= mqttBackoff)
+                // A connect attempt / plan is still running → let it finish (its own
+                // timeout bounds it); the down-time count keeps running meanwhile.
+                bool connBusy = SmartCore_MQTTConn::busy();
+
+                // The liveness probe dropped a stalled broker → don't retry it, fail over now
+                bool brokerDead = !connBusy && SmartCore_Liveness::takeDeadVerdict();
+
+                if (!brokerDead && !connBusy && now - lastMQTTAttempt >= mqttBackoff)
                 {
                     lastMQTTAttempt = now;
+                    mqttOutageAttempt = true;
                     logMessage(LOG_INFO, "[MQTTCheck] Attempting MQTT reconnect…");
 
                     SmartCore_MQTT::setupMQTTClient(
                         SmartCore_MQTT::currentBrokerIP,
                         SmartCore_MQTT::currentBrokerPort);
 
-                    mqttBackoff = min<uint32_t>(mqttBackoff * 2, MQTT_BACKOFF_MAX);
+                    mqttBackoff = SmartCore_Reconnect::nextDelay();
                 }
 
                 // Hard reset MQTT client
-                if (mqttFailCount == 8)
+                if (mqttFailCount >= 8 && !hardResetDone && !connBusy && !brokerDead)
                 {
+                    hardResetDone = true;
                     logMessage(LOG_WARN, "[MQTTCheck] Hard-resetting MQTT client");
                     SmartCore_MQTT::hardResetClient();
-                    vTaskDelay(pdMS_TO_TICKS(300));
 
                     SmartCore_MQTT::setupMQTTClient(
                         SmartCore_MQTT::currentBrokerIP,
                         SmartCore_MQTT::currentBrokerPort);
                 }
 
-                // FAILOVER CALLBACK — only after repeated failures
-                if (mqttFailCount > 10)
+                // FAILOVER CALLBACK — after repeated failures, or at once for a dead broker
+                if ((mqttFailCount > 10 || brokerDead) && !connBusy)
                 {
                     logMessage(LOG_WARN, "[MQTTCheck] Triggering FAILOVER HANDLER");
                     SmartCore_MQTT::handleMQTTFailover();
                     mqttFailCount = 0;
+                    hardResetDone = false;
+
+                    // The failover engine already started connecting to the new broker;
+                    // give it a fresh backoff instead of the old broker's stretched one.
+                    SmartCore_Reconnect::reset();
+                    mqttBackoff = SmartCore_Reconnect::nextDelay();
+                    lastMQTTAttempt = millis();
                 }
             }
             else
@@ -479,7 +520,9 @@ namespace SmartCore_LED
                     logMessage(LOG_INFO, "[MQTTCheck] MQTT recovered.");
 
                 mqttFailCount = 0;
-                mqttBackoff = 5000;
+                hardResetDone = false;
+                mqttOutage = false;
+                SmartCore_Reconnect::reset();
             }
 
             vTaskDelay(pdMS_TO_TICKS(1000));
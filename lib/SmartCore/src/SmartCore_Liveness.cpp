@@ -0,0 +1,235 @@
+#include "SmartCore_Liveness.h"
+#include "SmartCore_MQTT.h"
+#include "SmartCore_Network.h"
+#include "SmartCore_Publisher.h"
+#include "SmartCore_OTA.h"
+#include "SmartCore_BrokerHealth.h"
+#include "SmartCore_Log.h"
+
+namespace SmartCore_Liveness
+{
+    TaskHandle_t livenessTaskHandle = NULL;
+
+    // ======================================================================================
+    //  BROKER LIVENESS PROBE
+    // ======================================================================================
+    //
+    //  A broker can keep the TCP connection open while it no longer routes messages
+    //  (hung SmartBox, stalled bridge). Neither the socket nor the MQTT keepalive
+    //  notices that quickly, so every LIVENESS_INTERVAL_MS the module publishes a
+    //  sequence number to its own "<serialNumber>/ping" (QoS 0, high priority) and
+    //  waits for it to come back through its "<serialNumber>/#" subscription:
+    //
+    //      tick:  previous ping not sent yet      → wait (uplink busy, not the broker)
+    //             sent < LIVENESS_INTERVAL_MS ago  → wait
+    //             sent and still unanswered        → miss
+    //             LIVENESS_MISS_LIMIT misses in a row → broker dead
+    //             otherwise → send the next ping
+    //
+    //  The deadline runs from the publisher's sent-hook, not from submit(): a ping
+    //  queued behind a history backfill or outbox replay is not a missed ping. One
+    //  that never leaves the publisher (LIVENESS_QUEUED_MAX_MS) is replaced.
+    //
+    //  Dead broker (≈ LIVENESS_MISS_LIMIT × LIVENESS_INTERVAL_MS):
+    //      • BrokerHealth failure recorded
+    //      • session dropped (hot standby, if built in, is promoted right here)
+    //      • takeDeadVerdict() tells wifiMqttCheckTask() to fail over immediately
+    //        instead of reconnecting to the same broker
+    //
+    //  The echo is handled on the AsyncTCP task before topic routing, so a busy MQTT
+    //  worker cannot make a healthy broker look dead. Round trips land in a small
+    //  histogram (LivenessStats) reported with the metrics.
+    //
+    // ======================================================================================
+
+    static const uint16_t rttBounds[LIVENESS_RTT_BUCKETS - 1] = {5, 10, 25, 50, 100, 250, 1000};
+
+    static portMUX_TYPE liveMux = portMUX_INITIALIZER_UNLOCKED;
+    static LivenessStats stats;
+    static uint32_t nextSeq = 1;
+    static uint32_t outstandingSeq = 0; // 0 = nothing in flight
+    static uint32_t queuedMs = 0;
+    static uint32_t sentMs = 0;
+    static bool onWire = false; // outstanding ping has left the publisher
+    static uint8_t misses = 0;
+    static volatile bool deadVerdict = false;
+
+    void init()
+    {
+        if (livenessTaskHandle)
+            return;
+
+        xTaskCreatePinnedToCore(livenessTask, "MQTT Liveness", 3072, NULL, 1, &livenessTaskHandle, 0);
+    }
+
+    void sessionStarted()
+    {
+        portENTER_CRITICAL(&liveMux);
+        outstandingSeq = 0;
+        misses = 0;
+        deadVerdict = false;
+        portEXIT_CRITICAL(&liveMux);
+    }
+
+    void onEcho(const char *payload, size_t len)
+    {
+        char buf[12];
+        if (len == 0 || len >= sizeof(buf))
+            return;
+
+        memcpy(buf, payload, len);
+        buf[len] = '\0';
+        uint32_t seq = strtoul(buf, nullptr, 10);
+
+        portENTER_CRITICAL(&liveMux);
+        if (outstandingSeq != 0 && seq == outstandingSeq)
+        {
+            uint32_t rtt = onWire ? millis() - sentMs : 0; // echo beat the sent-hook
+            uint8_t b = 0;
+            while (b < LIVENESS_RTT_BUCKETS - 1 && rtt > rttBounds[b])
+                b++;
+
+            stats.rttHist[b]++;
+            stats.answered++;
+            stats.lastRttMs = min<uint32_t>(rtt, UINT16_MAX);
+            if (stats.lastRttMs > stats.maxRttMs)
+                stats.maxRttMs = stats.lastRttMs;
+
+            outstandingSeq = 0;
+            misses = 0;
+        }
+        portEXIT_CRITICAL(&liveMux);
+    }
+
+    bool takeDeadVerdict()
+    {
+        bool v = false;
+
+        portENTER_CRITICAL(&liveMux);
+        v = deadVerdict;
+        deadVerdict = false;
+        portEXIT_CRITICAL(&liveMux);
+
+        return v;
+    }
+
+    void getStats(LivenessStats &out)
+    {
+        portENTER_CRITICAL(&liveMux);
+        out = stats;
+        portEXIT_CRITICAL(&liveMux);
+    }
+
+    // Publish task, right after the ping went out
+    static void onPingSent(int64_t tag, int64_t sentUs)
+    {
+        portENTER_CRITICAL(&liveMux);
+        if (outstandingSeq != 0 && outstandingSeq == (uint32_t)tag)
+        {
+            sentMs = (uint32_t)(sentUs / 1000); // millis() runs on the same esp_timer clock
+            onWire = true;
+        }
+        portEXIT_CRITICAL(&liveMux);
+    }
+
+    static void declareDead()
+    {
+        String ip = SmartCore_MQTT::currentBrokerIP;
+        int8_t idx = SmartCore_BrokerHealth::indexOf(ip);
+
+        logMessage(LOG_WARN, "💀 Broker " + ip + " stopped answering pings — dropping session");
+
+        if (idx >= 0)
+            SmartCore_BrokerHealth::recordFailure(idx);
+
+        // Verdict first: a standby promotion inside disconnect() clears it again
+        portENTER_CRITICAL(&liveMux);
+        deadVerdict = true;
+        outstandingSeq = 0;
+        misses = 0;
+        stats.deadVerdicts++;
+        portEXIT_CRITICAL(&liveMux);
+
+        SmartCore_Publisher::lockClient();
+        if (mqttClient && mqttClient->connected())
+            mqttClient->disconnect(true);
+        SmartCore_Publisher::unlockClient();
+    }
+
+    void livenessTask(void *parameter)
+    {
+        logMessage(LOG_INFO, "💓 MQTT liveness probe started");
+
+        char topic[56];
+        char payload[12];
+
+        for (;;)
+        {
+            vTaskDelay(pdMS_TO_TICKS(LIVENESS_INTERVAL_MS));
+
+            if (!mqttIsConnected)
+                continue;
+
+            bool dead = false;
+            bool wait = false;
+            uint32_t now = millis();
+
+            portENTER_CRITICAL(&liveMux);
+            if (outstandingSeq != 0)
+            {
+                if (!onWire)
+                {
+                    // Still queued in the publisher — congestion, not a dead broker
+                    wait = now - queuedMs < LIVENESS_QUEUED_MAX_MS;
+                    if (wait)
+                        stats.heldBack++;
+                }
+                else if (now - sentMs < LIVENESS_INTERVAL_MS)
+                {
+                    wait = true; // went out late; give it a full interval
+                }
+                else
+                {
+                    stats.missed++;
+                    dead = ++misses >= LIVENESS_MISS_LIMIT;
+                }
+            }
+            portEXIT_CRITICAL(&liveMux);
+
+            if (wait)
+                continue;
+
+            if (dead)
+            {
+                declareDead();
+                continue;
+            }
+
+            uint32_t seq = nextSeq++;
+            if (nextSeq == 0)
+                nextSeq = 1;
+
+            snprintf(topic, sizeof(topic), "%s/%s", serialNumber, LIVENESS_SUBTOPIC);
+            snprintf(payload, sizeof(payload), "%lu", (unsigned long)seq);
+
+            portENTER_CRITICAL(&liveMux);
+            outstandingSeq = seq;
+            queuedMs = millis();
+            onWire = false;
+            stats.sent++;
+            portEXIT_CRITICAL(&liveMux);
+
+            // Nothing queued (pipeline full) → don't count it against the broker
+            if (!mqttIsConnected || SmartCore_OTA::otaInProgress ||
+                !SmartCore_Publisher::submit(topic, 0, false, payload, strlen(payload), PUB_PRIO_HIGH,
+                                             PUBLISH_NO_STORE, onPingSent, seq))
+            {
+                portENTER_CRITICAL(&liveMux);
+                if (outstandingSeq == seq)
+                    outstandingSeq = 0;
+                stats.sent--;
+                portEXIT_CRITICAL(&liveMux);
+            }
+        }
+    }
+}
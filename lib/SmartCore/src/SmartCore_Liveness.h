@@ -0,0 +1,50 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Application-level broker liveness probe (override externally if needed)
+#ifndef LIVENESS_INTERVAL_MS
+#define LIVENESS_INTERVAL_MS 2000 // one loopback ping per interval
+#endif
+#ifndef LIVENESS_MISS_LIMIT
+#define LIVENESS_MISS_LIMIT 3     // consecutive unanswered pings → broker declared dead
+#endif
+#ifndef LIVENESS_QUEUED_MAX_MS
+#define LIVENESS_QUEUED_MAX_MS 30000 // a ping stuck in the publisher this long is re-sent
+#endif
+#define LIVENESS_SUBTOPIC "ping"  // "<serialNumber>/ping"
+#define LIVENESS_RTT_BUCKETS 8
+
+struct LivenessStats
+{
+    uint32_t sent;
+    uint32_t answered;
+    uint32_t missed;
+    uint32_t heldBack;     // ticks skipped while the ping still sat in the publisher
+    uint32_t deadVerdicts; // sessions torn down by the probe
+    uint16_t lastRttMs;
+    uint16_t maxRttMs;
+    uint32_t rttHist[LIVENESS_RTT_BUCKETS]; // ≤5, ≤10, ≤25, ≤50, ≤100, ≤250, ≤1000, >1000 ms
+};
+
+namespace SmartCore_Liveness
+{
+    extern TaskHandle_t livenessTaskHandle;
+
+    // Starts the probe task (idempotent)
+    void init();
+
+    // A session (re)started — forget outstanding pings and any pending verdict
+    void sessionStarted();
+
+    // "<serialNumber>/ping" came back (AsyncTCP task)
+    void onEcho(const char *payload, size_t len);
+
+    // True once after the probe dropped a stalled broker: fail over instead of
+    // reconnecting to it
+    bool takeDeadVerdict();
+
+    void getStats(LivenessStats &out);
+
+    void livenessTask(void *parameter);
+}
@@ -1,5 +1,8 @@
 #include "SmartCore_Log.h"
 
+static LogStats logStats = {};
+static portMUX_TYPE logStatsMux = portMUX_INITIALIZER_UNLOCKED;
+
 String logLevelToString(LogLevel level) {
     switch (level) {
         case LOG_INFO:  return "ℹ️ INFO";
@@ -10,8 +13,23 @@ String logLevelToString(LogLevel level) {
 }
 
 void logMessage(LogLevel level, const String& message) {
+    portENTER_CRITICAL(&logStatsMux);
+    if (level == LOG_ERROR)
+        logStats.error++;
+    else if (level == LOG_WARN)
+        logStats.warn++;
+    else
+        logStats.info++;
+    portEXIT_CRITICAL(&logStatsMux);
+
     String logLine = logLevelToString(level) + ": " + message;
     Serial.println(logLine);
 
     // 🛰️ TODO: Add MQTT / SmartNet / File logging here in future
-}
\ No newline at end of file
+}
+
+void getLogStats(LogStats &out) {
+    portENTER_CRITICAL(&logStatsMux);
+    out = logStats;
+    portEXIT_CRITICAL(&logStatsMux);
+}
@@ -9,8 +9,18 @@ enum LogLevel {
     LOG_ERROR
 };
 
+struct LogStats
+{
+    uint32_t info;
+    uint32_t warn;
+    uint32_t error;
+};
+
 // 🧠 Public function to log messages
 void logMessage(LogLevel level, const String& message);
 
+// Messages logged per level since boot
+void getLogStats(LogStats &out);
+
 // Optional: Fancy formatting if needed
 String logLevelToString(LogLevel level);
@@ -2,18 +2,34 @@
 #include <arduino.h>
 #include <AsyncMqttClient.h>
 #include <HTTPClient.h>
+#include <esp_timer.h>
 #include "SmartCore_Network.h"
 #include "SmartCore_LED.h"
 #include "SmartCore_EEPROM.h"
 #include "SmartCore_Log.h"
 #include <functional>
 #include <ArduinoJson.h>
-#include "driver/temp_sensor.h"
 #include "SmartCore_System.h"
 #include <otadrive_esp.h>
 #include "mqtt_handlers.h"
 #include "SmartCore_OTA.h"
 #include "FirmwareVersion.h"
+#include "SmartCore_Rules.h"
+#include "SmartCore_Alarms.h"
+#include "SmartCore_History.h"
+#include "SmartCore_Publisher.h"
+#include "SmartCore_MQTTConn.h"
+#include "SmartCore_BrokerProbe.h"
+#include "SmartCore_BrokerHealth.h"
+#include "SmartCore_Standby.h"
+#include "SmartCore_Liveness.h"
+#include "SmartCore_Reconnect.h"
+#include "SmartCore_Fallback.h"
+#include "SmartCore_RPC.h"
+#include "SmartCore_Metrics.h"
+#include "SmartCore_Traffic.h"
+#include "SmartCore_Time.h"
+#include "SmartCore_Hash.h"
 
 volatile bool mqttResetPending = false;
 volatile bool mqttDisconnectInProgress = false;
@@ -29,6 +45,8 @@ namespace SmartCore_MQTT
     String currentBrokerIP = "";
     uint16_t currentBrokerPort = 1883;
     char mqttWillTopic[64];
+    static char mqttClientId[13];  // AsyncMqttClient stores these pointers,
+    static char mqttHost[40];      // so they must outlive every connect
     TaskHandle_t metricsTaskHandle = NULL;
     TaskHandle_t timeSyncTaskHandle = NULL;
     void onMqttConnect(bool sessionPresent);
@@ -37,6 +55,87 @@ namespace SmartCore_MQTT
     static std::function<void(bool)> mqttConnectCallback = SmartCore_MQTT::onMqttConnect;
     static std::function<void(AsyncMqttClientDisconnectReason)> mqttDisconnectCallback = SmartCore_MQTT::onMqttDisconnect;
 
+    // ======================================================================================
+    //  INBOUND TOPIC ROUTER
+    // ======================================================================================
+    //
+    //  Everything arriving on "<serialNumber>/#" is dispatched through one fixed table:
+    //
+    //      topicPrefix  = "<serialNumber>/"   (rebuilt in generateMqttPrefix)
+    //      topicRoutes  = { "config", handleConfigMessage }, { "rules", ... }, ...
+    //
+    //  onMqttMessage() does a single prefix compare, then a length + memcmp per route —
+    //  no String allocations. Handlers get a (payload, len) view that is only valid for
+    //  the duration of the call; they run on the MQTT worker task (see INBOUND WORKER).
+    //
+    //  Modules add their own subtopics with registerTopicHandler() (normally from setup).
+    //  Registering an existing subtopic replaces its handler; the core routes never
+    //  override a module registration made before the first connect.
+    //
+    // ======================================================================================
+
+    struct TopicRoute
+    {
+        char subtopic[MQTT_SUBTOPIC_LEN];
+        uint8_t len;
+        MqttTopicHandler handler;
+    };
+
+    static TopicRoute topicRoutes[MQTT_MAX_TOPIC_HANDLERS];
+    static uint8_t topicRouteCount = 0;
+    static char topicPrefix[48];
+    static size_t topicPrefixLen = 0;
+
+    static bool addTopicRoute(const char *subtopic, MqttTopicHandler handler, bool replace)
+    {
+        size_t len = strlen(subtopic);
+        if (!handler || len == 0 || len >= MQTT_SUBTOPIC_LEN)
+            return false;
+
+        for (uint8_t i = 0; i < topicRouteCount; i++)
+        {
+            if (topicRoutes[i].len == len && !memcmp(topicRoutes[i].subtopic, subtopic, len))
+            {
+                if (replace)
+                    topicRoutes[i].handler = handler;
+                return true;
+            }
+        }
+
+        if (topicRouteCount >= MQTT_MAX_TOPIC_HANDLERS)
+        {
+            logMessage(LOG_WARN, String("⚠️ Topic table full — cannot route '") + subtopic + "'");
+            return false;
+        }
+
+        TopicRoute &r = topicRoutes[topicRouteCount++];
+        memcpy(r.subtopic, subtopic, len + 1);
+        r.len = len;
+        r.handler = handler;
+        return true;
+    }
+
+    bool registerTopicHandler(const char *subtopic, MqttTopicHandler handler)
+    {
+        return addTopicRoute(subtopic, handler, true);
+    }
+
+    static void buildTopicRoutes()
+    {
+        topicPrefixLen = snprintf(topicPrefix, sizeof(topicPrefix), "%s/", serialNumber);
+
+        addTopicRoute("config", handleConfigMessage, false);
+        addTopicRoute("errors", handleErrorMessage, false);
+        addTopicRoute("module", handleModuleMessage, false);
+        addTopicRoute("reset", handleResetMessage, false);
+        addTopicRoute("upgrade", handleUpgradeMessage, false);
+        addTopicRoute("update", handleUpdateMessage, false);
+        addTopicRoute("rules", SmartCore_Rules::handleRulesMessage, false);
+        addTopicRoute("alarms", SmartCore_Alarms::handleAlarmsMessage, false);
+        addTopicRoute("history", SmartCore_History::handleHistoryMessage, false);
+        addTopicRoute("traffic", SmartCore_Traffic::handleTrafficMessage, false);
+    }
+
     void generateMqttPrefix()
     {
         // Set mqttPrefix based on the first 4 chars of serialNumber
@@ -47,36 +146,101 @@ namespace SmartCore_MQTT
         snprintf(mqttWillTopic, sizeof(mqttWillTopic), "%s/disconnected", mqttPrefix);
         mqttWillTopic[sizeof(mqttWillTopic) - 1] = '\0'; // Safety null-termination
 
+        // Inbound routing table follows the serial number
+        buildTopicRoutes();
+
         // Debugging
         logMessage(LOG_INFO, "🧠 MQTT prefix: " + String(mqttPrefix));
         logMessage(LOG_INFO, "🧠 MQTT will topic: " + String(mqttWillTopic));
     }
 
-    void setupMQTTClient(const String &ip, uint16_t port)
+    // One client object for the lifetime of the firmware (two with MQTT_HOT_STANDBY —
+    // active and standby swap roles on promotion). Reconfigured in place, never freed,
+    // so no other task can ever hold a dangling pointer.
+    static AsyncMqttClient mqttClients[2];
+    static volatile bool switchingBroker = false; // deliberate disconnect, don't promote
+
+    // Callbacks are registered once per object and dispatch on its current role
+    static void registerClient(AsyncMqttClient *c)
+    {
+        c->onConnect([c](bool sessionPresent)
+                     {
+            if (c == mqttClient)
+                onMqttConnect(sessionPresent);
+#ifdef MQTT_HOT_STANDBY
+            else
+                SmartCore_Standby::onConnect(c, sessionPresent);
+#endif
+                     });
+
+        c->onDisconnect([c](AsyncMqttClientDisconnectReason reason)
+                        {
+            if (c == mqttClient)
+                onMqttDisconnect(reason);
+#ifdef MQTT_HOT_STANDBY
+            else
+                SmartCore_Standby::onDisconnect(c, reason);
+#endif
+                        });
+
+        c->onMessage([c](char *topic, char *payload, AsyncMqttClientMessageProperties properties,
+                         size_t len, size_t index, size_t total)
+                     {
+            // The standby only forwards single-segment messages (no reassembly clash)
+            if (c == mqttClient || (index == 0 && len == total))
+                onMqttMessage(topic, payload, properties, len, index, total, c); });
+
+        c->onPublish(SmartCore_Publisher::onPublishAck);
+    }
+
+    // Configure the client and start ONE connection attempt. Returns as soon as
+    // connect() has been issued — the outcome arrives via onMqttConnect /
+    // onMqttDisconnect / the connect timeout (see SmartCore_MQTTConn).
+    bool setupMQTTClient(const String &ip, uint16_t port)
     {
         logMessage(LOG_INFO, "🔧 Configuring MQTT client for " + ip + ":" + String(port));
 
         generateMqttPrefix(); // sets mqttWillTopic
 
-        // Clean previous instance
-        if (mqttClient)
-            delete mqttClient;
-
-        mqttClient = new AsyncMqttClient();
+        // All publishes go through the publish task from here on,
+        // all inbound handlers through the worker
+        SmartCore_Publisher::init();
+        startMqttWorker();
+        SmartCore_Liveness::init();
+        SmartCore_Fallback::init();
 
-        // --- Callbacks ---
-        mqttClient->onConnect(onMqttConnect);
-        mqttClient->onDisconnect(onMqttDisconnect);
-        mqttClient->onMessage(onMqttMessage);
+        SmartCore_Publisher::lockClient();
 
-        mqttClient->setKeepAlive(15);
+        if (!mqttClient)
+        {
+            mqttClient = &mqttClients[0];
+            registerClient(&mqttClients[0]);
+
+            // Client ID = MAC without colons (the client keeps the pointer)
+            uint8_t mac[6];
+            WiFi.macAddress(mac);
+            snprintf(mqttClientId, sizeof(mqttClientId), "%02X%02X%02X%02X%02X%02X",
+                     mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
+
+#ifdef MQTT_HOT_STANDBY
+            registerClient(&mqttClients[1]);
+            SmartCore_Standby::init(&mqttClients[1]);
+#endif
+        }
+        else if (mqttClient->connected())
+        {
+            switchingBroker = true;
+            mqttClient->disconnect(true); // switching broker while connected
+            switchingBroker = false;
+        }
 
-        // Client ID = MAC without colons
-        String clientId = WiFi.macAddress();
-        clientId.replace(":", "");
-        mqttClient->setClientId(clientId.c_str());
+        // Identity + keepalive every time: after a standby promotion this may be
+        // the other client object
+        mqttClient->setClientId(mqttClientId);
+        mqttClient->setKeepAlive(MQTT_KEEPALIVE_S);
+        mqttClient->setCleanSession(!MQTT_PERSISTENT_SESSION);
 
-        // Will
+        // Will (topic may have changed with the serial number)
         mqttClient->setWill(
             mqttWillTopic,
             1,
@@ -88,33 +252,23 @@ namespace SmartCore_MQTT
         currentBrokerIP = ip;
         currentBrokerPort = port;
 
-        // Set server
-        mqttClient->setServer(currentBrokerIP.c_str(), currentBrokerPort);
+        // Set server — from a static buffer, the client keeps the pointer
+        strlcpy(mqttHost, ip.c_str(), sizeof(mqttHost));
+        mqttClient->setServer(mqttHost, currentBrokerPort);
+
+        SmartCore_Publisher::unlockClient();
 
         // WiFi check
         if (WiFi.status() != WL_CONNECTED)
         {
             logMessage(LOG_WARN, "📶 WiFi not connected → skipping MQTT connect.");
-            return;
+            return false;
         }
 
-        // Attempt connection ONCE
+        // Attempt connection ONCE — no waiting here
+        SmartCore_MQTTConn::attemptStarted();
         mqttClient->connect();
-
-        // Optional: minimal blocking wait
-        unsigned long start = millis();
-        while (!mqttClient->connected() && millis() - start < 3000)
-            delay(50);
-
-        if (mqttClient->connected())
-            logMessage(
-                LOG_INFO,
-                String("✅ MQTT connected to ") +
-                    currentBrokerIP +
-                    ":" +
-                    String(currentBrokerPort));
-        else
-            logMessage(LOG_WARN, String("❌ MQTT connect FAILED to ") + currentBrokerIP + ":" + String(currentBrokerPort));
+        return true;
     }
 
     // ======================================================================================
@@ -142,7 +296,14 @@ namespace SmartCore_MQTT
     //  HOW FAILURE ROTATION WORKS
     // --------------------------------------------------------------------------------------
     //
-    //   1) Increment currentPriorityIndex with wrap-around.
+    //   1) Probe every broker in parallel (SmartCore_BrokerProbe, ≤ 1.5 s) and take
+    //      the best-ranked one that answers, other than the one that just failed.
+    //      Ranking = SmartCore_BrokerHealth::rank(): primary first unless flaky,
+    //      backups by learned RTT / failure / session-length score.
+    //      A SmartBox counts its own IP as available (the Pi can promote it).
+    //      Nobody answers at all → SmartCore_Fallback: the elected SmartBox's
+    //      embedded broker, if one announced itself (a SmartBox joins the election).
+    //      Still nothing → increment currentPriorityIndex with wrap-around.
     //      Example list: [Primary, Backup1, Backup2, Backup3]
     //
     //   2) nextIP = mqttPriorityList[currentPriorityIndex]
@@ -199,7 +360,7 @@ namespace SmartCore_MQTT
     //  SUMMARY
     // --------------------------------------------------------------------------------------
     //
-    //   - SmartModules rotate brokers immediately.
+    //   - SmartModules switch to the best live broker immediately.
     //   - SmartBox units coordinate with the Pi for consistent cluster switching.
     //   - failoverInProgress ensures no reconnection fight occurs during failover.
     //   - Once complete, MQTT reconnects using the new broker automatically.
@@ -225,6 +386,7 @@ namespace SmartCore_MQTT
         }
 
         logMessage(LOG_WARN, "🚨 MQTT FAILOVER triggered.");
+        SmartCore_MQTTConn::failoverStarted();
 
         // Freeze ONLY MQTT reconnect logic — NOT LED, NOT WiFi
         failoverInProgress = true;
@@ -244,17 +406,6 @@ namespace SmartCore_MQTT
             return;
         }
 
-        // Move index → next item (wrap-around)
-        currentPriorityIndex++;
-        if (currentPriorityIndex >= mqttPriorityCount)
-            currentPriorityIndex = 0;
-
-        String nextIP = mqttPriorityList[currentPriorityIndex];
-        uint16_t nextPort = mqtt_port;
-
-        logMessage(LOG_INFO,
-                   "🔄 Next priority broker → " + nextIP + ":" + String(nextPort));
-
         // ---------------------------------------------------------
         // Determine if this is a SmartBox module
         // ---------------------------------------------------------
@@ -266,6 +417,79 @@ namespace SmartCore_MQTT
             sn.startsWith("SBC") ||
             sn.startsWith("SBP");
 
+        // ---------------------------------------------------------
+        // Pick the next broker: best live one, else plain rotation
+        // ---------------------------------------------------------
+        int failedIndex = currentPriorityIndex;
+        int nextIndex = -1;
+
+        BrokerProbeResult probe[BROKER_PROBE_MAX];
+        SmartCore_BrokerProbe::probeAll(probe, failedIndex);
+
+        uint8_t order[BROKER_PROBE_MAX];
+        uint8_t ranked = SmartCore_BrokerHealth::rank(order);
+
+        for (int pass = 0; pass < 2 && nextIndex < 0; pass++)
+        {
+            for (int k = 0; k < ranked; k++)
+            {
+                int i = order[k];
+                if (pass == 0 && i == failedIndex)
+                    continue; // the failed broker only if nothing else is alive
+
+                bool alive = probe[i].answered || (isSmartBox && ownIP == mqttPriorityList[i]);
+                if (alive)
+                {
+                    nextIndex = i;
+                    break;
+                }
+            }
+        }
+
+        bool anyAnswered = false;
+        for (int i = 0; i < mqttPriorityCount && i < BROKER_PROBE_MAX; i++)
+            anyAnswered |= probe[i].answered;
+
+        // ---------------------------------------------------------
+        // Total outage → last resort: the elected fallback broker
+        // ---------------------------------------------------------
+        if (!anyAnswered)
+        {
+            SmartCore_Fallback::onTotalOutage();
+
+            String fallbackIP;
+            uint16_t fallbackPort;
+            if (SmartCore_Fallback::leader(fallbackIP, fallbackPort))
+            {
+                logMessage(LOG_WARN,
+                           "🛟 No priority broker answers → fallback broker " + fallbackIP + ":" + String(fallbackPort));
+
+                pendingBrokerIP = fallbackIP;
+                pendingBrokerPort = fallbackPort;
+                commitPendingBroker();
+                setupMQTTClient(currentBrokerIP, currentBrokerPort);
+
+                failoverInProgress = false;
+                return;
+            }
+        }
+
+        if (nextIndex < 0)
+        {
+            nextIndex = currentPriorityIndex + 1; // nobody answered → rotate
+            if (nextIndex >= mqttPriorityCount)
+                nextIndex = 0;
+        }
+
+        currentPriorityIndex = nextIndex;
+        SmartCore_BrokerHealth::persist(true); // what we learned led to a switch — keep it
+
+        String nextIP = mqttPriorityList[currentPriorityIndex];
+        uint16_t nextPort = mqtt_port;
+
+        logMessage(LOG_INFO,
+                   "🔄 Next priority broker → " + nextIP + ":" + String(nextPort));
+
         // ---------------------------------------------------------
         // CASE 1 — Non-SmartBox modules
         // ---------------------------------------------------------
@@ -277,6 +501,7 @@ namespace SmartCore_MQTT
             pendingBrokerPort = nextPort;
 
             commitPendingBroker();
+            SmartCore_MQTTConn::connectTo(currentPriorityIndex);
 
             failoverInProgress = false;
             return;
@@ -317,6 +542,7 @@ namespace SmartCore_MQTT
                 logMessage(LOG_INFO,
                            "✅ ACK from Pi. SmartBox promoted to PRIMARY.");
                 commitPendingBroker();
+                SmartCore_MQTTConn::connectTo(currentPriorityIndex);
             }
 
             failoverInProgress = false;
@@ -349,6 +575,7 @@ namespace SmartCore_MQTT
             logMessage(LOG_INFO,
                        "✅ ACK from Pi. Switching MQTT → " + pendingBrokerIP);
             commitPendingBroker();
+            SmartCore_MQTTConn::connectTo(currentPriorityIndex);
         }
 
         failoverInProgress = false;
@@ -378,11 +605,11 @@ namespace SmartCore_MQTT
     //  IMPORTANT NOTES:
     //
     //   • This function *does NOT* connect to MQTT.
-    //       The wifiMqttCheckTask() will automatically attempt a reconnect on the next cycle.
+    //       The failover engine follows up with SmartCore_MQTTConn::connectTo().
     //
     //   • This function does NOT persist the priority index.
     //       That is done only when connection SUCCESSFULLY happens:
-    //             → inside onMqttConnect()
+    //             → by SmartCore_MQTTConn once the connect plan succeeds
     //
     //   • pendingBrokerIP allows safe staging:
     //       We never modify the active broker until the Pi confirms the failover.
@@ -408,10 +635,27 @@ namespace SmartCore_MQTT
         pendingBrokerPort = 0;
     }
 
+    // Everything a module listens to. The hot standby subscribes the same set, so a
+    // promoted standby misses nothing the active client would have received.
+    void subscribeModuleTopics(AsyncMqttClient *client)
+    {
+        // Module-specific topic: serialNumber/#
+        String serialTopic = String(serialNumber) + "/#";
+        client->subscribe(serialTopic.c_str(), 1);
+
+        // Global update topic
+        client->subscribe("update/#", 1);
+
+        // Reconnect slot hint (retained — arrives right away if the broker host sets one)
+        client->subscribe(RECONNECT_ADMISSION_TOPIC, 0);
+    }
+
     void onMqttConnect(bool sessionPresent)
     {
         Serial.println("Connected to MQTT broker.");
         mqttIsConnected = true;
+        SmartCore_MQTTConn::onConnected();
+        SmartCore_Liveness::sessionStarted();
         
         if (SmartCore_System::bootSafeMode && !safeBootErrorSent)
         {
@@ -459,19 +703,27 @@ namespace SmartCore_MQTT
             );
         }
 
-        // Subscribe to module-specific topic: serialNumber/#
-        String serialTopic = String(serialNumber) + "/#";
-        mqttClient->subscribe(serialTopic.c_str(), 1);
-        Serial.print("✅ Subscribed to ");
-        Serial.println(serialTopic);
+        // Persistent session survived → the broker still has our subscriptions and
+        // is already replaying what it queued for us (through the normal handler
+        // path, in order). Only valid if they were made for the current serial.
+        static String subscribedSerial;
+        bool resumed = sessionPresent && subscribedSerial == serialNumber;
+
+        if (resumed)
+        {
+            logMessage(LOG_INFO, "♻️ MQTT session resumed — subscriptions kept, not re-subscribing");
+        }
+        else
+        {
+            subscribeModuleTopics(mqttClient);
+            Serial.println("✅ Subscribed to " + String(serialNumber) + "/#, update/#, " RECONNECT_ADMISSION_TOPIC);
 
-        // Subscribe to global update topic
-        mqttClient->subscribe("update/#", 1);
-        Serial.println("✅ Subscribed to update/#");
+            subscribedSerial = serialNumber;
+        }
 
-        // Publish initial presence messages
+        // Publish initial presence messages (always — the will may have fired meanwhile)
         mqttSafePublish((String(mqttPrefix) + "/connected").c_str(), 1, true, "connected");
-        requestSmartBoatTime();
+        // SmartBoat time: the time sync task runs a round as soon as it starts (below)
 
         logMessage(LOG_INFO, "🔍 firstWifiCOnnect: " + String(firstWiFiConnect ? "true" : "false"));
         if (firstWiFiConnect)
@@ -547,89 +799,466 @@ namespace SmartCore_MQTT
             Serial.println("🕓 Time sync task started");
         }
 
-        // -------------------------------------------------------------
-        // Persist current priority index AFTER SUCCESSFUL MQTT CONNECT
-        // -------------------------------------------------------------
-        if (SmartCore_MQTT::failoverInProgress)
+        // Priority index is persisted by SmartCore_MQTTConn once a connect plan succeeds
+    }
+
+    // ======================================================================================
+    //  INBOUND REASSEMBLY
+    // ======================================================================================
+    //
+    //  AsyncMqttClient hands over a PUBLISH payload as it comes off TCP: (index, total)
+    //  say where this piece belongs. Anything bigger than one segment — config documents,
+    //  rule sets, alarm tables — arrives in several calls.
+    //
+    //      index == 0 && len == total  → copied once and queued for the worker
+    //      otherwise                   → copied into a receive slot sized by total,
+    //                                    queued (buffer and all) once the last byte lands
+    //
+    //  • At most MQTT_RX_SLOTS messages are in flight; a slot idle for
+    //    MQTT_RX_STALE_MS (broker dropped mid-message) is reclaimed.
+    //  • total > MQTT_RX_MAX_PAYLOAD is rejected on the first piece, before any
+    //    allocation; the remaining pieces simply find no slot and are ignored.
+    //  • Only routed subtopics are ever buffered.
+    //
+    // ======================================================================================
+
+    struct RxSlot
+    {
+        uint32_t topicHash;
+        char *buffer;
+        size_t total;
+        size_t filled;
+        uint32_t lastMs;
+    };
+
+    static RxSlot rxSlots[MQTT_RX_SLOTS];
+    static MqttRxStats rxStats = {};
+
+    const MqttRxStats &getRxStats()
+    {
+        return rxStats;
+    }
+
+    static uint32_t hashTopic(const char *topic)
+    {
+        return SmartCore_Hash::fnv1a(topic);
+    }
+
+    static void releaseRxSlot(RxSlot &slot)
+    {
+        free(slot.buffer);
+        slot.buffer = nullptr;
+        slot.filled = 0;
+        slot.total = 0;
+    }
+
+    static void releaseAllRxSlots()
+    {
+        for (uint8_t i = 0; i < MQTT_RX_SLOTS; i++)
+        {
+            if (rxSlots[i].buffer)
+                releaseRxSlot(rxSlots[i]);
+        }
+    }
+
+    static void dropRx(const char *topic)
+    {
+        rxStats.dropped++;
+        SmartCore_Traffic::dropped(topic, TRAFFIC_IN);
+    }
+
+    // Returns the completed slot once the final piece is in, nullptr otherwise
+    static RxSlot *reassemble(const char *topic, const char *payload, size_t len, size_t index, size_t total)
+    {
+        uint32_t hash = hashTopic(topic);
+        uint32_t now = millis();
+
+        if (index == 0)
         {
-            // Check correctness: ensure we're really connected to a priority IP
-            String connectedIP = SmartCore_MQTT::currentBrokerIP;
-            uint16_t connectedPort = SmartCore_MQTT::currentBrokerPort;
+            rxStats.fragmented++;
 
-            bool match = false;
-            if (SmartCore_MQTT::currentPriorityIndex < mqttPriorityCount)
+            if (total > MQTT_RX_MAX_PAYLOAD)
             {
-                String expectedIP = mqttPriorityList[SmartCore_MQTT::currentPriorityIndex];
-                match = (connectedIP == expectedIP);
+                dropRx(topic);
+                logMessage(LOG_WARN, String("⚠️ MQTT payload on [") + topic + "] too large (" +
+                                         String(total) + " bytes) — dropped");
+                return nullptr;
             }
 
-            if (match)
+            RxSlot *slot = nullptr;
+            for (uint8_t i = 0; i < MQTT_RX_SLOTS && !slot; i++)
             {
-                logMessage(LOG_INFO,
-                           "💾 Persisting MQTT priority index → " +
-                               String(SmartCore_MQTT::currentPriorityIndex));
+                RxSlot &s = rxSlots[i];
+                if (!s.buffer)
+                    slot = &s;
+                else if (s.topicHash == hash || now - s.lastMs > MQTT_RX_STALE_MS)
+                {
+                    // Same topic restarted, or the sender vanished mid-message
+                    rxStats.dropped++; // topic of the abandoned message is unknown here
+                    releaseRxSlot(s);
+                    slot = &s;
+                }
+            }
 
-                SmartCore_EEPROM::writeByteToEEPROM(
-                    MQTT_LAST_PRIORITY_ADDR,
-                    SmartCore_MQTT::currentPriorityIndex);
-                EEPROM.commit();
+            if (!slot)
+            {
+                dropRx(topic);
+                logMessage(LOG_WARN, String("⚠️ No MQTT receive slot free — dropped [") + topic + "]");
+                return nullptr;
             }
-            else
+
+            slot->buffer = (char *)malloc(total + 1);
+            if (!slot->buffer)
             {
-                logMessage(LOG_WARN,
-                           "⚠️ Priority mismatch — NOT saving priority index.");
+                dropRx(topic);
+                logMessage(LOG_ERROR, "❌ Out of memory for MQTT reassembly (" + String(total) + " bytes)");
+                return nullptr;
+            }
+
+            slot->topicHash = hash;
+            slot->total = total;
+            slot->filled = 0;
+        }
+
+        for (uint8_t i = 0; i < MQTT_RX_SLOTS; i++)
+        {
+            RxSlot &s = rxSlots[i];
+            if (!s.buffer || s.topicHash != hash)
+                continue;
+
+            if (s.total != total || s.filled != index || index + len > total)
+            {
+                // Out-of-order or mismatched piece — this message cannot be trusted
+                dropRx(topic);
+                releaseRxSlot(s);
+                return nullptr;
+            }
+
+            memcpy(s.buffer + index, payload, len);
+            s.filled += len;
+            s.lastMs = now;
+
+            if (s.filled < s.total)
+                return nullptr;
+
+            s.buffer[s.total] = '\0';
+            rxStats.reassembled++;
+            return &s;
+        }
+
+        return nullptr; // piece of a message we already rejected
+    }
+
+    // ======================================================================================
+    //  INBOUND WORKER
+    // ======================================================================================
+    //
+    //  Handlers parse 1 KB JSON documents, commit EEPROM, restart, run the OTAdrive HTTP
+    //  check… none of which may happen on the AsyncTCP task (it also carries every
+    //  keepalive). onMqttMessage() therefore only routes and hands over:
+    //
+    //      single piece  → malloc(len + 1) + memcpy          ┐
+    //      reassembled   → the receive buffer itself (moved) ┴→ workQueue → mqttWorkerTask
+    //
+    //  • The queue holds MQTT_WORK_QUEUE_DEPTH messages and at most MQTT_WORK_MAX_BYTES
+    //    of payload. The network task never waits for room:
+    //      QoS 0 → dropped (and counted)
+    //      QoS 1 → already PUBACKed, so it is parked in the spill list
+    //              (MQTT_WORK_SPILL_DEPTH / MQTT_WORK_SPILL_BYTES), e.g. the burst a
+    //              resumed session replays; dropped only once that is full too
+    //    While anything is parked, new messages go behind it (QoS 0 is dropped), and
+    //    the worker drains the queue before the spill list — arrival order holds.
+    //  • Handlers run one at a time, in arrival order, on a MQTT_WORKER_STACK stack.
+    //  • Queue wait and handler time are tracked in MqttRxStats.
+    //  • Every call is wrapped in SmartCore_RPC::begin/end — messages with a reqId
+    //    get correlated replies, and a retried reqId is answered from the cache.
+    //
+    // ======================================================================================
+
+    struct MqttWorkItem
+    {
+        MqttTopicHandler handler;
+        char *payload; // owned by the item, null-terminated
+        size_t len;
+        uint32_t queuedUs;
+        int64_t arrivedUs; // esp_timer µs as the message came off the network
+        bool spilled;
+    };
+
+    static QueueHandle_t workQueue = nullptr;
+    static TaskHandle_t mqttWorkerTaskHandle = nullptr;
+    static volatile size_t workBytes = 0;
+    static portMUX_TYPE workMux = portMUX_INITIALIZER_UNLOCKED;
+
+    // QoS 1 overflow, FIFO; guarded by workMux
+    static MqttWorkItem spill[MQTT_WORK_SPILL_DEPTH];
+    static uint8_t spillHead = 0;
+    static uint8_t spillCount = 0;
+    static size_t spillBytes = 0;
+
+    static int64_t currentArrivalUs = 0; // of the message being handled
+
+    uint8_t workQueueDepth()
+    {
+        return (workQueue ? uxQueueMessagesWaiting(workQueue) : 0) + spillCount;
+    }
+
+    int64_t messageArrivalUs()
+    {
+        return currentArrivalUs;
+    }
+
+    // Takes ownership of payload (freed here if it can't be queued → false).
+    // Never blocks — this runs on the AsyncTCP task.
+    static bool queueWork(MqttTopicHandler handler, char *payload, size_t len, uint8_t qos, int64_t arrivedUs)
+    {
+        MqttWorkItem item = {handler, payload, len, (uint32_t)micros(), arrivedUs, false};
+        bool queued = false;
+
+        portENTER_CRITICAL(&workMux);
+        bool spilling = spillCount > 0;
+        if (!spilling && workBytes + len + 1 <= MQTT_WORK_MAX_BYTES)
+        {
+            workBytes += len + 1;
+            queued = true;
+        }
+        portEXIT_CRITICAL(&workMux);
+
+        if (queued && (!workQueue || xQueueSend(workQueue, &item, 0) != pdTRUE))
+        {
+            portENTER_CRITICAL(&workMux);
+            workBytes -= len + 1;
+            portEXIT_CRITICAL(&workMux);
+            queued = false;
+        }
+
+        if (!queued && qos && workQueue)
+        {
+            item.spilled = true;
+
+            portENTER_CRITICAL(&workMux);
+            if (spillCount < MQTT_WORK_SPILL_DEPTH && spillBytes + len + 1 <= MQTT_WORK_SPILL_BYTES)
+            {
+                spill[(spillHead + spillCount) % MQTT_WORK_SPILL_DEPTH] = item;
+                spillCount++;
+                spillBytes += len + 1;
+                queued = true;
             }
+            portEXIT_CRITICAL(&workMux);
 
-            SmartCore_MQTT::failoverInProgress = false;
+            if (queued)
+                rxStats.spilled++;
         }
+
+        if (!queued)
+        {
+            free(payload);
+            rxStats.queueDropped++;
+            Serial.printf("⚠️ MQTT worker busy — message dropped (%u bytes, QoS %u)\n", (unsigned)len, qos);
+            return false;
+        }
+
+        uint8_t depth = workQueueDepth();
+        if (depth > rxStats.queueHighWater)
+            rxStats.queueHighWater = depth;
+
+        if (mqttWorkerTaskHandle)
+            xTaskNotifyGive(mqttWorkerTaskHandle);
+        return true;
+    }
+
+    // Queue first: everything in it arrived before anything that was spilled
+    static bool nextWork(MqttWorkItem &item)
+    {
+        if (xQueueReceive(workQueue, &item, 0) == pdTRUE)
+            return true;
+
+        bool got = false;
+        portENTER_CRITICAL(&workMux);
+        if (spillCount)
+        {
+            item = spill[spillHead];
+            spillHead = (spillHead + 1) % MQTT_WORK_SPILL_DEPTH;
+            spillCount--;
+            got = true;
+        }
+        portEXIT_CRITICAL(&workMux);
+        return got;
+    }
+
+    static void mqttWorkerTask(void *parameter)
+    {
+        MqttWorkItem item;
+
+        for (;;)
+        {
+            if (!nextWork(item))
+            {
+                ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+                continue;
+            }
+
+            uint32_t startUs = micros();
+            uint32_t waitUs = startUs - item.queuedUs;
+            if (waitUs > rxStats.waitMaxUs)
+                rxStats.waitMaxUs = waitUs;
+
+            currentArrivalUs = item.arrivedUs;
+            if (SmartCore_RPC::begin(item.payload, item.len))
+            {
+                item.handler(item.payload, item.len);
+                SmartCore_RPC::end();
+            }
+
+            uint32_t tookUs = micros() - startUs;
+            rxStats.handlerLastUs = tookUs;
+            if (tookUs > rxStats.handlerMaxUs)
+                rxStats.handlerMaxUs = tookUs;
+            rxStats.handled++;
+
+            free(item.payload);
+
+            // Spilled bytes stay charged until handled, so the spill list cannot
+            // be refilled faster than the worker gets through it
+            portENTER_CRITICAL(&workMux);
+            if (item.spilled)
+                spillBytes -= item.len + 1;
+            else
+                workBytes -= item.len + 1;
+            portEXIT_CRITICAL(&workMux);
+        }
+    }
+
+    static void startMqttWorker()
+    {
+        if (mqttWorkerTaskHandle)
+            return;
+
+        workQueue = xQueueCreate(MQTT_WORK_QUEUE_DEPTH, sizeof(MqttWorkItem));
+        if (!workQueue)
+        {
+            logMessage(LOG_ERROR, "❌ Failed to create MQTT work queue");
+            return;
+        }
+
+        xTaskCreatePinnedToCore(mqttWorkerTask, "MQTT Worker", MQTT_WORKER_STACK, NULL, 1,
+                                &mqttWorkerTaskHandle, 1);
+        logMessage(LOG_INFO, "🧵 MQTT worker task started");
+    }
+
+    // Same message via active and standby broker → only the first copy is handled.
+    // Frees payload when it was a duplicate.
+    static bool suppressDuplicate(const AsyncMqttClient *source, const char *topic, char *payload, size_t len)
+    {
+#ifdef MQTT_HOT_STANDBY
+        if (SmartCore_Standby::live() && SmartCore_Standby::isDuplicate(source, topic, payload, len))
+        {
+            free(payload);
+            return true;
+        }
+#endif
+        return false;
     }
 
     void onMqttMessage(char *topic, char *payload, AsyncMqttClientMessageProperties properties,
-                       size_t len, size_t index, size_t total)
+                       size_t len, size_t index, size_t total, AsyncMqttClient *source)
     {
-        // ✅ Safely copy payload into null-terminated buffer
-        char safePayload[len + 1];
-        memcpy(safePayload, payload, len);
-        safePayload[len] = '\0';
-
-        String message = String(safePayload);
-        Serial.printf("📨 MQTT Message on [%s]: %s\n", topic, message.c_str());
-
-        String topicStr = String(topic);
-
-        // 🔍 Define all expected topics
-        String expectedConfigTopic = String(serialNumber) + "/config";
-        String expectedErrorsTopic = String(serialNumber) + "/errors";
-        String expectedModuleTopic = String(serialNumber) + "/module";
-        String expectedResetTopic = String(serialNumber) + "/reset";
-        String expectedUpgradeTopic = String(serialNumber) + "/upgrade";
-        String expectedUpdateTopic = String(serialNumber) + "/update";
-
-        // 🧭 Route to appropriate handlers
-        if (topicStr == expectedConfigTopic)
-            handleConfigMessage(message);
-        else if (topicStr == expectedErrorsTopic)
-            handleErrorMessage(message);
-        else if (topicStr == expectedModuleTopic)
-            handleModuleMessage(message);
-        else if (topicStr == expectedResetTopic)
-            handleResetMessage(message);
-        else if (topicStr == expectedUpgradeTopic)
-            handleUpgradeMessage(message);
-        else if (topicStr == expectedUpdateTopic)
-            handleUpdateMessage(message);
+        int64_t arrivedUs = esp_timer_get_time(); // t4 of a time sync reply
+
+        if (!source)
+            source = mqttClient;
+
+        if (index == 0)
+            SmartCore_Traffic::count(topic, TRAFFIC_IN, total);
+
+        // 💓 Liveness echo — timed right here, never queued behind other work
+        if (index == 0 && len == total && topicPrefixLen &&
+            !strncmp(topic, topicPrefix, topicPrefixLen) &&
+            !strcmp(topic + topicPrefixLen, LIVENESS_SUBTOPIC))
+        {
+            SmartCore_Liveness::onEcho(payload, len);
+            return;
+        }
+
+        if (index == 0)
+        {
+            rxStats.messages++;
+            Serial.printf("📨 MQTT Message on [%s] (%u bytes)\n", topic, (unsigned)total);
+        }
+
+        MqttTopicHandler handler = nullptr;
+
+        if (!strcmp(topic, RECONNECT_ADMISSION_TOPIC))
+        {
+            handler = SmartCore_Reconnect::handleAdmission; // fleet-wide, retained
+        }
         else
-            Serial.printf("❓ Unknown subtopic on [%s]\n", topicStr.c_str());
+        {
+            // 🧭 "<serialNumber>/" prefix, then one compare per registered subtopic
+            if (topicPrefixLen == 0 || strncmp(topic, topicPrefix, topicPrefixLen) != 0)
+            {
+                if (index == 0)
+                    Serial.printf("❓ Unrouted topic [%s]\n", topic);
+                return;
+            }
+
+            const char *subtopic = topic + topicPrefixLen;
+            size_t subtopicLen = strlen(subtopic);
+
+            for (uint8_t i = 0; i < topicRouteCount && !handler; i++)
+            {
+                if (topicRoutes[i].len == subtopicLen && !memcmp(topicRoutes[i].subtopic, subtopic, subtopicLen))
+                    handler = topicRoutes[i].handler;
+            }
+
+            if (!handler)
+            {
+                if (index == 0)
+                    Serial.printf("❓ Unknown subtopic on [%s]\n", topic);
+                return;
+            }
+        }
+
+        // Whole message in one piece — one copy, straight to the worker
+        if (index == 0 && len == total)
+        {
+            char *copy = (char *)malloc(len + 1);
+            if (!copy)
+            {
+                dropRx(topic);
+                return;
+            }
+
+            memcpy(copy, payload, len);
+            copy[len] = '\0';
+            if (!suppressDuplicate(source, topic, copy, len) && !queueWork(handler, copy, len, properties.qos, arrivedUs))
+                SmartCore_Traffic::dropped(topic, TRAFFIC_IN);
+            return;
+        }
+
+        RxSlot *complete = reassemble(topic, payload, len, index, total);
+        if (complete)
+        {
+            // Hand the receive buffer over instead of copying it again
+            char *buffer = complete->buffer;
+            size_t size = complete->total;
+
+            complete->buffer = nullptr;
+            releaseRxSlot(*complete);
+            if (!suppressDuplicate(source, topic, buffer, size) && !queueWork(handler, buffer, size, properties.qos, arrivedUs))
+                SmartCore_Traffic::dropped(topic, TRAFFIC_IN);
+        }
     }
 
-    void handleConfigMessage(const String &message)
+    void handleConfigMessage(const char *payload, size_t len)
     {
         StaticJsonDocument<1024> doc;
-        DeserializationError error = deserializeJson(doc, message);
+        DeserializationError error = deserializeJson(doc, payload, len);
 
         if (error)
         {
             Serial.printf("❌ Failed to parse config JSON: %s\n", error.c_str());
+            SmartCore_RPC::fail("bad JSON");
             return;
         }
 
@@ -637,6 +1266,7 @@ namespace SmartCore_MQTT
         if (type.isEmpty())
         {
             Serial.println("⚠️ Config message missing 'type' field.");
+            SmartCore_RPC::fail("missing type");
             return;
         }
 
@@ -653,7 +1283,7 @@ namespace SmartCore_MQTT
 
             String payload;
             serializeJson(response, payload);
-            mqttSafePublish("module/config/update", 1, true, payload.c_str());
+            SmartCore_RPC::respond("module/config/update", 1, true, payload.c_str());
             Serial.println("✅ Published generic module config");
 
             // ✅ Forward object to module-specific handler too
@@ -689,46 +1319,60 @@ namespace SmartCore_MQTT
                 Serial.println("💾 Generic config updated and saved.");
 
             // ✅ Re-publish the updated config
-            handleConfigMessage("{\"type\":\"getConfig\"}");
+            static const char getConfig[] = "{\"type\":\"getConfig\"}";
+            handleConfigMessage(getConfig, sizeof(getConfig) - 1);
         }
         else if (type == "setModuleConfig")
         {
             handleModuleSpecificConfig(doc.as<JsonObject>());
         }
+        else if (type == "setMetrics")
+        {
+            // Not persisted — diagnostics for this boot only
+            uint16_t mask = 0;
+            for (JsonVariantConst v : doc["families"].as<JsonArrayConst>())
+                mask |= SmartCore_Metrics::familyFromName(v | "");
+
+            SmartCore_Metrics::setFamilies(mask);
+            logMessage(LOG_INFO, "📊 Metric families set to 0x" + String(mask, HEX));
+        }
         else
         {
             Serial.printf("⚠️ Unknown config message type: '%s'\n", type.c_str());
+            SmartCore_RPC::fail("unknown type");
         }
 
         checkForUpgrade(false);
     }
 
-    void handleModuleMessage(const String &message)
+    void handleModuleMessage(const char *payload, size_t len)
 {
     StaticJsonDocument<512> doc;
-    DeserializationError error = deserializeJson(doc, message);
+    DeserializationError error = deserializeJson(doc, payload, len);
 
     if (error)
     {
         logMessage(LOG_WARN, "❌ Failed to parse module JSON");
+        SmartCore_RPC::fail("bad JSON");
         return;
     }
 
     handleModuleSpecificModule(doc.as<JsonObject>());
 }
 
-    void handleErrorMessage(const String &message)
+    void handleErrorMessage(const char *payload, size_t len)
     {
         Serial.println("message arrived for errors");
         Serial.printf("bootSafeMode=%d\n", SmartCore_System::bootSafeMode);
-        handleModuleSpecificErrors(message);  // <<-- incase module specific error code required
+        handleModuleSpecificErrors(payload, len);  // <<-- incase module specific error code required
 
         StaticJsonDocument<256> doc;
-        DeserializationError err = deserializeJson(doc, message);
+        DeserializationError err = deserializeJson(doc, payload, len);
 
         if (err)
         {
             logMessage(LOG_WARN, "❌ Invalid error control JSON");
+            SmartCore_RPC::fail("bad JSON");
             return;
         }
 
@@ -747,6 +1391,8 @@ namespace SmartCore_MQTT
             // Perform non-destructive reset
             SmartCore_EEPROM::resetParameters(true);  // 👈 SOFT RESET
 
+            SmartCore_RPC::complete(); // we never return to the worker
+
             delay(300);
             ESP.restart();
         } else if (!strcmp(action, "safeFirmware"))
@@ -759,6 +1405,7 @@ namespace SmartCore_MQTT
             if (SmartCore_OTA::otaInProgress)
             {
                 logMessage(LOG_WARN, "⚠️ OTA already in progress — ignoring request");
+                SmartCore_RPC::fail("OTA in progress");
                 return;
             }
 
@@ -788,16 +1435,17 @@ namespace SmartCore_MQTT
         }
     }
 
-    void handleResetMessage(const String &message)
+    void handleResetMessage(const char *payload, size_t len)
     {
         Serial.println("🔄 Reset message received");
         StaticJsonDocument<256> doc;
-        DeserializationError error = deserializeJson(doc, message);
+        DeserializationError error = deserializeJson(doc, payload, len);
 
         if (error)
         {
             Serial.print("❌ Failed to parse reset JSON: ");
             Serial.println(error.c_str());
+            SmartCore_RPC::fail("bad JSON");
             return;
         }
 
@@ -813,25 +1461,28 @@ namespace SmartCore_MQTT
             else
             {
                 Serial.println("⚠️ Reset requested but not confirmed. Ignoring.");
+                SmartCore_RPC::fail("not confirmed");
             }
         }
         else
         {
             Serial.println("⚠️ Unsupported action in reset message.");
+            SmartCore_RPC::fail("unsupported action");
         }
     }
 
-    void handleUpgradeMessage(const String &message)
+    void handleUpgradeMessage(const char *payload, size_t len)
     {
         Serial.println("⬆️ OTA upgrade message received");
 
         StaticJsonDocument<256> doc;
-        DeserializationError error = deserializeJson(doc, message);
+        DeserializationError error = deserializeJson(doc, payload, len);
 
         if (error)
         {
             Serial.print("❌ Failed to parse upgrade JSON: ");
             Serial.println(error.c_str());
+            SmartCore_RPC::fail("bad JSON");
             return;
         }
 
@@ -852,6 +1503,7 @@ namespace SmartCore_MQTT
             else
             {
                 Serial.println("⚠️ Upgrade requested but not confirmed. Ignoring.");
+                SmartCore_RPC::fail("not confirmed");
             }
         }
         else if (action == "checkUpdateAvailable")
@@ -863,6 +1515,7 @@ namespace SmartCore_MQTT
         else
         {
             Serial.println("⚠️ Unsupported action in upgrade message.");
+            SmartCore_RPC::fail("unsupported action");
         }
     }
 
@@ -886,7 +1539,12 @@ namespace SmartCore_MQTT
 
             if (mqttIsConnected && mqttClient)
             {
-                mqttSafePublish("module/upgrade", 0, false, responseJson.c_str());
+                // An explicit check answers its request; the one after every config
+                // message is a background notice on the legacy topic
+                if (notify)
+                    SmartCore_RPC::respond("module/upgrade", 0, false, responseJson.c_str());
+                else
+                    mqttSafePublish("module/upgrade", 0, false, responseJson.c_str());
             }
             Serial.println("✅ OTA check response published.");
     }
@@ -896,7 +1554,8 @@ namespace SmartCore_MQTT
         uint8_t qos,
         bool retain,
         const char* payload,
-        size_t len
+        size_t len,
+        PublishPriority prio
     ) {
         if (!mqttClient || !mqttIsConnected)
             return false;
@@ -904,38 +1563,58 @@ namespace SmartCore_MQTT
         if (SmartCore_OTA::otaInProgress)
             return false;
 
-        
-    if (len > 0)
-        return mqttClient->publish(topic, qos, retain, payload, len);
-    else
-        return mqttClient->publish(topic, qos, retain, payload);
+        // Queued for the publish task — the only place mqttClient->publish() is called
+        return SmartCore_Publisher::submit(topic, qos, retain, payload, len, prio);
     }
 
 
-    void handleUpdateMessage(const String &message)
+    bool mqttStoreAndForward(
+        OutboxClass cls,
+        const char *topic,
+        uint8_t qos,
+        bool retain,
+        const char *payload,
+        size_t len)
+    {
+        PublishPriority prio = cls == OUTBOX_ALARM ? PUB_PRIO_HIGH : PUB_PRIO_TELEMETRY;
+
+        // Go live only when nothing older of this class is still queued — keeps order.
+        // If the link drops before it is sent, the publish task hands it back to the outbox.
+        if (SmartCore_Outbox::pending(cls) == 0 && mqttIsConnected && !SmartCore_OTA::otaInProgress &&
+            SmartCore_Publisher::submit(topic, qos, retain, payload, len, prio, cls))
+            return true;
+
+        return SmartCore_Outbox::enqueue(cls, topic, qos, retain, payload, len);
+    }
+
+    void handleUpdateMessage(const char *payload, size_t len)
     {
         Serial.println("🛠️ Update message received");
 
         StaticJsonDocument<256> doc;
-        DeserializationError error = deserializeJson(doc, message);
+        DeserializationError error = deserializeJson(doc, payload, len);
 
         if (error)
         {
             Serial.print("❌ Failed to parse update JSON: ");
             Serial.println(error.c_str());
+            SmartCore_RPC::fail("bad JSON");
             return;
         }
 
-        // ✅ Check for SmartBoat time sync
-        if (doc.containsKey("update") &&
-            doc["update"] == "time" &&
-            doc.containsKey("epoch") &&
-            awaitingSmartboatTimeSync)
+        // ✅ Check for SmartBoat time sync — t1..t4 exchange, or the older epoch-only reply
+        if (doc["update"] == "time" && doc.containsKey("t1") && doc.containsKey("t2") && doc.containsKey("t3"))
         {
+            // t2 / t3 in epoch ms (fractions allowed) → µs
+            int64_t t2 = llround(doc["t2"].as<double>() * 1000.0);
+            int64_t t3 = llround(doc["t3"].as<double>() * 1000.0);
 
-            smartBoatEpoch = doc["epoch"]; // assumed to be unsigned long / uint32_t
-            smartBoatEpochSyncMillis = millis();
-            awaitingSmartboatTimeSync = false;
+            if (!SmartCore_Time::onReply(doc["t1"].as<int64_t>(), t2, t3, messageArrivalUs()))
+                Serial.println("⚠️ Time sync reply unmatched or unusable — ignored");
+        }
+        else if (doc["update"] == "time" && doc.containsKey("epoch") && awaitingSmartboatTimeSync)
+        {
+            SmartCore_Time::onLegacyEpoch(doc["epoch"].as<uint32_t>());
 
             Serial.printf("🕒 Received SmartBoat time: %lu (syncMillis: %lu)\n",
                           smartBoatEpoch, smartBoatEpochSyncMillis);
@@ -943,12 +1622,30 @@ namespace SmartCore_MQTT
         else
         {
             Serial.println("⚠️ Unrecognized update message or already synced.");
+            SmartCore_RPC::fail("not applied");
         }
     }
 
     void onMqttDisconnect(AsyncMqttClientDisconnectReason reason)
     {
+        bool wasConnected = mqttIsConnected;
+
         mqttIsConnected = false; // Update connection state
+        releaseAllRxSlots();     // half-received messages will never complete
+        SmartCore_Publisher::onDisconnect();
+
+#ifdef MQTT_HOT_STANDBY
+        // Standby session ready → swap it in; nothing else has to restart
+        if (wasConnected && !switchingBroker && SmartCore_Standby::promote())
+        {
+            mqttIsConnected = true;
+            SmartCore_Liveness::sessionStarted();
+            mqttSafePublish((String(mqttPrefix) + "/connected").c_str(), 1, true, "connected");
+            return;
+        }
+#endif
+
+        SmartCore_MQTTConn::onDisconnected();
         logMessage(LOG_WARN, "❌ Disconnected from MQTT (" + String((int)reason) + ", " + mqttDisconnectReasonToStr(reason) + ")");
         SmartCore_LED::currentLEDMode = LEDMODE_STATUS;
 
@@ -1004,19 +1701,9 @@ namespace SmartCore_MQTT
         //int* ptr = nullptr;
         //*ptr = 42;  // 💥 Boom
 
-        // Temperature sensor config
-        temp_sensor_config_t temp_sensor = {
-            .dac_offset = TSENS_DAC_L2,
-            .clk_div = 6,
-        };
-        temp_sensor_set_config(temp_sensor);
-        temp_sensor_start();
+        SmartCore_Metrics::begin();
 
-        char macStr[18];
-        uint8_t mac[6];
-        esp_read_mac(mac, ESP_MAC_WIFI_STA);
-        snprintf(macStr, sizeof(macStr), "%02X:%02X:%02X:%02X:%02X:%02X",
-                 mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
+        static char buffer[METRICS_BUFFER_SIZE];
 
         for (;;)
         {
@@ -1026,50 +1713,42 @@ namespace SmartCore_MQTT
                 vTaskDelete(nullptr);
             }
 
-            StaticJsonDocument<384> doc;
-
-            doc["serialNumber"] = serialNumber;
-            JsonObject metrics = doc.createNestedObject("metrics");
-
-            metrics["mac"] = macStr;
-            metrics["ip"] = WiFi.localIP().toString();
-            metrics["uptime"] = millis() / 1000;
-
-            float tempC;
-            if (temp_sensor_read_celsius(&tempC) == ESP_OK)
+            size_t len = SmartCore_Metrics::collect(buffer, sizeof(buffer));
+            if (len)
             {
-                metrics["tempC"] = tempC;
+                // NORMAL, not TELEMETRY: the report is bigger than a small slot, and
+                // telemetry may only use small slots
+                if (mqttSafePublish("module/metrics", 0, false, buffer, len, PUB_PRIO_NORMAL))
+                    logMessage(LOG_INFO, "📤 Metrics sent (" + String((unsigned)len) + " bytes)");
+                else
+                    logMessage(LOG_WARN, "⚠️ Metrics not queued (" + String((unsigned)len) + " bytes)");
             }
-            else
-            {
-                metrics["tempC"] = nullptr;
-            }
-
-            metrics["heap"] = ESP.getFreeHeap();
-            metrics["rssi"] = WiFi.RSSI();
-
-            char buffer[512];
-            size_t len = serializeJson(doc, buffer);
 
-            mqttSafePublish("module/metrics", 0, false, buffer, len);
-            logMessage(LOG_INFO, "📤 Metrics sent → " + String(buffer));
-
-            vTaskDelay(10000 / portTICK_PERIOD_MS); // 10s loop
+            // 10s loop, stretched while the link is congested
+            vTaskDelay(pdMS_TO_TICKS(SmartCore_Publisher::telemetryInterval(METRICS_INTERVAL_MS)));
         }
     }
 
     void timeSyncTask(void *parameter)
     {
-        const TickType_t delay = pdMS_TO_TICKS(3600000); // 1 hour = 3600000 ms
-
         for (;;)
         {
             if (mqttIsConnected)
             {
-                Serial.println("🕓 Hourly SmartBoat time sync...");
-                requestSmartBoatTime();
+                // A burst of exchanges; SmartCore_Time keeps the one with the lowest RTT
+                for (uint8_t i = 0; i < TIMESYNC_BURST && mqttIsConnected; i++)
+                {
+                    requestSmartBoatTime();
+                    vTaskDelay(pdMS_TO_TICKS(TIMESYNC_BURST_SPACING_MS));
+                }
+
+                vTaskDelay(pdMS_TO_TICKS(TIMESYNC_ROUND_WAIT_MS));
+
+                if (!SmartCore_Time::endRound())
+                    Serial.println("⚠️ SmartBoat time sync round got no usable reply");
             }
-            vTaskDelay(delay);
+
+            vTaskDelay(pdMS_TO_TICKS(smartBoatTimeValid() ? TIMESYNC_INTERVAL_MS : TIMESYNC_RETRY_MS));
         }
     }
 
@@ -1078,14 +1757,20 @@ namespace SmartCore_MQTT
         StaticJsonDocument<128> doc;
         doc["serialNumber"] = serialNumber;
         doc["action"] = "gettime";
+        int64_t t1 = SmartCore_Time::beginExchange();
+        doc["t1"] = t1; // echoed back with t2 / t3
 
         char payload[128];
-        serializeJson(doc, payload, sizeof(payload));
+        size_t len = serializeJson(doc, payload, sizeof(payload));
 
-        mqttSafePublish("module/update", 1, false, payload);
-        awaitingSmartboatTimeSync = true;
+        if (!mqttClient || !mqttIsConnected || SmartCore_OTA::otaInProgress)
+            return;
 
-        Serial.println("📡 Time sync requested via module/update");
+        // QoS 0, high priority: a retransmitted or queued request only adds skew.
+        // The real t1 is stamped by the publish task as it goes out.
+        SmartCore_Publisher::submit("module/update", 0, false, payload, len, PUB_PRIO_HIGH,
+                                    PUBLISH_NO_STORE, SmartCore_Time::onRequestSent, t1);
+        awaitingSmartboatTimeSync = true;
     }
 
     void hardResetClient()
@@ -1110,13 +1795,6 @@ void publishModuleError(
     const String &status
 )
 {
-    if (!mqttIsConnected || !mqttClient)
-    {
-        logMessage(LOG_WARN,
-            "⚠️ Cannot publish module/error (MQTT offline)");
-        return;
-    }
-
     StaticJsonDocument<256> doc;
     doc["serialNumber"] = serialNumber;
     doc["error"]        = message;
@@ -1128,12 +1806,18 @@ void publishModuleError(
     String payload;
     serializeJson(doc, payload);
 
-    mqttSafePublish(
-        "module/error",
-        1,          // QoS
-        false,      // NOT retained
-        payload.c_str()
-    );
+    // Offline → kept in the outbox and replayed ahead of telemetry
+    if (!mqttStoreAndForward(
+            OUTBOX_ALARM,
+            "module/error",
+            1,          // QoS
+            false,      // NOT retained
+            payload.c_str()))
+    {
+        logMessage(LOG_WARN,
+            "⚠️ Cannot publish or store module/error → " + message);
+        return;
+    }
 
     logMessage(LOG_WARN,
         "🚨 module/error sent → " + message);
@@ -2,6 +2,70 @@
 
 #include <Arduino.h>
 #include <AsyncMqttClient.h>
+#include "SmartCore_Outbox.h"
+#include "SmartCore_Publisher.h"
+
+// Inbound topic router limits (override externally if needed)
+#ifndef MQTT_MAX_TOPIC_HANDLERS
+#define MQTT_MAX_TOPIC_HANDLERS 16
+#endif
+#define MQTT_SUBTOPIC_LEN 24
+
+// MQTT keepalive: the client pings within this window and drops a silent broker;
+// the broker fires our will after 1.5×. Stalled-but-connected brokers are caught
+// sooner by SmartCore_Liveness.
+#ifndef MQTT_KEEPALIVE_S
+#define MQTT_KEEPALIVE_S 10
+#endif
+
+// Persistent session (clean session off, client ID = MAC): the broker keeps our
+// subscriptions and queues QoS 1 messages while we are away
+#ifndef MQTT_PERSISTENT_SESSION
+#define MQTT_PERSISTENT_SESSION 1
+#endif
+
+// Inbound reassembly of payloads split across TCP segments
+#ifndef MQTT_RX_MAX_PAYLOAD
+#define MQTT_RX_MAX_PAYLOAD 8192 // larger messages are rejected on the first piece
+#endif
+#ifndef MQTT_RX_SLOTS
+#define MQTT_RX_SLOTS 2 // messages being reassembled at once
+#endif
+#define MQTT_RX_STALE_MS 5000
+
+// Inbound handlers run on a worker task, not on the AsyncTCP callback
+#ifndef MQTT_WORK_QUEUE_DEPTH
+#define MQTT_WORK_QUEUE_DEPTH 8
+#endif
+#ifndef MQTT_WORK_MAX_BYTES
+#define MQTT_WORK_MAX_BYTES (16 * 1024) // payload bytes waiting in the queue
+#endif
+#ifndef MQTT_WORK_SPILL_DEPTH
+#define MQTT_WORK_SPILL_DEPTH 16 // QoS 1 messages parked when the queue is full
+#endif
+#ifndef MQTT_WORK_SPILL_BYTES
+#define MQTT_WORK_SPILL_BYTES (16 * 1024)
+#endif
+#define MQTT_WORKER_STACK 8192            // 1 KB JSON docs + OTAdrive HTTP check
+
+struct MqttRxStats
+{
+    uint32_t messages;      // PUBLISH packets received
+    uint32_t fragmented;    // ...that arrived in more than one piece
+    uint32_t reassembled;   // ...and were put back together
+    uint32_t dropped;       // oversized, out of slots/memory, or incomplete
+    uint32_t handled;       // handler calls completed by the worker
+    uint32_t queueDropped;  // worker queue full / over MQTT_WORK_MAX_BYTES (QoS 1: spill full too)
+    uint32_t spilled;       // QoS 1 messages parked in the spill list
+    uint8_t queueHighWater; // deepest the worker queue has been
+    uint32_t waitMaxUs;     // longest a message waited for the worker
+    uint32_t handlerMaxUs;  // slowest handler call
+    uint32_t handlerLastUs;
+};
+
+// Handler for "<serialNumber>/<subtopic>" — runs on the MQTT worker task; the
+// payload is only valid for the duration of the call
+typedef void (*MqttTopicHandler)(const char *payload, size_t len);
 
 namespace SmartCore_MQTT
 {
@@ -23,25 +87,36 @@ namespace SmartCore_MQTT
 
     extern TaskHandle_t metricsTaskHandle;
     extern TaskHandle_t timeSyncTaskHandle;
-    void setupMQTTClient(const String &ip, uint16_t port);
+    bool setupMQTTClient(const String &ip, uint16_t port); // non-blocking; false if WiFi is down
     void handleMQTTFailover();
     void commitPendingBroker();
     void generateMqttPrefix();
     void onMqttConnect(bool sessionPresent);
-    void onMqttMessage(char *topic, char *payload, AsyncMqttClientMessageProperties properties, size_t len, size_t index, size_t total);
+    void subscribeModuleTopics(AsyncMqttClient *client); // active and hot standby alike
+    // source = the client that delivered it (nullptr = the active one)
+    void onMqttMessage(char *topic, char *payload, AsyncMqttClientMessageProperties properties, size_t len, size_t index, size_t total,
+                       AsyncMqttClient *source = nullptr);
     void onMqttDisconnect(AsyncMqttClientDisconnectReason reason);
     const char *mqttDisconnectReasonToStr(AsyncMqttClientDisconnectReason reason);
     void metricsTask(void *parameter);
-    void handleErrorMessage(const String &message);
-    void handleConfigMessage(const String &message);
-    void handleUpdateMessage(const String &message);
-    void handleUpgradeMessage(const String &message);
-    void handleModuleMessage(const String &message);
-    void handleResetMessage(const String &message);
+    void handleErrorMessage(const char *payload, size_t len);
+    void handleConfigMessage(const char *payload, size_t len);
+    void handleUpdateMessage(const char *payload, size_t len);
+    void handleUpgradeMessage(const char *payload, size_t len);
+    void handleModuleMessage(const char *payload, size_t len);
+    void handleResetMessage(const char *payload, size_t len);
     void requestSmartBoatTime();
     void checkForUpgrade(bool notify);
     void timeSyncTask(void *parameter);
     void hardResetClient();
+    bool registerTopicHandler(const char *subtopic, MqttTopicHandler handler);
+    const MqttRxStats &getRxStats();
+    uint8_t workQueueDepth();
+
+    // esp_timer µs at which the message being handled came off the network
+    // (only meaningful inside a topic handler)
+    int64_t messageArrivalUs();
+
     bool fetchMQTTConfig(String &mqttIp, uint16_t &mqttPort);
     void publishModuleError(
         const String &message,
@@ -55,6 +130,17 @@ namespace SmartCore_MQTT
         uint8_t qos,
         bool retain,
         const char* payload,
+        size_t len = 0,
+        PublishPriority prio = PUB_PRIO_NORMAL
+    );
+
+    // Publish now, or keep it in the LittleFS outbox until the broker is back
+    bool mqttStoreAndForward(
+        OutboxClass cls,
+        const char *topic,
+        uint8_t qos,
+        bool retain,
+        const char *payload,
         size_t len = 0
     );
 }
\ No newline at end of file
@@ -0,0 +1,446 @@
+#include "SmartCore_MQTTConn.h"
+#include <freertos/timers.h>
+#include <AsyncMqttClient.h>
+#include "SmartCore_MQTT.h"
+#include "SmartCore_Network.h"
+#include "SmartCore_EEPROM.h"
+#include "SmartCore_Publisher.h"
+#include "SmartCore_BrokerProbe.h"
+#include "SmartCore_BrokerHealth.h"
+#include "SmartCore_Log.h"
+
+namespace SmartCore_MQTTConn
+{
+    TaskHandle_t connTaskHandle = NULL;
+
+    // ======================================================================================
+    //  MQTT CONNECTION MANAGER
+    // ======================================================================================
+    //
+    //  setupMQTTClient() only configures the client and calls connect(); nothing waits
+    //  for the outcome. The result comes back through the client callbacks and a timer:
+    //
+    //      attemptStarted()  IDLE → CONNECTING, arm connect timer
+    //      onConnected()     CONNECTING → CONNECTED            ─┐
+    //      onDisconnected()  CONNECTING → IDLE (refused/reset)  ├─ notify connTask
+    //      connect timer     CONNECTING → IDLE (timeout)       ─┘
+    //
+    //  Callbacks run on the AsyncTCP / timer tasks, so they only flip the state and
+    //  notify connTask, which does the follow-up work (abort half-open sockets, next
+    //  plan step, persist the priority index).
+    //
+    //  A "plan" is a short list of priority-list entries tried back to back:
+    //
+    //      bootConnect(saved)  → probe all brokers in parallel, then [best responder]
+    //                            nobody answered → [0, saved]
+    //      connectTo(i)        → [i]                (failover — already probed)
+    //
+    //  A refused connection moves to the next step within MQTT_CONN_RETRY_GAP_MS; an
+    //  unreachable broker after MQTT_CONNECT_TIMEOUT_MS. Once a plan runs out,
+    //  wifiMqttCheckTask() takes over with its backoff. While busy() is true it does
+    //  not start attempts of its own.
+    //
+    //  Timing (boot → connected, failover → connected, outage length) is kept in
+    //  MqttConnStats and reported with the metrics.
+    //
+    // ======================================================================================
+
+    enum : uint32_t
+    {
+        EVT_CONNECTED = 1 << 0,
+        EVT_FAILED = 1 << 1,
+        EVT_TIMEOUT = 1 << 2,
+        EVT_RETRY = 1 << 3,
+        EVT_PLAN = 1 << 4,
+        EVT_SKIPPED = 1 << 5, // plan step could not even start an attempt
+        EVT_LOST = 1 << 6,    // an established session ended
+        EVT_ADOPT = 1 << 7    // session moved to another broker (standby promotion)
+    };
+
+    static TimerHandle_t connectTimer = nullptr;
+    static TimerHandle_t retryTimer = nullptr;
+    static portMUX_TYPE connMux = portMUX_INITIALIZER_UNLOCKED;
+
+    static volatile MqttConnState connState = MQTT_CONN_IDLE;
+    static uint32_t attemptStartMs = 0;
+    static uint32_t failoverStartMs = 0;
+    static uint32_t disconnectedAtMs = 0;
+    static uint32_t sessionStartMs = 0;
+    static uint32_t lostSessionMs = 0;
+    static MqttConnStats stats;
+
+    // Plan (owned by connTask once started)
+    static uint8_t plan[MQTT_CONN_PLAN_MAX];
+    static uint8_t planLen = 0;
+    static uint8_t planPos = 0;
+    static volatile bool planActive = false;
+    static bool planProbe = false;   // probe first, then replace the plan with the pick
+    static bool stepRunning = false; // the current attempt was started by the plan
+    static volatile uint8_t adoptedIndex = 0;
+
+    static void notify(uint32_t bits)
+    {
+        if (connTaskHandle)
+            xTaskNotify(connTaskHandle, bits, eSetBits);
+    }
+
+    static void onConnectTimer(TimerHandle_t)
+    {
+        bool expired = false;
+
+        portENTER_CRITICAL(&connMux);
+        if (connState == MQTT_CONN_CONNECTING)
+        {
+            connState = MQTT_CONN_IDLE;
+            stats.timeouts++;
+            stats.failures++;
+            expired = true;
+        }
+        portEXIT_CRITICAL(&connMux);
+
+        if (expired)
+            notify(EVT_TIMEOUT);
+    }
+
+    static void onRetryTimer(TimerHandle_t)
+    {
+        notify(EVT_RETRY);
+    }
+
+    static void startPlan(const uint8_t *steps, uint8_t count, bool probe)
+    {
+        init();
+
+        portENTER_CRITICAL(&connMux);
+        memcpy(plan, steps, count);
+        planLen = count;
+        planPos = 0;
+        planProbe = probe;
+        planActive = true;
+        portEXIT_CRITICAL(&connMux);
+
+        notify(EVT_PLAN);
+    }
+
+    void bootConnect(uint8_t savedIndex)
+    {
+        // Fallback if the probe finds nobody: primary, then the last good backup
+        uint8_t steps[2] = {0, savedIndex};
+        uint8_t count = savedIndex != 0 ? 2 : 1;
+
+        if (savedIndex != 0)
+            logMessage(LOG_INFO,
+                       "🔍 Previously using backup priority " + String(savedIndex) +
+                           ". Probing all brokers...");
+
+        startPlan(steps, count, mqttPriorityCount > 1);
+    }
+
+    void connectTo(uint8_t priorityIndex)
+    {
+        startPlan(&priorityIndex, 1, false);
+    }
+
+    void failoverStarted()
+    {
+        failoverStartMs = millis();
+    }
+
+    void adopted(uint8_t priorityIndex)
+    {
+        portENTER_CRITICAL(&connMux);
+        sessionStartMs = millis();
+        portEXIT_CRITICAL(&connMux);
+
+        adoptedIndex = priorityIndex;
+        notify(EVT_ADOPT); // EEPROM commit must not run on the AsyncTCP task
+    }
+
+    void attemptStarted()
+    {
+        init();
+
+        portENTER_CRITICAL(&connMux);
+        connState = MQTT_CONN_CONNECTING;
+        attemptStartMs = millis();
+        stats.attempts++;
+        portEXIT_CRITICAL(&connMux);
+
+        if (connectTimer)
+            xTimerReset(connectTimer, 0);
+    }
+
+    void onConnected()
+    {
+        uint32_t now = millis();
+
+        portENTER_CRITICAL(&connMux);
+        if (connState == MQTT_CONN_CONNECTING)
+            stats.lastConnectMs = now - attemptStartMs;
+        connState = MQTT_CONN_CONNECTED;
+        sessionStartMs = now;
+
+        if (stats.bootToConnectedMs == 0)
+            stats.bootToConnectedMs = now;
+        if (disconnectedAtMs)
+        {
+            stats.lastOutageMs = now - disconnectedAtMs;
+            disconnectedAtMs = 0;
+        }
+        if (failoverStartMs)
+        {
+            stats.lastFailoverMs = now - failoverStartMs;
+            failoverStartMs = 0;
+        }
+        portEXIT_CRITICAL(&connMux);
+
+        if (connectTimer)
+            xTimerStop(connectTimer, 0);
+        notify(EVT_CONNECTED);
+    }
+
+    void onDisconnected()
+    {
+        bool wasConnecting = false;
+        bool wasConnected = false;
+
+        portENTER_CRITICAL(&connMux);
+        if (connState == MQTT_CONN_CONNECTING)
+        {
+            wasConnecting = true;
+            stats.failures++;
+        }
+        else if (connState == MQTT_CONN_CONNECTED)
+        {
+            wasConnected = true;
+            disconnectedAtMs = millis();
+            lostSessionMs = disconnectedAtMs - sessionStartMs;
+        }
+        connState = MQTT_CONN_IDLE;
+        portEXIT_CRITICAL(&connMux);
+
+        if (wasConnecting)
+        {
+            if (connectTimer)
+                xTimerStop(connectTimer, 0);
+            notify(EVT_FAILED);
+        }
+        else if (wasConnected)
+        {
+            notify(EVT_LOST);
+        }
+    }
+
+    MqttConnState state()
+    {
+        return connState;
+    }
+
+    bool busy()
+    {
+        return connState == MQTT_CONN_CONNECTING || planActive;
+    }
+
+    void getStats(MqttConnStats &out)
+    {
+        portENTER_CRITICAL(&connMux);
+        out = stats;
+        portEXIT_CRITICAL(&connMux);
+    }
+
+    // ---------------------------------------------------------------------------------
+    //  connTask helpers
+    // ---------------------------------------------------------------------------------
+
+    static void runStep()
+    {
+        uint8_t idx = plan[planPos];
+        stepRunning = true;
+
+        if (idx >= mqttPriorityCount || mqttPriorityList[idx][0] == '\0')
+        {
+            logMessage(LOG_WARN, "⚠️ No broker at priority " + String(idx) + " — skipping");
+            notify(EVT_SKIPPED);
+            return;
+        }
+
+        if (planLen > 1)
+            logMessage(LOG_INFO,
+                       "🧪 Connect plan step " + String(planPos + 1) + "/" + String(planLen) +
+                           " → priority " + String(idx));
+
+        if (!SmartCore_MQTT::setupMQTTClient(mqttPriorityList[idx], mqtt_port))
+            notify(EVT_SKIPPED); // WiFi down — no attempt was started
+    }
+
+    static void stepFailed()
+    {
+        if (!planActive)
+            return;
+
+        if (++planPos < planLen)
+        {
+            if (planPos == planLen - 1 && plan[planPos] != 0)
+                logMessage(LOG_WARN,
+                           "⚠️ PRIMARY still offline → using backup priority " + String(plan[planPos]));
+
+            xTimerStart(retryTimer, 0);
+            return;
+        }
+
+        planActive = false;
+        logMessage(LOG_WARN, "⚠️ Connect plan exhausted — handing over to reconnect backoff");
+    }
+
+    static void persistIndex(uint8_t idx)
+    {
+        SmartCore_MQTT::currentPriorityIndex = idx;
+
+        // Only after a successful connect, and only when it changed
+        if (SmartCore_EEPROM::readByteFromEEPROM(MQTT_LAST_PRIORITY_ADDR) != idx)
+        {
+            logMessage(LOG_INFO, "💾 Persisting MQTT priority index → " + String(idx));
+            SmartCore_EEPROM::writeByteToEEPROM(MQTT_LAST_PRIORITY_ADDR, idx);
+            EEPROM.commit();
+        }
+    }
+
+    static void planSucceeded()
+    {
+        if (!planActive)
+            return;
+
+        planActive = false;
+        if (!stepRunning)
+            return; // someone else's attempt got there first — nothing to persist
+
+        stepRunning = false;
+        uint8_t idx = plan[planPos];
+
+        if (planLen > 1 && idx == 0)
+            logMessage(LOG_INFO, "🎉 PRIMARY is back online! Using priority 0.");
+
+        persistIndex(idx);
+    }
+
+    void connTask(void *parameter)
+    {
+        for (;;)
+        {
+            uint32_t bits = 0;
+            xTaskNotifyWait(0, UINT32_MAX, &bits, portMAX_DELAY);
+
+            // Broker the last attempt / session belonged to (the fallback broker runs
+            // on its own port and has no health record)
+            int8_t broker = SmartCore_MQTT::currentBrokerPort == mqtt_port
+                                ? SmartCore_BrokerHealth::indexOf(SmartCore_MQTT::currentBrokerIP)
+                                : -1;
+
+            if (bits & EVT_LOST)
+            {
+                if (broker >= 0)
+                    SmartCore_BrokerHealth::recordSessionEnd(broker, lostSessionMs);
+            }
+
+            if (bits & EVT_ADOPT)
+            {
+                persistIndex(adoptedIndex);
+                SmartCore_BrokerHealth::persist(true);
+            }
+
+            if (bits & EVT_CONNECTED)
+            {
+                MqttConnStats s;
+                getStats(s);
+                logMessage(LOG_INFO,
+                           "✅ MQTT connected to " + SmartCore_MQTT::currentBrokerIP + ":" +
+                               String(SmartCore_MQTT::currentBrokerPort) + " in " +
+                               String(s.lastConnectMs) + " ms");
+                if (broker >= 0)
+                    SmartCore_BrokerHealth::recordConnect(broker, min<uint32_t>(s.lastConnectMs, UINT16_MAX));
+                planSucceeded();
+                SmartCore_BrokerHealth::persist();
+                continue; // a stale failure from the same batch no longer matters
+            }
+
+            if (bits & EVT_TIMEOUT)
+            {
+                logMessage(LOG_WARN,
+                           "⏱️ MQTT connect to " + SmartCore_MQTT::currentBrokerIP + " timed out after " +
+                               String(MQTT_CONNECT_TIMEOUT_MS) + " ms");
+
+                // Drop the half-open socket so a late CONNACK can't resurrect it
+                SmartCore_Publisher::lockClient();
+                if (mqttClient)
+                    mqttClient->disconnect(true);
+                SmartCore_Publisher::unlockClient();
+            }
+            else if (bits & EVT_FAILED)
+            {
+                logMessage(LOG_WARN, "❌ MQTT connect FAILED to " + SmartCore_MQTT::currentBrokerIP);
+            }
+
+            if ((bits & (EVT_TIMEOUT | EVT_FAILED)) && broker >= 0)
+            {
+                SmartCore_BrokerHealth::recordFailure(broker);
+                SmartCore_BrokerHealth::persist();
+            }
+
+            if (bits & (EVT_TIMEOUT | EVT_FAILED | EVT_SKIPPED))
+            {
+                if (stepRunning)
+                {
+                    stepRunning = false;
+                    stepFailed(); // next step after MQTT_CONN_RETRY_GAP_MS
+                }
+                else
+                {
+                    bits |= EVT_RETRY; // a foreign attempt ended — the plan can go now
+                }
+            }
+
+            if ((bits & (EVT_PLAN | EVT_RETRY)) && planActive && !stepRunning &&
+                connState != MQTT_CONN_CONNECTING)
+            {
+                if (planProbe)
+                {
+                    // ≤ BROKER_PROBE_TIMEOUT_MS; callbacks meanwhile just pile up as bits
+                    planProbe = false;
+                    BrokerProbeResult probe[BROKER_PROBE_MAX];
+                    int8_t best = SmartCore_BrokerProbe::probeAll(probe);
+
+                    if (best >= 0)
+                    {
+                        if (best == 0 && planLen > 1)
+                            logMessage(LOG_INFO, "🎉 PRIMARY answers again — switching back to priority 0.");
+
+                        plan[0] = best;
+                        planLen = 1;
+                        planPos = 0;
+                    }
+                }
+
+                runStep();
+            }
+        }
+    }
+
+    void init()
+    {
+        if (connTaskHandle)
+            return;
+
+        connectTimer = xTimerCreate("mqttConnTimeout", pdMS_TO_TICKS(MQTT_CONNECT_TIMEOUT_MS),
+                                    pdFALSE, nullptr, onConnectTimer);
+        retryTimer = xTimerCreate("mqttConnRetry", pdMS_TO_TICKS(MQTT_CONN_RETRY_GAP_MS),
+                                  pdFALSE, nullptr, onRetryTimer);
+
+        if (!connectTimer || !retryTimer)
+        {
+            logMessage(LOG_ERROR, "❌ Failed to create MQTT connection timers");
+            return;
+        }
+
+        xTaskCreatePinnedToCore(connTask, "MQTT Conn", 4096, NULL, 2, &connTaskHandle, 0);
+    }
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Connection manager timing (override externally if needed)
+#ifndef MQTT_CONNECT_TIMEOUT_MS
+#define MQTT_CONNECT_TIMEOUT_MS 3000 // TCP + CONNACK must complete within this
+#endif
+#define MQTT_CONN_RETRY_GAP_MS 250   // pause between steps of a connect plan
+#define MQTT_CONN_PLAN_MAX 4
+
+enum MqttConnState : uint8_t
+{
+    MQTT_CONN_IDLE = 0, // not connected, no attempt running
+    MQTT_CONN_CONNECTING,
+    MQTT_CONN_CONNECTED
+};
+
+struct MqttConnStats
+{
+    uint32_t attempts;
+    uint32_t failures;          // refused / dropped before CONNACK, incl. timeouts
+    uint32_t timeouts;
+    uint32_t bootToConnectedMs; // first CONNACK since power-on (0 = not yet)
+    uint32_t lastConnectMs;     // connect() → CONNACK of the last good attempt
+    uint32_t lastFailoverMs;    // failover triggered → connected to the new broker
+    uint32_t lastOutageMs;      // disconnect → reconnected
+};
+
+namespace SmartCore_MQTTConn
+{
+    extern TaskHandle_t connTaskHandle;
+
+    // Timers + manager task (idempotent)
+    void init();
+
+    // Boot: probe every broker in parallel and connect to the highest-priority one
+    // that answers (primary, then savedIndex if none do). Returns immediately.
+    void bootConnect(uint8_t savedIndex);
+
+    // Connect to one priority-list entry (failover). Returns immediately.
+    void connectTo(uint8_t priorityIndex);
+
+    // Start of a failover — the clock for lastFailoverMs
+    void failoverStarted();
+
+    // Connected session moved to another broker without a new attempt (hot standby
+    // promotion) — persists the index like a successful plan
+    void adopted(uint8_t priorityIndex);
+
+    // Hooks for SmartCore_MQTT (attemptStarted right before mqttClient->connect())
+    void attemptStarted();
+    void onConnected();
+    void onDisconnected();
+
+    MqttConnState state();
+
+    // An attempt or a plan is running — reconnect logic should stand back
+    bool busy();
+
+    void getStats(MqttConnStats &out);
+
+    void connTask(void *parameter);
+}
@@ -0,0 +1,378 @@
+#include "SmartCore_Metrics.h"
+#include <WiFi.h>
+#include <ArduinoJson.h>
+#include <esp_heap_caps.h>
+#include <esp_idf_version.h>
+#include "driver/temp_sensor.h"
+#include "SmartCore_Network.h"
+#include "SmartCore_MQTT.h"
+#include "SmartCore_MQTTConn.h"
+#include "SmartCore_Liveness.h"
+#include "SmartCore_Outbox.h"
+#include "SmartCore_Publisher.h"
+#include "SmartCore_RPC.h"
+#include "SmartCore_SmartNet.h"
+#include "SmartCore_Traffic.h"
+#include "SmartCore_Time.h"
+#include "SmartCore_Log.h"
+
+namespace SmartCore_Metrics
+{
+    // ======================================================================================
+    //  RUNTIME METRICS
+    // ======================================================================================
+    //
+    //  module/metrics every METRICS_INTERVAL_MS (stretched under congestion):
+    //
+    //      { "serialNumber": "...", "metrics": {
+    //          core      mac, ip, uptime, tempC, heap, rssi
+    //          mqtt      mqttRx*, rpc*, pub*, mqttConnect*, mqttPing*, outboxPending
+    //          heap      heapMin, heapLargest, heapFrag (% of free heap not in the largest block)
+    //          cpu       idle: [core0 %, core1 %] since the previous report
+    //          counters  counters: { mqttRx, mqttHandled, pubSent, ..., logWarn, logError }
+    //          traffic   traffic: { "<prefix>": [msgs, bytes, drops] } — top
+    //                    TRAFFIC_METRICS_TOP by bytes, in + out
+    //          time      timeRttMs, timeErrMs, timeDriftPpm, timeAgeS, timeSteps, timePrecise
+    //          stacks    stacks: { "<task name>": free bytes at the high-water mark, ... }
+    //      } }
+    //
+    //  The core and mqtt keys are the ones the metrics always had. Stack marks cover
+    //  every FreeRTOS task (SmartCore's, AsyncTCP's, the IDF's) and are what the
+    //  xTaskCreate stack sizes should be tuned against.
+    //
+    //  The document and buffer are static and sized for the worst case; stacks go
+    //  last and stop (with "stacksTruncated") before the payload would outgrow
+    //  METRICS_BUFFER_SIZE. cpu and stacks need FreeRTOS trace facility + run-time
+    //  stats (enabled in the Arduino-ESP32 core); without them they are omitted.
+    //
+    // ======================================================================================
+
+#if configGENERATE_RUN_TIME_STATS && configUSE_TRACE_FACILITY
+#define METRICS_HAVE_TASK_STATS 1
+#else
+#define METRICS_HAVE_TASK_STATS 0
+#endif
+
+    static volatile uint16_t enabled = METRICS_FAMILIES & METRICS_FAMILY_ALL;
+    static char macStr[18];
+    static StaticJsonDocument<METRICS_DOC_SIZE> doc;
+    static TrafficEntry traffic[TRAFFIC_SLOTS];
+
+#if METRICS_HAVE_TASK_STATS
+    static TaskStatus_t taskStatus[METRICS_MAX_TASKS];
+    static uint32_t lastTotalRunTime = 0;
+    static uint32_t lastIdleRunTime[portNUM_PROCESSORS];
+#endif
+
+    struct FamilyName
+    {
+        const char *name;
+        uint16_t bit;
+    };
+
+    static const FamilyName familyNames[] = {
+        {"core", METRICS_FAMILY_CORE},
+        {"mqtt", METRICS_FAMILY_MQTT},
+        {"heap", METRICS_FAMILY_HEAP},
+        {"cpu", METRICS_FAMILY_CPU},
+        {"counters", METRICS_FAMILY_COUNTERS},
+        {"stacks", METRICS_FAMILY_STACKS},
+        {"traffic", METRICS_FAMILY_TRAFFIC},
+        {"time", METRICS_FAMILY_TIME},
+    };
+
+    void begin()
+    {
+        temp_sensor_config_t temp_sensor = {
+            .dac_offset = TSENS_DAC_L2,
+            .clk_div = 6,
+        };
+        temp_sensor_set_config(temp_sensor);
+        temp_sensor_start();
+
+        uint8_t mac[6];
+        esp_read_mac(mac, ESP_MAC_WIFI_STA);
+        snprintf(macStr, sizeof(macStr), "%02X:%02X:%02X:%02X:%02X:%02X",
+                 mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
+    }
+
+    void setFamilies(uint16_t mask)
+    {
+        enabled = mask & METRICS_FAMILY_ALL;
+    }
+
+    uint16_t families()
+    {
+        return enabled;
+    }
+
+    uint16_t familyFromName(const char *name)
+    {
+        for (const FamilyName &f : familyNames)
+        {
+            if (!strcmp(f.name, name))
+                return f.bit;
+        }
+        return 0;
+    }
+
+    static void addCore(JsonObject metrics)
+    {
+        metrics["mac"] = (const char *)macStr;
+        metrics["ip"] = WiFi.localIP().toString();
+        metrics["uptime"] = millis() / 1000;
+
+        float tempC;
+        if (temp_sensor_read_celsius(&tempC) == ESP_OK)
+            metrics["tempC"] = tempC;
+        else
+            metrics["tempC"] = nullptr;
+
+        metrics["heap"] = ESP.getFreeHeap();
+        metrics["rssi"] = WiFi.RSSI();
+    }
+
+    static void addMqtt(JsonObject metrics)
+    {
+        const MqttRxStats &rx = SmartCore_MQTT::getRxStats();
+        metrics["mqttRxFragmented"] = rx.fragmented;
+        metrics["mqttRxDropped"] = rx.dropped + rx.queueDropped;
+        metrics["mqttQueueHigh"] = rx.queueHighWater;
+        metrics["mqttHandlerMaxMs"] = rx.handlerMaxUs / 1000;
+
+        RpcStats rpc;
+        SmartCore_RPC::getStats(rpc);
+        metrics["rpcReplayed"] = rpc.replayed;
+        metrics["rpcExpired"] = rpc.expired;
+        metrics["outboxPending"] = SmartCore_Outbox::pending(OUTBOX_ALARM) +
+                                   SmartCore_Outbox::pending(OUTBOX_TELEMETRY);
+
+        PublishStats pub;
+        SmartCore_Publisher::getStats(pub);
+        metrics["pubDropped"] = pub.dropped;
+        metrics["pubThrottle"] = pub.throttleLevel;
+
+        MqttConnStats conn;
+        SmartCore_MQTTConn::getStats(conn);
+        metrics["mqttBootMs"] = conn.bootToConnectedMs;
+        metrics["mqttConnectMs"] = conn.lastConnectMs;
+        metrics["mqttFailoverMs"] = conn.lastFailoverMs;
+        metrics["mqttOutageMs"] = conn.lastOutageMs;
+
+        LivenessStats live;
+        SmartCore_Liveness::getStats(live);
+        metrics["mqttPingMs"] = live.lastRttMs;
+        metrics["mqttPingMaxMs"] = live.maxRttMs;
+        metrics["mqttPingLost"] = live.missed;
+        metrics["mqttPingHeld"] = live.heldBack;
+        metrics["mqttDeadBroker"] = live.deadVerdicts;
+        JsonArray hist = metrics.createNestedArray("mqttPingHist");
+        for (uint8_t i = 0; i < LIVENESS_RTT_BUCKETS; i++)
+            hist.add(live.rttHist[i]);
+    }
+
+    static void addHeap(JsonObject metrics)
+    {
+        uint32_t freeHeap = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+        uint32_t largest = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+
+        metrics["heapMin"] = ESP.getMinFreeHeap();
+        metrics["heapLargest"] = largest;
+        metrics["heapFrag"] = freeHeap ? 100 - (uint32_t)((uint64_t)largest * 100 / freeHeap) : 0;
+
+        if (ESP.getPsramSize())
+            metrics["psramFree"] = ESP.getFreePsram();
+    }
+
+    static void addCounters(JsonObject metrics)
+    {
+        JsonObject c = metrics.createNestedObject("counters");
+
+        const MqttRxStats &rx = SmartCore_MQTT::getRxStats();
+        c["mqttRx"] = rx.messages;
+        c["mqttHandled"] = rx.handled;
+        c["mqttQueueDropped"] = rx.queueDropped;
+        c["mqttSpilled"] = rx.spilled;
+
+        PublishStats pub;
+        SmartCore_Publisher::getStats(pub);
+        c["pubSubmitted"] = pub.submitted;
+        c["pubSent"] = pub.sent;
+        c["pubAcked"] = pub.acked;
+        c["pubThrottled"] = pub.throttled;
+        c["pubTimeouts"] = pub.timeouts;
+        c["pubStored"] = pub.stored;
+
+        MqttConnStats conn;
+        SmartCore_MQTTConn::getStats(conn);
+        c["mqttConnects"] = conn.attempts;
+        c["mqttConnectFails"] = conn.failures;
+
+        RpcStats rpc;
+        SmartCore_RPC::getStats(rpc);
+        c["rpcRequests"] = rpc.requests;
+
+#ifdef SMARTBOX_BUILD
+        SmartNetStats net;
+        SmartCore_SmartNet::getStats(net);
+        c["canFrames"] = net.frames;
+        c["canFields"] = net.fields;
+        c["canUnhandled"] = net.unhandled;
+        c["canTopics"] = net.topics;
+#endif
+
+        LogStats log;
+        getLogStats(log);
+        c["logWarn"] = log.warn;
+        c["logError"] = log.error;
+    }
+
+    static uint32_t trafficBytes(const TrafficEntry &e)
+    {
+        return e.bytes[TRAFFIC_IN] + e.bytes[TRAFFIC_OUT];
+    }
+
+    static void addTraffic(JsonObject metrics)
+    {
+        uint8_t n = SmartCore_Traffic::snapshot(traffic, TRAFFIC_SLOTS);
+        JsonObject t = metrics.createNestedObject("traffic");
+
+        // Partial selection sort — n is at most TRAFFIC_SLOTS
+        for (uint8_t k = 0; k < n && k < TRAFFIC_METRICS_TOP; k++)
+        {
+            uint8_t best = k;
+            for (uint8_t i = k + 1; i < n; i++)
+            {
+                if (trafficBytes(traffic[i]) > trafficBytes(traffic[best]))
+                    best = i;
+            }
+
+            TrafficEntry e = traffic[best];
+            traffic[best] = traffic[k];
+            traffic[k] = e;
+
+            JsonArray row = t.createNestedArray((const char *)traffic[k].prefix);
+            row.add(e.messages[TRAFFIC_IN] + e.messages[TRAFFIC_OUT]);
+            row.add(trafficBytes(e));
+            row.add(e.drops[TRAFFIC_IN] + e.drops[TRAFFIC_OUT]);
+        }
+    }
+
+    static void addTime(JsonObject metrics)
+    {
+        TimeSyncStats t;
+        SmartCore_Time::getStats(t);
+        if (!t.valid)
+        {
+            metrics["timeAgeS"] = nullptr;
+            return;
+        }
+
+        metrics["timeRttMs"] = t.lastRttUs / 1000.0f;
+        metrics["timeErrMs"] = t.lastErrorUs / 1000.0f;
+        metrics["timeDriftPpm"] = t.driftPpm;
+        metrics["timeAgeS"] = t.ageMs / 1000;
+        metrics["timeSteps"] = t.steps;
+        metrics["timePrecise"] = t.precise;
+    }
+
+#if METRICS_HAVE_TASK_STATS
+    static TaskHandle_t idleTask(int core)
+    {
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 0, 0)
+        return xTaskGetIdleTaskHandleForCore(core);
+#else
+        return xTaskGetIdleTaskHandleForCPU(core);
+#endif
+    }
+
+    static void addTaskStats(JsonObject metrics, uint16_t mask, size_t limit)
+    {
+        uint32_t totalRunTime = 0;
+        UBaseType_t count = uxTaskGetSystemState(taskStatus, METRICS_MAX_TASKS, &totalRunTime);
+        if (count == 0)
+            return; // more tasks than METRICS_MAX_TASKS
+
+        if (mask & METRICS_FAMILY_CPU)
+        {
+            uint32_t elapsed = totalRunTime - lastTotalRunTime;
+            JsonArray idle;
+            if (lastTotalRunTime && elapsed)
+                idle = metrics.createNestedArray("idle");
+
+            for (int core = 0; core < portNUM_PROCESSORS; core++)
+            {
+                TaskHandle_t handle = idleTask(core);
+                for (UBaseType_t i = 0; i < count; i++)
+                {
+                    if (taskStatus[i].xHandle != handle)
+                        continue;
+
+                    if (!idle.isNull())
+                    {
+                        uint32_t ran = taskStatus[i].ulRunTimeCounter - lastIdleRunTime[core];
+                        idle.add(min<uint32_t>(100, (uint64_t)ran * 100 / elapsed));
+                    }
+                    lastIdleRunTime[core] = taskStatus[i].ulRunTimeCounter;
+                    break;
+                }
+            }
+            lastTotalRunTime = totalRunTime;
+        }
+
+        if (mask & METRICS_FAMILY_STACKS)
+        {
+            JsonObject stacks = metrics.createNestedObject("stacks");
+
+            for (UBaseType_t i = 0; i < count; i++)
+            {
+                // char* → copied into the document; the task may be gone by serialisation
+                stacks[(char *)taskStatus[i].pcTaskName] = (uint32_t)taskStatus[i].usStackHighWaterMark;
+
+                if (doc.overflowed() || measureJson(doc) >= limit)
+                {
+                    stacks.remove((char *)taskStatus[i].pcTaskName);
+                    metrics["stacksTruncated"] = true;
+                    break;
+                }
+            }
+        }
+    }
+#endif
+
+    size_t collect(char *out, size_t size)
+    {
+        uint16_t mask = enabled;
+        size_t limit = min<size_t>(size, METRICS_BUFFER_SIZE) - 1;
+
+        doc.clear();
+        doc["serialNumber"] = serialNumber;
+        JsonObject metrics = doc.createNestedObject("metrics");
+
+        if (mask & METRICS_FAMILY_CORE)
+            addCore(metrics);
+        if (mask & METRICS_FAMILY_MQTT)
+            addMqtt(metrics);
+        if (mask & METRICS_FAMILY_HEAP)
+            addHeap(metrics);
+        if (mask & METRICS_FAMILY_COUNTERS)
+            addCounters(metrics);
+        if (mask & METRICS_FAMILY_TRAFFIC)
+            addTraffic(metrics);
+        if (mask & METRICS_FAMILY_TIME)
+            addTime(metrics);
+
+#if METRICS_HAVE_TASK_STATS
+        if (mask & (METRICS_FAMILY_CPU | METRICS_FAMILY_STACKS))
+            addTaskStats(metrics, mask, limit - 32); // room for "stacksTruncated"
+#endif
+
+        if (doc.overflowed() || measureJson(doc) > limit)
+        {
+            logMessage(LOG_WARN, "⚠️ Metrics exceed METRICS_BUFFER_SIZE — report skipped");
+            return 0;
+        }
+
+        return serializeJson(doc, out, size);
+    }
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Metric families — one bit each, selectable at build time (-DMETRICS_FAMILIES=...)
+// or at runtime via {"type":"setMetrics","families":["heap","stacks",...]} on config
+#define METRICS_FAMILY_CORE (1 << 0)     // uptime, heap, RSSI, chip temperature, MAC, IP
+#define METRICS_FAMILY_MQTT (1 << 1)     // receive / publish / connect / liveness
+#define METRICS_FAMILY_HEAP (1 << 2)     // minimum ever, largest free block, fragmentation
+#define METRICS_FAMILY_CPU (1 << 3)      // idle % per core
+#define METRICS_FAMILY_COUNTERS (1 << 4) // MQTT / SmartNet / log totals
+#define METRICS_FAMILY_STACKS (1 << 5)   // stack high-water mark per task
+#define METRICS_FAMILY_TRAFFIC (1 << 6)  // busiest MQTT topic prefixes (SmartCore_Traffic)
+#define METRICS_FAMILY_TIME (1 << 7)     // SmartBoat time sync quality
+#define METRICS_FAMILY_ALL 0xFF
+
+#ifndef METRICS_FAMILIES
+#define METRICS_FAMILIES METRICS_FAMILY_ALL
+#endif
+#ifndef METRICS_BUFFER_SIZE
+#define METRICS_BUFFER_SIZE 2048 // payload never exceeds this; stacks are trimmed first
+#endif
+#define METRICS_DOC_SIZE 3072
+#define METRICS_MAX_TASKS 40
+#define METRICS_INTERVAL_MS 10000
+
+namespace SmartCore_Metrics
+{
+    // Once, from the metrics task (temperature sensor, MAC string)
+    void begin();
+
+    // Serialises the enabled families into out (at most METRICS_BUFFER_SIZE bytes);
+    // returns the length. Metrics task only — uses static buffers.
+    size_t collect(char *out, size_t size);
+
+    void setFamilies(uint16_t mask);
+    uint16_t families();
+
+    // "core", "mqtt", ... → bit; 0 if unknown
+    uint16_t familyFromName(const char *name);
+}
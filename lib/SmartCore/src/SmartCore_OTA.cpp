@@ -79,8 +79,9 @@ namespace SmartCore_OTA {
             doc["progress"] = percent;
             String json;
             serializeJson(doc, json);
-            if (mqttIsConnected && mqttClient) {
-                mqttClient->publish("module/upgrade", 0, false, json.c_str());
+            // Bypasses mqttSafePublish's OTA gate — progress is the one thing we do send
+            if (mqttIsConnected) {
+                SmartCore_Publisher::submit("module/upgrade", 0, false, json.c_str(), json.length(), PUB_PRIO_HIGH);
             }
             Serial.printf("OTA Progress: %d%% published to module/upgrade\n", percent);
         }
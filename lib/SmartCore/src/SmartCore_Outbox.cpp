@@ -0,0 +1,607 @@
+#include "SmartCore_Outbox.h"
+#include <LittleFS.h>
+#include "SmartCore_MQTT.h"
+#include "SmartCore_Publisher.h"
+#include "SmartCore_OTA.h"
+#include "SmartCore_Network.h"
+#include "SmartCore_Log.h"
+
+#define OUTBOX_RECORD_MAGIC 0xA5
+#define OUTBOX_FLAG_RETAIN 0x04
+
+namespace SmartCore_Outbox
+{
+    TaskHandle_t outboxTaskHandle = NULL;
+
+    // ======================================================================================
+    //  STORE-AND-FORWARD OUTBOX
+    // ======================================================================================
+    //
+    //  Messages that could not be published (MQTT down, failover, OTA) are appended to a
+    //  per-class FIFO on LittleFS and replayed once the broker is back.
+    //
+    //      /outbox/a/<seq>   alarms / module errors
+    //      /outbox/t/<seq>   telemetry
+    //
+    //  Each class is a chain of segment files (≤ OUTBOX_SEGMENT_BYTES) of records:
+    //
+    //      [magic][flags][topicLen][-][payloadLen:16] topic payload
+    //
+    //  WRITE   enqueue() appends to a small RAM tail buffer; the task flushes it to the
+    //          tail segment every tick (alarms) or every OUTBOX_TELEMETRY_FLUSH_MS.
+    //          A producer that finds the buffer full flushes it itself.
+    //  CAP     when a class exceeds its byte cap the oldest whole segment is deleted
+    //          (drop-oldest), and the dropped records are counted.
+    //  REPLAY  the head segment is read into one shared RAM cache; records are published
+    //          OUTBOX_REPLAY_PER_TICK at a time, alarm class fully before telemetry.
+    //          A record is only consumed once the publish task accepted it.
+    //
+    //  LOCKING outboxMutex guards the RAM side only (tail buffers, stats) and is never
+    //          held across flash IO, so producers (MQTT worker included) don't wait on
+    //          erase / write latency. fsMutex serializes everything on LittleFS and the
+    //          segment bookkeeping (head / tail / offsets, head cache). Order: fsMutex,
+    //          then outboxMutex.
+    //
+    //  Delivery is at-least-once: the read position inside the head segment lives in RAM,
+    //  so a reboot mid-replay resends the part of that segment already delivered.
+    //
+    // ======================================================================================
+
+    struct RecordHeader
+    {
+        uint8_t magic;
+        uint8_t flags; // bits 0-1 qos, bit 2 retain
+        uint8_t topicLen;
+        uint8_t reserved;
+        uint16_t payloadLen;
+    };
+
+    struct ClassState
+    {
+        const char *dir;
+        uint32_t capBytes;
+        uint32_t headSeq;    // oldest segment                          (fsMutex)
+        uint32_t tailSeq;    // segment being appended to               (fsMutex)
+        uint32_t headOffset; // next unsent record in the head segment  (fsMutex)
+        uint32_t tailBytes;  // bytes already on disk in the tail segment (fsMutex)
+        uint32_t lastFlush;  // outboxMutex from here on
+        uint16_t writeLen;
+        uint16_t writeRecords;
+        uint8_t writeBuf[OUTBOX_WRITE_BUFFER];
+    };
+
+    static ClassState classes[OUTBOX_CLASS_COUNT] = {
+        {"a", OUTBOX_ALARM_MAX_BYTES},
+        {"t", OUTBOX_TELEMETRY_MAX_BYTES},
+    };
+
+    static OutboxStats stats;
+    static SemaphoreHandle_t outboxMutex = nullptr;
+    static SemaphoreHandle_t fsMutex = nullptr;
+
+    // Tail buffer being written out (fsMutex)
+    static uint8_t flushBuf[OUTBOX_WRITE_BUFFER];
+
+    // Head cache (one class at a time, fsMutex)
+    static uint8_t headCache[OUTBOX_SEGMENT_BYTES];
+    static int8_t cacheClass = -1;
+    static uint32_t cacheSeq = 0;
+    static uint32_t cacheBase = 0;
+    static uint32_t cacheLen = 0;
+
+    static void segmentPath(char *out, size_t len, uint8_t cls, uint32_t seq)
+    {
+        snprintf(out, len, "%s/%s/%lu", OUTBOX_DIR, classes[cls].dir, (unsigned long)seq);
+    }
+
+    static void invalidateCache(uint8_t cls)
+    {
+        if (cacheClass == cls)
+            cacheClass = -1;
+    }
+
+    // Records in a segment from offset on (used for drop accounting and boot recovery)
+    static uint32_t countRecords(const char *path, uint32_t offset)
+    {
+        File f = LittleFS.open(path, "r");
+        if (!f)
+            return 0;
+
+        uint32_t count = 0;
+        RecordHeader hdr;
+        f.seek(offset);
+
+        while (f.read((uint8_t *)&hdr, sizeof(hdr)) == sizeof(hdr) && hdr.magic == OUTBOX_RECORD_MAGIC)
+        {
+            uint32_t next = f.position() + hdr.topicLen + hdr.payloadLen;
+            if (next > f.size())
+                break; // torn write at the tail
+            f.seek(next);
+            count++;
+        }
+
+        f.close();
+        return count;
+    }
+
+    // Drop-oldest: delete whole head segments until the class fits its cap again (fsMutex held)
+    static void enforceCap(uint8_t cls)
+    {
+        ClassState &c = classes[cls];
+
+        while (stats.diskBytes[cls] > c.capBytes && c.headSeq < c.tailSeq)
+        {
+            char path[40];
+            segmentPath(path, sizeof(path), cls, c.headSeq);
+
+            uint32_t lost = countRecords(path, c.headOffset);
+            File f = LittleFS.open(path, "r");
+            uint32_t size = f ? f.size() : 0;
+            if (f)
+                f.close();
+
+            LittleFS.remove(path);
+
+            xSemaphoreTake(outboxMutex, portMAX_DELAY);
+            stats.diskBytes[cls] -= min(size, stats.diskBytes[cls]);
+            stats.pending[cls] -= min(lost, stats.pending[cls]);
+            stats.dropped[cls] += lost;
+            xSemaphoreGive(outboxMutex);
+
+            c.headSeq++;
+            c.headOffset = 0;
+            invalidateCache(cls);
+
+            logMessage(LOG_WARN, "⚠️ Outbox " + String(c.dir) + " over cap — dropped " +
+                                     String(lost) + " oldest messages");
+        }
+    }
+
+    // RAM tail buffer → tail segment (fsMutex held). The records are copied out under
+    // outboxMutex; the file IO runs without it.
+    static void flushLocked(uint8_t cls)
+    {
+        ClassState &c = classes[cls];
+
+        xSemaphoreTake(outboxMutex, portMAX_DELAY);
+        uint16_t len = c.writeLen;
+        uint16_t records = c.writeRecords;
+        memcpy(flushBuf, c.writeBuf, len);
+        c.writeLen = 0;
+        c.writeRecords = 0;
+        c.lastFlush = millis();
+        xSemaphoreGive(outboxMutex);
+
+        if (len == 0)
+            return;
+
+        if (c.tailBytes + len > OUTBOX_SEGMENT_BYTES)
+        {
+            // Close the tail segment, start the next one
+            c.tailSeq++;
+            c.tailBytes = 0;
+        }
+
+        char path[40];
+        segmentPath(path, sizeof(path), cls, c.tailSeq);
+
+        File f = LittleFS.open(path, "a");
+        size_t written = f ? f.write(flushBuf, len) : 0;
+        if (f)
+            f.close();
+
+        xSemaphoreTake(outboxMutex, portMAX_DELAY);
+        if (written != len)
+        {
+            // Filesystem full or failing — don't retry the same bytes forever
+            stats.pending[cls] -= min((uint32_t)records, stats.pending[cls]);
+            stats.dropped[cls] += records;
+        }
+        else
+        {
+            stats.diskBytes[cls] += written;
+        }
+        xSemaphoreGive(outboxMutex);
+
+        if (written != len)
+            logMessage(LOG_ERROR, "❌ Outbox write failed — " + String(records) + " messages lost");
+        else
+            c.tailBytes += written;
+
+        enforceCap(cls);
+    }
+
+    static void flushClass(uint8_t cls)
+    {
+        xSemaphoreTake(fsMutex, portMAX_DELAY);
+        flushLocked(cls);
+        xSemaphoreGive(fsMutex);
+    }
+
+    bool enqueue(OutboxClass cls, const char *topic, uint8_t qos, bool retain,
+                 const char *payload, size_t len)
+    {
+        if (!outboxMutex || cls >= OUTBOX_CLASS_COUNT)
+            return false;
+
+        if (len == 0)
+            len = strlen(payload);
+
+        size_t topicLen = strlen(topic);
+        if (topicLen > OUTBOX_MAX_TOPIC || len > OUTBOX_MAX_PAYLOAD)
+        {
+            stats.dropped[cls]++;
+            return false;
+        }
+
+        size_t recSize = sizeof(RecordHeader) + topicLen + len;
+        ClassState &c = classes[cls];
+
+        // Buffer full → write it out here (without outboxMutex), then append. Other
+        // producers racing for the space get one more try before the record is dropped.
+        xSemaphoreTake(outboxMutex, portMAX_DELAY);
+        for (uint8_t attempt = 0; c.writeLen + recSize > OUTBOX_WRITE_BUFFER; attempt++)
+        {
+            if (attempt == 2)
+            {
+                stats.dropped[cls]++;
+                xSemaphoreGive(outboxMutex);
+                return false;
+            }
+
+            xSemaphoreGive(outboxMutex);
+            flushClass(cls);
+            xSemaphoreTake(outboxMutex, portMAX_DELAY);
+        }
+
+        RecordHeader hdr = {OUTBOX_RECORD_MAGIC, (uint8_t)((qos & 0x03) | (retain ? OUTBOX_FLAG_RETAIN : 0)),
+                            (uint8_t)topicLen, 0, (uint16_t)len};
+
+        uint8_t *dst = c.writeBuf + c.writeLen;
+        memcpy(dst, &hdr, sizeof(hdr));
+        memcpy(dst + sizeof(hdr), topic, topicLen);
+        memcpy(dst + sizeof(hdr) + topicLen, payload, len);
+
+        c.writeLen += recSize;
+        c.writeRecords++;
+        stats.pending[cls]++;
+        stats.stored[cls]++;
+
+        xSemaphoreGive(outboxMutex);
+        return true;
+    }
+
+    uint32_t pending(OutboxClass cls)
+    {
+        return cls < OUTBOX_CLASS_COUNT ? stats.pending[cls] : 0;
+    }
+
+    void getStats(OutboxStats &out)
+    {
+        if (!outboxMutex)
+        {
+            memset(&out, 0, sizeof(out));
+            return;
+        }
+
+        xSemaphoreTake(outboxMutex, portMAX_DELAY);
+        out = stats;
+        xSemaphoreGive(outboxMutex);
+    }
+
+    // ======================================================================================
+    //  REPLAY
+    // ======================================================================================
+
+    struct PendingRecord
+    {
+        uint32_t seq;
+        uint32_t offset;
+        uint32_t next;
+        uint8_t qos;
+        bool retain;
+        char topic[OUTBOX_MAX_TOPIC + 1];
+        char payload[OUTBOX_MAX_PAYLOAD + 1];
+        uint16_t len;
+    };
+
+    static PendingRecord replayRec; // outbox task only
+
+    // Copies the oldest record of a class out of the head cache (fsMutex held)
+    static bool peekRecord(uint8_t cls, PendingRecord &out)
+    {
+        ClassState &c = classes[cls];
+
+        // Oldest data may still be sitting in the RAM tail buffer
+        if (c.headSeq == c.tailSeq)
+            flushLocked(cls);
+
+        for (;;)
+        {
+            char path[40];
+            segmentPath(path, sizeof(path), cls, c.headSeq);
+
+            bool loaded = false;
+            bool inCache = cacheClass == (int8_t)cls && cacheSeq == c.headSeq &&
+                           c.headOffset >= cacheBase && c.headOffset - cacheBase + sizeof(RecordHeader) <= cacheLen;
+
+            if (!inCache)
+            {
+                File f = LittleFS.open(path, "r");
+                uint32_t size = f ? f.size() : 0;
+
+                if (!f || c.headOffset >= size)
+                {
+                    if (f)
+                        f.close();
+
+                    if (c.headSeq < c.tailSeq)
+                    {
+                        // Head segment fully delivered → next one
+                        LittleFS.remove(path);
+                        xSemaphoreTake(outboxMutex, portMAX_DELAY);
+                        stats.diskBytes[cls] -= min(size, stats.diskBytes[cls]);
+                        xSemaphoreGive(outboxMutex);
+                        c.headSeq++;
+                        c.headOffset = 0;
+                        invalidateCache(cls);
+                        continue;
+                    }
+
+                    // Head == tail and everything sent → start a fresh segment
+                    if (size)
+                    {
+                        LittleFS.remove(path);
+                        c.tailSeq++;
+                        c.headSeq = c.tailSeq;
+                        c.tailBytes = 0;
+                    }
+                    c.headOffset = 0;
+                    invalidateCache(cls);
+
+                    xSemaphoreTake(outboxMutex, portMAX_DELAY);
+                    stats.diskBytes[cls] -= min(size, stats.diskBytes[cls]);
+                    stats.pending[cls] = c.writeRecords; // only what arrived since the flush
+                    xSemaphoreGive(outboxMutex);
+                    return false;
+                }
+
+                f.seek(c.headOffset);
+                cacheLen = f.read(headCache, sizeof(headCache));
+                f.close();
+
+                cacheClass = cls;
+                cacheSeq = c.headSeq;
+                cacheBase = c.headOffset;
+                loaded = true;
+            }
+
+            uint32_t pos = c.headOffset - cacheBase;
+            RecordHeader hdr;
+            bool valid = pos + sizeof(hdr) <= cacheLen;
+
+            if (valid)
+            {
+                memcpy(&hdr, headCache + pos, sizeof(hdr));
+                valid = hdr.magic == OUTBOX_RECORD_MAGIC && hdr.topicLen <= OUTBOX_MAX_TOPIC &&
+                        hdr.payloadLen <= OUTBOX_MAX_PAYLOAD;
+            }
+
+            uint32_t recSize = valid ? sizeof(hdr) + hdr.topicLen + hdr.payloadLen : 0;
+
+            if (valid && pos + recSize > cacheLen)
+            {
+                if (!loaded)
+                {
+                    invalidateCache(cls); // record straddles the cache window — reload
+                    continue;
+                }
+                valid = false; // torn write
+            }
+
+            if (!valid)
+            {
+                // Corrupt / torn tail → abandon the rest of this segment
+                logMessage(LOG_WARN, "⚠️ Outbox segment " + String(path) + " corrupt — skipping remainder");
+                c.headOffset = 0xFFFFFFFFUL;
+                invalidateCache(cls);
+                continue;
+            }
+
+            const uint8_t *rec = headCache + pos + sizeof(hdr);
+            out.seq = c.headSeq;
+            out.offset = c.headOffset;
+            out.next = c.headOffset + recSize;
+            out.qos = hdr.flags & 0x03;
+            out.retain = hdr.flags & OUTBOX_FLAG_RETAIN;
+            memcpy(out.topic, rec, hdr.topicLen);
+            out.topic[hdr.topicLen] = '\0';
+            memcpy(out.payload, rec + hdr.topicLen, hdr.payloadLen);
+            out.payload[hdr.payloadLen] = '\0';
+            out.len = hdr.payloadLen;
+            return true;
+        }
+    }
+
+    // 1 = sent, 0 = class empty, -1 = broker not accepting right now
+    static int replayOne(uint8_t cls)
+    {
+        xSemaphoreTake(fsMutex, portMAX_DELAY);
+        bool have = peekRecord(cls, replayRec);
+        xSemaphoreGive(fsMutex);
+
+        if (!have)
+            return 0;
+
+        // Submit without holding the outbox lock (producers keep appending meanwhile).
+        // If the link drops before it goes out, the publish task stores it again.
+        PublishPriority prio = cls == OUTBOX_ALARM ? PUB_PRIO_HIGH : PUB_PRIO_NORMAL;
+        if (!SmartCore_Publisher::submit(replayRec.topic, replayRec.qos, replayRec.retain,
+                                         replayRec.payload, replayRec.len, prio, cls))
+            return -1;
+
+        xSemaphoreTake(fsMutex, portMAX_DELAY);
+        ClassState &c = classes[cls];
+        if (c.headSeq == replayRec.seq && c.headOffset == replayRec.offset)
+        {
+            c.headOffset = replayRec.next;
+
+            xSemaphoreTake(outboxMutex, portMAX_DELAY);
+            if (stats.pending[cls])
+                stats.pending[cls]--;
+            stats.replayed[cls]++;
+            xSemaphoreGive(outboxMutex);
+        }
+        xSemaphoreGive(fsMutex);
+
+        return 1;
+    }
+
+    // ======================================================================================
+    //  STARTUP
+    // ======================================================================================
+
+    static void recoverClass(uint8_t cls)
+    {
+        ClassState &c = classes[cls];
+
+        char dirPath[24];
+        snprintf(dirPath, sizeof(dirPath), "%s/%s", OUTBOX_DIR, c.dir);
+        if (!LittleFS.exists(dirPath))
+            LittleFS.mkdir(dirPath);
+
+        bool any = false;
+        uint32_t minSeq = 0, maxSeq = 0;
+
+        File dir = LittleFS.open(dirPath);
+        if (dir && dir.isDirectory())
+        {
+            for (File f = dir.openNextFile(); f; f = dir.openNextFile())
+            {
+                const char *name = f.name();
+                const char *slash = strrchr(name, '/');
+                uint32_t seq = strtoul(slash ? slash + 1 : name, nullptr, 10);
+
+                stats.diskBytes[cls] += f.size();
+                if (!any || seq < minSeq)
+                    minSeq = seq;
+                if (!any || seq > maxSeq)
+                    maxSeq = seq;
+                any = true;
+                f.close();
+            }
+        }
+
+        c.headSeq = minSeq;
+        c.tailSeq = maxSeq;
+        c.headOffset = 0;
+
+        if (!any)
+            return;
+
+        for (uint32_t seq = minSeq; seq <= maxSeq; seq++)
+        {
+            char path[40];
+            segmentPath(path, sizeof(path), cls, seq);
+            stats.pending[cls] += countRecords(path, 0);
+
+            if (seq == maxSeq)
+            {
+                File f = LittleFS.open(path, "r");
+                c.tailBytes = f ? f.size() : 0;
+                if (f)
+                    f.close();
+            }
+        }
+
+        if (stats.pending[cls])
+            logMessage(LOG_INFO, "📮 Outbox " + String(c.dir) + ": " + String(stats.pending[cls]) +
+                                     " messages waiting from before reboot");
+    }
+
+    void init()
+    {
+        if (!outboxMutex)
+            outboxMutex = xSemaphoreCreateMutex();
+        if (!fsMutex)
+            fsMutex = xSemaphoreCreateMutex();
+
+        if (!outboxMutex || !fsMutex)
+        {
+            logMessage(LOG_ERROR, "❌ Failed to create outbox mutex");
+            return;
+        }
+
+        if (!LittleFS.exists(OUTBOX_DIR))
+            LittleFS.mkdir(OUTBOX_DIR);
+
+        for (uint8_t cls = 0; cls < OUTBOX_CLASS_COUNT; cls++)
+            recoverClass(cls);
+
+        if (!outboxTaskHandle)
+            xTaskCreatePinnedToCore(outboxTask, "Outbox Task", 4096, NULL, 1, &outboxTaskHandle, 1);
+    }
+
+    void outboxTask(void *parameter)
+    {
+        uint32_t connectedSince = 0;
+        bool replaying = false;
+
+        for (;;)
+        {
+            vTaskDelay(pdMS_TO_TICKS(OUTBOX_TICK_MS));
+
+            // 💾 RAM tail buffers → LittleFS
+            for (uint8_t cls = 0; cls < OUTBOX_CLASS_COUNT; cls++)
+            {
+                ClassState &c = classes[cls];
+
+                xSemaphoreTake(outboxMutex, portMAX_DELAY);
+                bool due = c.writeLen && (cls == OUTBOX_ALARM || millis() - c.lastFlush >= OUTBOX_TELEMETRY_FLUSH_MS);
+                xSemaphoreGive(outboxMutex);
+
+                if (due)
+                    flushClass(cls);
+            }
+
+            if (!mqttIsConnected || SmartCore_OTA::otaInProgress)
+            {
+                connectedSince = 0;
+                continue;
+            }
+
+            if (connectedSince == 0)
+                connectedSince = millis();
+
+            if (millis() - connectedSince < OUTBOX_REPLAY_DELAY_MS)
+                continue;
+
+            // 📤 Replay — higher class drains completely before the next one starts
+            uint8_t budget = OUTBOX_REPLAY_PER_TICK;
+            for (uint8_t cls = 0; cls < OUTBOX_CLASS_COUNT && budget; cls++)
+            {
+                int result = 1;
+                while (budget && stats.pending[cls] && (result = replayOne(cls)) == 1)
+                {
+                    budget--;
+                    replaying = true;
+                }
+
+                if (result < 0 || stats.pending[cls])
+                    break;
+            }
+
+            uint32_t left = 0;
+            for (uint8_t cls = 0; cls < OUTBOX_CLASS_COUNT; cls++)
+                left += stats.pending[cls];
+
+            if (replaying && left == 0)
+            {
+                replaying = false;
+                logMessage(LOG_INFO, "📮 Outbox drained — " + String(stats.replayed[OUTBOX_ALARM]) +
+                                         " alarms, " + String(stats.replayed[OUTBOX_TELEMETRY]) +
+                                         " telemetry replayed since boot");
+            }
+        }
+    }
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Store-and-forward limits (override externally if needed)
+#ifndef OUTBOX_ALARM_MAX_BYTES
+#define OUTBOX_ALARM_MAX_BYTES (32 * 1024)
+#endif
+#ifndef OUTBOX_TELEMETRY_MAX_BYTES
+#define OUTBOX_TELEMETRY_MAX_BYTES (128 * 1024)
+#endif
+
+#define OUTBOX_SEGMENT_BYTES 4096        // one segment file = one head-cache load
+#define OUTBOX_WRITE_BUFFER 1280         // RAM tail buffer per class (fits one max record)
+#define OUTBOX_MAX_TOPIC 64
+#define OUTBOX_MAX_PAYLOAD 1024
+#define OUTBOX_TICK_MS 100
+#define OUTBOX_TELEMETRY_FLUSH_MS 2000   // alarms are flushed every tick
+#define OUTBOX_REPLAY_DELAY_MS 2000      // let subscriptions settle after connect
+#define OUTBOX_REPLAY_PER_TICK 5         // → 50 msg/s
+
+#define OUTBOX_DIR "/outbox"
+
+// Replay order = enum order
+enum OutboxClass : uint8_t
+{
+    OUTBOX_ALARM = 0, // module/error, alarm transitions
+    OUTBOX_TELEMETRY, // retained smartnet state fields and friends
+    OUTBOX_CLASS_COUNT
+};
+
+struct OutboxStats
+{
+    uint32_t pending[OUTBOX_CLASS_COUNT];
+    uint32_t stored[OUTBOX_CLASS_COUNT];
+    uint32_t dropped[OUTBOX_CLASS_COUNT];
+    uint32_t replayed[OUTBOX_CLASS_COUNT];
+    uint32_t diskBytes[OUTBOX_CLASS_COUNT];
+};
+
+namespace SmartCore_Outbox
+{
+    extern TaskHandle_t outboxTaskHandle;
+
+    // Startup (recovers segments left on LittleFS, starts the flush/replay task)
+    void init();
+
+    // Append one message for later delivery; false if it can't be kept
+    bool enqueue(OutboxClass cls, const char *topic, uint8_t qos, bool retain,
+                 const char *payload, size_t len);
+
+    // Messages waiting in this class (RAM + LittleFS)
+    uint32_t pending(OutboxClass cls);
+
+    void getStats(OutboxStats &out);
+
+    void outboxTask(void *parameter);
+}
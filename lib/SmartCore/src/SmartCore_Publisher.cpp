@@ -0,0 +1,403 @@
+#include "SmartCore_Publisher.h"
+#include <AsyncMqttClient.h>
+#include <esp_timer.h>
+#include "SmartCore_Network.h"
+#include "SmartCore_Log.h"
+#include "SmartCore_Traffic.h"
+
+namespace SmartCore_Publisher
+{
+    TaskHandle_t publishTaskHandle = NULL;
+
+    // ======================================================================================
+    //  SINGLE-OWNER PUBLISH PIPELINE
+    // ======================================================================================
+    //
+    //  Every outbound MQTT message goes through here; publishTask() is the only code that
+    //  calls mqttClient->publish().
+    //
+    //      producers (any task / callback)
+    //          submit() → copy into a free slot → slot index onto its priority queue
+    //                                                     │
+    //      publishTask()  ◄───────────── task notify ─────┘
+    //          HIGH → NORMAL → TELEMETRY, one slot at a time
+    //          QoS1: only while fewer than PUBLISH_INFLIGHT_MAX acks are outstanding
+    //          publish() == 0 (TCP buffer full) → keep the slot, retry next tick
+    //
+    //  • Slots come from two fixed pools (small / large), handed around as indices
+    //    through FreeRTOS queues — producers never allocate and never wait.
+    //  • Telemetry cannot take the last PUBLISH_RESERVED_SLOTS small slots, so alarms
+    //    always find room.
+    //  • Congestion (window full, TCP full, telemetry out of slots) raises a throttle
+    //    level; the telemetry token bucket runs at MAX_RATE >> level and periodic
+    //    producers stretch their interval via telemetryInterval(). Quiet for
+    //    PUBLISH_THROTTLE_RECOVER_MS → one level back down.
+    //  • Connection lost while messages wait → messages with a storeClass go to the
+    //    LittleFS outbox, the rest are dropped (and counted).
+    //
+    // ======================================================================================
+
+    static constexpr uint8_t SLOT_COUNT = PUBLISH_SMALL_SLOTS + PUBLISH_LARGE_SLOTS;
+
+    struct PublishSlot
+    {
+        char topic[PUBLISH_TOPIC_LEN];
+        char *payload;
+        uint16_t len;
+        uint8_t qos;
+        bool retain;
+        uint8_t storeClass;
+        uint8_t prio;
+        PublishSentHook onSent;
+        int64_t tag;
+    };
+
+    struct Inflight
+    {
+        uint16_t packetId;
+        uint32_t sentMs;
+    };
+
+    static char smallPool[PUBLISH_SMALL_SLOTS][PUBLISH_SMALL_BYTES];
+    static char largePool[PUBLISH_LARGE_SLOTS][PUBLISH_LARGE_BYTES];
+    static PublishSlot slots[SLOT_COUNT];
+
+    static QueueHandle_t freeSmall = nullptr;
+    static QueueHandle_t freeLarge = nullptr;
+    static QueueHandle_t prioQueues[PUB_PRIO_COUNT] = {nullptr};
+    static SemaphoreHandle_t clientMutex = nullptr;
+
+    static Inflight inflight[PUBLISH_INFLIGHT_MAX];
+    static uint8_t inflightCount = 0;
+    static portMUX_TYPE pubMux = portMUX_INITIALIZER_UNLOCKED;
+
+    static PublishStats stats;
+
+    // Adaptive telemetry rate
+    static uint8_t throttleLevel = 0;
+    static uint32_t lastCongestionMs = 0;
+    static uint32_t lastStepMs = 0;
+    static uint32_t tokenRefillMs = 0;
+    static float tokens = PUBLISH_TELEMETRY_MAX_RATE;
+
+    static void releaseSlot(uint8_t idx)
+    {
+        xQueueSend(idx < PUBLISH_SMALL_SLOTS ? freeSmall : freeLarge, &idx, 0);
+    }
+
+    static void markCongested()
+    {
+        uint32_t now = millis();
+        lastCongestionMs = now;
+
+        if (throttleLevel < PUBLISH_THROTTLE_MAX_LEVEL && now - lastStepMs >= PUBLISH_THROTTLE_STEP_MS)
+        {
+            throttleLevel++;
+            lastStepMs = now;
+            logMessage(LOG_WARN, "🐢 MQTT congested — telemetry throttle level " + String(throttleLevel));
+        }
+    }
+
+    static void relaxThrottle()
+    {
+        uint32_t now = millis();
+        if (throttleLevel > 0 && now - lastCongestionMs >= PUBLISH_THROTTLE_RECOVER_MS &&
+            now - lastStepMs >= PUBLISH_THROTTLE_RECOVER_MS)
+        {
+            throttleLevel--;
+            lastStepMs = now;
+            logMessage(LOG_INFO, "🐇 MQTT recovering — telemetry throttle level " + String(throttleLevel));
+        }
+    }
+
+    // Token bucket for telemetry admission (rate follows the throttle level)
+    static bool takeTelemetryToken()
+    {
+        bool ok;
+        portENTER_CRITICAL(&pubMux);
+
+        uint32_t now = millis();
+        float rate = (float)(PUBLISH_TELEMETRY_MAX_RATE >> throttleLevel);
+        tokens += rate * (now - tokenRefillMs) / 1000.0f;
+        if (tokens > rate)
+            tokens = rate;
+        tokenRefillMs = now;
+
+        ok = tokens >= 1.0f;
+        if (ok)
+            tokens -= 1.0f;
+
+        portEXIT_CRITICAL(&pubMux);
+        return ok;
+    }
+
+    bool submit(const char *topic, uint8_t qos, bool retain, const char *payload, size_t len,
+                PublishPriority prio, uint8_t storeClass, PublishSentHook onSent, int64_t tag)
+    {
+        if (!publishTaskHandle || prio >= PUB_PRIO_COUNT)
+            return false;
+
+        if (len == 0)
+            len = strlen(payload);
+
+        stats.submitted++;
+
+        bool telemetry = prio == PUB_PRIO_TELEMETRY;
+
+        if (strlen(topic) >= PUBLISH_TOPIC_LEN || len >= PUBLISH_LARGE_BYTES)
+        {
+            stats.dropped++;
+            SmartCore_Traffic::dropped(topic, TRAFFIC_OUT);
+            logMessage(LOG_WARN, String("⚠️ Publish to ") + topic + " too large (" + String(len) + " bytes) — dropped");
+            return false;
+        }
+
+        if (telemetry && len >= PUBLISH_SMALL_BYTES)
+        {
+            // Would never find a slot — a caller bug, not congestion
+            stats.dropped++;
+            SmartCore_Traffic::dropped(topic, TRAFFIC_OUT);
+            logMessage(LOG_WARN, String("⚠️ Telemetry to ") + topic + " exceeds a small slot (" + String(len) + " bytes) — dropped");
+            return false;
+        }
+
+        if (telemetry && !takeTelemetryToken())
+        {
+            stats.throttled++;
+            SmartCore_Traffic::dropped(topic, TRAFFIC_OUT);
+            return true; // shed on purpose
+        }
+
+        uint8_t idx = 0xFF;
+        bool got = false;
+
+        if (len < PUBLISH_SMALL_BYTES &&
+            (!telemetry || uxQueueMessagesWaiting(freeSmall) > PUBLISH_RESERVED_SLOTS))
+            got = xQueueReceive(freeSmall, &idx, 0) == pdTRUE;
+
+        if (!got && !telemetry)
+            got = xQueueReceive(freeLarge, &idx, 0) == pdTRUE;
+
+        if (!got)
+        {
+            SmartCore_Traffic::dropped(topic, TRAFFIC_OUT);
+
+            if (telemetry)
+            {
+                stats.throttled++;
+                markCongested();
+                return true;
+            }
+
+            stats.dropped++;
+            return false;
+        }
+
+        PublishSlot &s = slots[idx];
+        strncpy(s.topic, topic, sizeof(s.topic) - 1);
+        s.topic[sizeof(s.topic) - 1] = '\0';
+        memcpy(s.payload, payload, len);
+        s.payload[len] = '\0';
+        s.len = len;
+        s.qos = qos;
+        s.retain = retain;
+        s.storeClass = storeClass;
+        s.prio = prio;
+        s.onSent = onSent;
+        s.tag = tag;
+
+        xQueueSend(prioQueues[prio], &idx, 0); // queue length == slot count, cannot fail
+        xTaskNotifyGive(publishTaskHandle);
+        return true;
+    }
+
+    void onPublishAck(uint16_t packetId)
+    {
+        portENTER_CRITICAL(&pubMux);
+        for (uint8_t i = 0; i < inflightCount; i++)
+        {
+            if (inflight[i].packetId == packetId)
+            {
+                inflight[i] = inflight[--inflightCount];
+                stats.acked++;
+                break;
+            }
+        }
+        portEXIT_CRITICAL(&pubMux);
+
+        if (publishTaskHandle)
+            xTaskNotifyGive(publishTaskHandle);
+    }
+
+    void onDisconnect()
+    {
+        // AsyncMqttClient does not resend unacked QoS1 messages after a reconnect, even
+        // with a persistent session, so their acks will never come — start the window empty
+        portENTER_CRITICAL(&pubMux);
+        inflightCount = 0;
+        portEXIT_CRITICAL(&pubMux);
+    }
+
+    static void expireInflight()
+    {
+        uint32_t now = millis();
+        bool expired = false;
+
+        portENTER_CRITICAL(&pubMux);
+        for (uint8_t i = 0; i < inflightCount;)
+        {
+            if (now - inflight[i].sentMs > PUBLISH_INFLIGHT_TIMEOUT_MS)
+            {
+                inflight[i] = inflight[--inflightCount];
+                stats.timeouts++;
+                expired = true;
+            }
+            else
+            {
+                i++;
+            }
+        }
+        portEXIT_CRITICAL(&pubMux);
+
+        if (expired)
+            markCongested();
+    }
+
+    void lockClient()
+    {
+        if (clientMutex)
+            xSemaphoreTakeRecursive(clientMutex, portMAX_DELAY);
+    }
+
+    void unlockClient()
+    {
+        if (clientMutex)
+            xSemaphoreGiveRecursive(clientMutex);
+    }
+
+    uint32_t telemetryInterval(uint32_t baseMs)
+    {
+        return baseMs << throttleLevel;
+    }
+
+    void getStats(PublishStats &out)
+    {
+        out = stats;
+        out.inflight = inflightCount;
+        out.throttleLevel = throttleLevel;
+    }
+
+    static bool nextSlot(uint8_t &idx)
+    {
+        for (uint8_t p = 0; p < PUB_PRIO_COUNT; p++)
+        {
+            if (xQueueReceive(prioQueues[p], &idx, 0) == pdTRUE)
+                return true;
+        }
+        return false;
+    }
+
+    void publishTask(void *parameter)
+    {
+        int16_t held = -1; // slot waiting for window / TCP space
+
+        for (;;)
+        {
+            ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(50));
+
+            expireInflight();
+            relaxThrottle();
+
+            for (;;)
+            {
+                uint8_t idx;
+                if (held >= 0)
+                    idx = held;
+                else if (!nextSlot(idx))
+                    break;
+
+                held = -1;
+                PublishSlot &s = slots[idx];
+
+                if (!mqttIsConnected || !mqttClient)
+                {
+                    if (s.storeClass < OUTBOX_CLASS_COUNT &&
+                        SmartCore_Outbox::enqueue((OutboxClass)s.storeClass, s.topic, s.qos, s.retain, s.payload, s.len))
+                        stats.stored++;
+                    else
+                    {
+                        stats.dropped++;
+                        SmartCore_Traffic::dropped(s.topic, TRAFFIC_OUT);
+                    }
+
+                    releaseSlot(idx);
+                    continue;
+                }
+
+                if (s.qos > 0 && inflightCount >= PUBLISH_INFLIGHT_MAX)
+                {
+                    held = idx;
+                    markCongested();
+                    break;
+                }
+
+                lockClient();
+                int64_t sentUs = s.onSent ? esp_timer_get_time() : 0;
+                uint16_t packetId = mqttClient ? mqttClient->publish(s.topic, s.qos, s.retain, s.payload, s.len) : 0;
+                unlockClient();
+
+                if (packetId == 0)
+                {
+                    // TCP send buffer full — try again next tick
+                    held = idx;
+                    markCongested();
+                    break;
+                }
+
+                if (s.qos > 0)
+                {
+                    portENTER_CRITICAL(&pubMux);
+                    if (inflightCount < PUBLISH_INFLIGHT_MAX)
+                        inflight[inflightCount++] = {packetId, millis()};
+                    portEXIT_CRITICAL(&pubMux);
+                }
+
+                if (s.onSent)
+                    s.onSent(s.tag, sentUs);
+
+                stats.sent++;
+                SmartCore_Traffic::count(s.topic, TRAFFIC_OUT, s.len);
+                releaseSlot(idx);
+            }
+        }
+    }
+
+    void init()
+    {
+        if (publishTaskHandle)
+            return;
+
+        freeSmall = xQueueCreate(PUBLISH_SMALL_SLOTS, sizeof(uint8_t));
+        freeLarge = xQueueCreate(PUBLISH_LARGE_SLOTS, sizeof(uint8_t));
+        for (uint8_t p = 0; p < PUB_PRIO_COUNT; p++)
+            prioQueues[p] = xQueueCreate(SLOT_COUNT, sizeof(uint8_t));
+        clientMutex = xSemaphoreCreateRecursiveMutex(); // disconnect callbacks may re-enter
+
+        if (!freeSmall || !freeLarge || !prioQueues[PUB_PRIO_COUNT - 1] || !clientMutex)
+        {
+            logMessage(LOG_ERROR, "❌ Failed to create publish queues");
+            return;
+        }
+
+        for (uint8_t i = 0; i < SLOT_COUNT; i++)
+        {
+            slots[i].payload = i < PUBLISH_SMALL_SLOTS ? smallPool[i] : largePool[i - PUBLISH_SMALL_SLOTS];
+            releaseSlot(i);
+        }
+
+        tokenRefillMs = millis();
+
+        xTaskCreatePinnedToCore(publishTask, "MQTT Publish", 4096, NULL, 2, &publishTaskHandle, 1);
+        logMessage(LOG_INFO, "📮 MQTT publish task started");
+    }
+}
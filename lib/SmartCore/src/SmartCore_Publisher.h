@@ -0,0 +1,82 @@
+#pragma once
+
+#include <Arduino.h>
+#include "SmartCore_Outbox.h"
+
+// Publish pipeline limits (override externally if needed)
+#ifndef PUBLISH_SMALL_SLOTS
+#define PUBLISH_SMALL_SLOTS 16
+#endif
+#ifndef PUBLISH_LARGE_SLOTS
+#define PUBLISH_LARGE_SLOTS 3
+#endif
+#ifndef PUBLISH_INFLIGHT_MAX
+#define PUBLISH_INFLIGHT_MAX 8 // un-acked QoS1 publishes on the wire
+#endif
+
+#define PUBLISH_SMALL_BYTES 512
+#define PUBLISH_LARGE_BYTES 3072
+#define PUBLISH_TOPIC_LEN 64
+#define PUBLISH_RESERVED_SLOTS 4             // small slots telemetry may never take
+#define PUBLISH_INFLIGHT_TIMEOUT_MS 10000
+#define PUBLISH_TELEMETRY_MAX_RATE 40        // msgs/s at throttle level 0
+#define PUBLISH_THROTTLE_MAX_LEVEL 4         // rate >> level
+#define PUBLISH_THROTTLE_STEP_MS 500         // at most one step up per interval
+#define PUBLISH_THROTTLE_RECOVER_MS 5000     // quiet time before stepping back down
+
+#define PUBLISH_NO_STORE OUTBOX_CLASS_COUNT
+
+enum PublishPriority : uint8_t
+{
+    PUB_PRIO_HIGH = 0,  // alarms, errors, OTA progress
+    PUB_PRIO_NORMAL,    // replies, status, history
+    PUB_PRIO_TELEMETRY, // smartnet/<src>/<pgn>/<field>, metrics — shed first
+    PUB_PRIO_COUNT
+};
+
+// Called on the publish task once a message is on the wire; sentUs = esp_timer time
+// taken right before mqttClient->publish()
+typedef void (*PublishSentHook)(int64_t tag, int64_t sentUs);
+
+struct PublishStats
+{
+    uint32_t submitted;
+    uint32_t sent;
+    uint32_t acked;
+    uint32_t dropped;   // no slot / too large / offline with nowhere to store
+    uint32_t stored;    // handed back to the outbox after losing the connection
+    uint32_t throttled; // telemetry shed by the adaptive rate limit
+    uint32_t timeouts;  // QoS1 acks that never came
+    uint8_t inflight;
+    uint8_t throttleLevel;
+};
+
+namespace SmartCore_Publisher
+{
+    extern TaskHandle_t publishTaskHandle;
+
+    // Creates the slot pool, queues and the owner task (idempotent)
+    void init();
+
+    // Copy a message into the pipeline; never blocks. Telemetry may be shed under
+    // congestion (counted, still returns true). storeClass → where it goes if the
+    // connection drops before it is sent. onSent(tag, ...) fires once it has been sent.
+    bool submit(const char *topic, uint8_t qos, bool retain, const char *payload, size_t len,
+                PublishPriority prio, uint8_t storeClass = PUBLISH_NO_STORE,
+                PublishSentHook onSent = nullptr, int64_t tag = 0);
+
+    // AsyncMqttClient callbacks
+    void onPublishAck(uint16_t packetId);
+    void onDisconnect();
+
+    // Held by the owner task around every publish; take it before reconfiguring mqttClient
+    void lockClient();
+    void unlockClient();
+
+    // baseMs stretched by the current throttle level (for periodic producers)
+    uint32_t telemetryInterval(uint32_t baseMs);
+
+    void getStats(PublishStats &out);
+
+    void publishTask(void *parameter);
+}
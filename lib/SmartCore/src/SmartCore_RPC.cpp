@@ -0,0 +1,285 @@
+#include "SmartCore_RPC.h"
+#include <ArduinoJson.h>
+#include "SmartCore_MQTT.h"
+#include "SmartCore_Time.h"
+#include "SmartCore_Log.h"
+
+namespace SmartCore_RPC
+{
+    // ======================================================================================
+    //  REQUEST / RESPONSE
+    // ======================================================================================
+    //
+    //  Commands used to be fire-and-forget: a retried "softReset" ran twice, and two
+    //  "getConfig" in flight could not be told apart on module/config/update. Any
+    //  command may now carry an envelope next to its normal fields:
+    //
+    //      { "reqId": "b7e1…", "deadline": 1718000000, "replyTo": "smartbox/rpc/7", ...}
+    //
+    //      reqId     correlation ID chosen by the caller (required for RPC behaviour)
+    //      deadline  SmartBoat epoch seconds; later → "expired", handler not run
+    //                (only enforced once SmartBoat time is known)
+    //      replyTo   reply topic, default RPC_DEFAULT_REPLY_TOPIC
+    //
+    //  Replies are {"reqId","status":"ok","result":<handler payload>}, "error",
+    //  "done" (handler published nothing), "expired" or "duplicate".
+    //
+    //  The first reply to every reqId is kept in a RPC_CACHE_SLOTS LRU. A retry with
+    //  the same reqId gets that reply again and the handler does not run — commands
+    //  are executed at most once per reqId while it is remembered.
+    //
+    //  Everything happens on the MQTT worker task (handlers run one at a time), so the
+    //  cache and the current request need no locking. Messages without a reqId take
+    //  the legacy path untouched.
+    //
+    // ======================================================================================
+
+    struct RpcEntry
+    {
+        char id[RPC_ID_LEN];
+        char reply[RPC_REPLY_MAX];
+        uint16_t len; // 0 = reply too large to keep → replay as "duplicate"
+        uint32_t used;
+        bool valid;
+    };
+
+    static RpcEntry cache[RPC_CACHE_SLOTS];
+    static uint32_t useCounter = 0;
+
+    static bool active = false; // a request is being handled
+    static TaskHandle_t owner = nullptr;
+    static char currentId[RPC_ID_LEN];
+    static char currentTopic[RPC_TOPIC_LEN];
+    static bool answered = false;
+    static bool isDeferred = false;
+
+    static char replyBuffer[RPC_REPLY_MAX];
+    static RpcStats stats = {};
+
+    // IDs are spliced into replies verbatim — keep them plain
+    static bool validId(const char *id)
+    {
+        size_t n = strlen(id);
+        if (n == 0 || n >= RPC_ID_LEN)
+            return false;
+
+        for (size_t i = 0; i < n; i++)
+        {
+            if (id[i] < 0x20 || id[i] == '"' || id[i] == '\\')
+                return false;
+        }
+        return true;
+    }
+
+    static bool validTopic(const char *topic)
+    {
+        size_t n = strlen(topic);
+        return n > 0 && n < RPC_TOPIC_LEN && !strpbrk(topic, "+#");
+    }
+
+    static RpcEntry *find(const char *id)
+    {
+        for (uint8_t i = 0; i < RPC_CACHE_SLOTS; i++)
+        {
+            if (cache[i].valid && !strcmp(cache[i].id, id))
+            {
+                cache[i].used = ++useCounter;
+                return &cache[i];
+            }
+        }
+        return nullptr;
+    }
+
+    static void remember(const char *json, size_t len)
+    {
+        RpcEntry *slot = &cache[0];
+        for (uint8_t i = 0; i < RPC_CACHE_SLOTS; i++)
+        {
+            if (!cache[i].valid)
+            {
+                slot = &cache[i];
+                break;
+            }
+            if (cache[i].used < slot->used)
+                slot = &cache[i];
+        }
+
+        strlcpy(slot->id, currentId, sizeof(slot->id));
+        slot->len = len < RPC_REPLY_MAX ? len : 0;
+        if (slot->len)
+            memcpy(slot->reply, json, len);
+        slot->used = ++useCounter;
+        slot->valid = true;
+    }
+
+    static void publish(const char *json, size_t len)
+    {
+        SmartCore_MQTT::mqttSafePublish(currentTopic, 1, false, json, len);
+        stats.replies++;
+    }
+
+    // Reply of the current request; the first one is what a retry gets back
+    // (unless deferred — then nothing is cached and a retry runs the handler again)
+    static void reply(const char *json, size_t len)
+    {
+        publish(json, len);
+        if (!answered)
+        {
+            if (!isDeferred)
+                remember(json, len);
+            answered = true;
+        }
+    }
+
+    static size_t buildStatus(const char *status, const char *error)
+    {
+        StaticJsonDocument<192> doc;
+        doc["reqId"] = (const char *)currentId;
+        doc["status"] = status;
+        if (error)
+            doc["error"] = error;
+        return serializeJson(doc, replyBuffer, sizeof(replyBuffer));
+    }
+
+    static bool inRequest()
+    {
+        return active && xTaskGetCurrentTaskHandle() == owner;
+    }
+
+    bool begin(const char *payload, size_t len)
+    {
+        active = false;
+
+        // Cheap pre-check — most traffic has no envelope (payload is null-terminated)
+        if (!strstr(payload, "\"reqId\""))
+            return true;
+
+        StaticJsonDocument<64> filter;
+        filter["reqId"] = true;
+        filter["deadline"] = true;
+        filter["replyTo"] = true;
+
+        StaticJsonDocument<256> env;
+        if (deserializeJson(env, payload, len, DeserializationOption::Filter(filter)))
+            return true; // the handler reports bad JSON itself
+
+        const char *id = env["reqId"] | "";
+        if (!validId(id))
+        {
+            logMessage(LOG_WARN, "⚠️ RPC request ID missing or invalid — handled without RPC");
+            return true;
+        }
+
+        const char *replyTo = env["replyTo"] | RPC_DEFAULT_REPLY_TOPIC;
+        if (!validTopic(replyTo))
+            replyTo = RPC_DEFAULT_REPLY_TOPIC;
+
+        strlcpy(currentId, id, sizeof(currentId));
+        strlcpy(currentTopic, replyTo, sizeof(currentTopic));
+        stats.requests++;
+
+        RpcEntry *hit = find(id);
+        if (hit)
+        {
+            stats.replayed++;
+            Serial.printf("🔁 RPC %s already handled — replaying reply\n", currentId);
+
+            if (hit->len)
+                publish(hit->reply, hit->len);
+            else
+                publish(replyBuffer, buildStatus("duplicate", nullptr));
+            return false;
+        }
+
+        uint32_t deadline = env["deadline"] | 0UL;
+        if (deadline && smartBoatTimeValid() && getCurrentSmartBoatTime() > deadline)
+        {
+            stats.expired++;
+            logMessage(LOG_WARN, String("⌛ RPC ") + currentId + " arrived after its deadline — skipped");
+
+            // Not remembered: a retry with a fresh deadline may still run
+            publish(replyBuffer, buildStatus("expired", nullptr));
+            return false;
+        }
+
+        owner = xTaskGetCurrentTaskHandle();
+        answered = false;
+        isDeferred = false;
+        active = true;
+        return true;
+    }
+
+    void end()
+    {
+        if (active && !answered && !isDeferred)
+            reply(replyBuffer, buildStatus("done", nullptr));
+
+        active = false;
+    }
+
+    bool respond(const char *legacyTopic, uint8_t qos, bool retain, const char *payload, size_t len)
+    {
+        if (!inRequest())
+            return SmartCore_MQTT::mqttSafePublish(legacyTopic, qos, retain, payload, len);
+
+        if (len == 0)
+            len = strlen(payload);
+
+        // Retained topics carry state other subscribers rely on
+        bool ok = true;
+        if (retain)
+            ok = SmartCore_MQTT::mqttSafePublish(legacyTopic, qos, retain, payload, len);
+
+        char head[RPC_ID_LEN + 40];
+        size_t headLen = snprintf(head, sizeof(head), "{\"reqId\":\"%s\",\"status\":\"ok\",\"result\":", currentId);
+        size_t total = headLen + len + 1;
+
+        if (total < sizeof(replyBuffer))
+        {
+            memcpy(replyBuffer, head, headLen);
+            memcpy(replyBuffer + headLen, payload, len);
+            replyBuffer[total - 1] = '}';
+            reply(replyBuffer, total);
+        }
+        else
+        {
+            char *wrapped = (char *)malloc(total);
+            if (!wrapped)
+            {
+                fail("out of memory");
+                return false;
+            }
+
+            memcpy(wrapped, head, headLen);
+            memcpy(wrapped + headLen, payload, len);
+            wrapped[total - 1] = '}';
+            reply(wrapped, total);
+            free(wrapped);
+        }
+
+        return ok;
+    }
+
+    void fail(const char *error)
+    {
+        if (inRequest())
+            reply(replyBuffer, buildStatus("error", error));
+    }
+
+    void complete()
+    {
+        if (inRequest() && !answered)
+            reply(replyBuffer, buildStatus("done", nullptr));
+    }
+
+    void deferred()
+    {
+        if (inRequest())
+            isDeferred = true;
+    }
+
+    void getStats(RpcStats &out)
+    {
+        out = stats;
+    }
+}
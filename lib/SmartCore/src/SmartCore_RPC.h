@@ -0,0 +1,48 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Request / response over MQTT (override externally if needed)
+#ifndef RPC_CACHE_SLOTS
+#define RPC_CACHE_SLOTS 8 // recent request IDs kept for replay
+#endif
+#ifndef RPC_REPLY_MAX
+#define RPC_REPLY_MAX 512 // larger replies are sent but replayed as "duplicate"
+#endif
+#define RPC_ID_LEN 40
+#define RPC_TOPIC_LEN 64
+#define RPC_DEFAULT_REPLY_TOPIC "module/rpc"
+
+struct RpcStats
+{
+    uint32_t requests;  // messages carrying a reqId
+    uint32_t replayed;  // ...answered from the cache, handler not run
+    uint32_t expired;   // ...past their deadline, handler not run
+    uint32_t replies;   // replies published
+};
+
+namespace SmartCore_RPC
+{
+    // Worker task, around every handler call. begin() returns false when the message
+    // must not reach the handler (replayed from the cache, or past its deadline).
+    bool begin(const char *payload, size_t len);
+    void end();
+
+    // Handler response. Outside a request (or from another task) this is exactly
+    // mqttSafePublish(legacyTopic, ...). Inside one, the payload goes to the request's
+    // replyTo wrapped as {"reqId","status":"ok","result":...}; retained legacy topics
+    // hold state and are published as well.
+    bool respond(const char *legacyTopic, uint8_t qos, bool retain, const char *payload, size_t len = 0);
+
+    // Reply {"reqId","status":"error","error":...} to the current request, if any
+    void fail(const char *error);
+
+    // Reply {"reqId","status":"done"} now instead of after the handler (it may not return)
+    void complete();
+
+    // The answer is produced later by another task, or spans several respond() calls:
+    // no automatic reply, nothing cached (a retry runs the handler again)
+    void deferred();
+
+    void getStats(RpcStats &out);
+}
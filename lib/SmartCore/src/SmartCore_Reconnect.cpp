@@ -0,0 +1,109 @@
+#include "SmartCore_Reconnect.h"
+#include <WiFi.h>
+#include <ArduinoJson.h>
+#include "SmartCore_Log.h"
+#include "SmartCore_Backoff.h"
+
+namespace SmartCore_Reconnect
+{
+    // ======================================================================================
+    //  RECONNECT SCHEDULING
+    // ======================================================================================
+    //
+    //  When the SmartBox restarts, every module loses the broker in the same second.
+    //  With a fixed backoff they would all come back in the same second too — right
+    //  when the broker is least able to take it. Two things spread them out:
+    //
+    //  1) First attempt of an outage (firstDelay)
+    //        The broker host publishes a retained admission hint on
+    //        RECONNECT_ADMISSION_TOPIC:  {"windowMs": W, "slots": N}
+    //        Each module keeps the last hint it heard and, after a drop, waits for
+    //        its own slot:  slot = hash(MAC) % N  →  slot·W/N + jitter within the slot.
+    //        No hint yet → random delay in [0, RECONNECT_SPREAD_MS].
+    //
+    //  2) Every further attempt (nextDelay) — "decorrelated jitter":
+    //        sleep = min(CAP, random(BASE, sleep·3))
+    //        Same growth as doubling, but two modules that failed together do not
+    //        stay in lockstep.
+    //
+    //  The generator is seeded from the MAC mixed with the hardware RNG, so every
+    //  module draws its own sequence. The math itself lives in SmartCore_Backoff
+    //  (framework-free); test/native/test_reconnect_sim runs it for a whole fleet.
+    //
+    // ======================================================================================
+
+    static portMUX_TYPE reconnectMux = portMUX_INITIALIZER_UNLOCKED;
+    static bool seeded = false;
+    static uint32_t macHash = 0;
+    static uint32_t rngState = 0;
+    static uint32_t sleepMs = RECONNECT_BASE_MS;
+
+    static uint32_t windowMs = 0; // 0 = no admission hint heard
+    static uint16_t windowSlots = 0;
+
+    static void seed()
+    {
+        uint8_t mac[6];
+        WiFi.macAddress(mac);
+
+        macHash = SmartCore_Backoff::hashMac(mac);
+        rngState = SmartCore_Backoff::seed(macHash, esp_random());
+        seeded = true;
+    }
+
+    uint32_t firstDelay()
+    {
+        if (!seeded)
+            seed();
+
+        portENTER_CRITICAL(&reconnectMux);
+        uint32_t w = windowMs;
+        uint16_t n = windowSlots;
+        portEXIT_CRITICAL(&reconnectMux);
+
+        uint32_t delay = SmartCore_Backoff::firstDelay(rngState, macHash, w, n, RECONNECT_SPREAD_MS);
+        if (w == 0 || n == 0)
+            return delay;
+
+        logMessage(LOG_INFO, "🎟️ Reconnect slot " + String(macHash % n) + "/" + String(n) +
+                                 " → " + String(delay) + " ms");
+        return delay;
+    }
+
+    uint32_t nextDelay()
+    {
+        if (!seeded)
+            seed();
+
+        sleepMs = SmartCore_Backoff::decorrelated(rngState, sleepMs, RECONNECT_BASE_MS, RECONNECT_CAP_MS);
+        return sleepMs;
+    }
+
+    void reset()
+    {
+        sleepMs = RECONNECT_BASE_MS;
+    }
+
+    void handleAdmission(const char *payload, size_t len)
+    {
+        StaticJsonDocument<128> doc;
+        if (deserializeJson(doc, payload, len))
+        {
+            logMessage(LOG_WARN, "⚠️ Admission hint is not valid JSON");
+            return;
+        }
+
+        uint32_t w = min<uint32_t>(doc["windowMs"] | 0UL, RECONNECT_WINDOW_MAX_MS);
+        uint32_t n = doc["slots"] | 0UL;
+        if (n == 0)
+            n = w / 500; // default: half-second slots
+        n = constrain(n, 1UL, 1000UL);
+
+        portENTER_CRITICAL(&reconnectMux);
+        windowMs = w;
+        windowSlots = w ? n : 0;
+        portEXIT_CRITICAL(&reconnectMux);
+
+        logMessage(LOG_INFO, "🎟️ Admission window " + String(w) + " ms / " + String(w ? n : 0) + " slots");
+    }
+}
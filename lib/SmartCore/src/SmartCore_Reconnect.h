@@ -0,0 +1,33 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Reconnect scheduling (override externally if needed)
+#ifndef RECONNECT_BASE_MS
+#define RECONNECT_BASE_MS 5000
+#endif
+#ifndef RECONNECT_CAP_MS
+#define RECONNECT_CAP_MS (5UL * 60UL * 1000UL)
+#endif
+#define RECONNECT_SPREAD_MS 5000       // first attempt after a drop when no hint is known
+#define RECONNECT_WINDOW_MAX_MS 120000 // admission windows are clamped to this
+
+// Retained, published by the broker host:  {"windowMs": 30000, "slots": 60}
+#define RECONNECT_ADMISSION_TOPIC "smartboat/admission"
+
+namespace SmartCore_Reconnect
+{
+    // Delay before the first reconnect of an outage: this module's slot in the
+    // last admission window heard, or a random spread if there was none
+    uint32_t firstDelay();
+
+    // Delay after a failed attempt (decorrelated jitter, RECONNECT_BASE_MS..CAP)
+    uint32_t nextDelay();
+
+    // Connected again / new broker — the next backoff starts from the base
+    void reset();
+
+    // RECONNECT_ADMISSION_TOPIC handler (MQTT worker)
+    void handleAdmission(const char *payload, size_t len);
+}
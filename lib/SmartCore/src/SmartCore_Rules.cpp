@@ -0,0 +1,694 @@
+#include "SmartCore_Rules.h"
+#include <ArduinoJson.h>
+#include <LittleFS.h>
+#include "SmartCore_MQTT.h"
+#include "SmartCore_RPC.h"
+#include "SmartCore_MCP.h"
+#include "SmartCore_Network.h"
+#include "SmartCore_Log.h"
+#include "SmartCore_Hash.h"
+
+namespace SmartCore_Rules
+{
+    TaskHandle_t rulesTaskHandle = NULL;
+
+    enum RuleOp : uint8_t
+    {
+        OP_LT,
+        OP_LE,
+        OP_GT,
+        OP_GE,
+        OP_EQ,
+        OP_NE
+    };
+
+    enum RuleActionType : uint8_t
+    {
+        ACTION_NONE,
+        ACTION_MCP,
+        ACTION_PUBLISH
+    };
+
+    struct Signal
+    {
+        char name[RULES_SIGNAL_NAME_LEN];
+        uint32_t hash;
+        float value;
+        bool valid;
+        uint32_t dependents; // bit N → rules[N] reads this signal
+    };
+
+    struct RuleTerm
+    {
+        uint8_t signal;
+        RuleOp op;
+        float value;
+    };
+
+    struct RuleAction
+    {
+        RuleActionType type;
+        uint8_t pin;
+        bool level;
+        char topic[RULES_TOPIC_LEN];
+        char payload[RULES_PAYLOAD_LEN];
+    };
+
+    struct Rule
+    {
+        char id[RULES_ID_LEN];
+        RuleTerm terms[RULES_MAX_TERMS];
+        uint8_t termCount;
+        uint32_t holdMs;
+        RuleAction onTrue;
+        RuleAction onFalse;
+        bool active;
+        bool pending;
+        uint32_t pendingSince;
+    };
+
+    // Live tables (guarded by rulesMutex)
+    static Signal signals[RULES_MAX_SIGNALS];
+    static Rule rules[RULES_MAX_RULES];
+    static uint8_t signalCount = 0;
+    static uint8_t rulesLoaded = 0;
+    static uint32_t pendingMask = 0;
+
+    // Staging tables — a new rule set is compiled here and only swapped in when valid
+    static Signal stagedSignals[RULES_MAX_SIGNALS];
+    static Rule stagedRules[RULES_MAX_RULES];
+    static uint8_t stagedSignalCount = 0;
+    static uint8_t stagedRuleCount = 0;
+
+    static SemaphoreHandle_t rulesMutex = nullptr;
+
+    // Actions are copied out under rulesMutex and run by the rules task without it, so
+    // I2C / publish latency never holds up evaluation, and a rule whose publish loops
+    // back into updateValue() can't deadlock.
+    struct FiredAction
+    {
+        char ruleId[RULES_ID_LEN];
+        RuleAction action;
+    };
+
+    static QueueHandle_t actionQueue = nullptr;
+
+    static uint32_t hashName(const char *name)
+    {
+        // FNV-1a — cheap, good enough for <= 32 names
+        return SmartCore_Hash::fnv1a(name);
+    }
+
+    static int findSignal(const Signal *table, uint8_t count, const char *name, uint32_t hash)
+    {
+        for (uint8_t i = 0; i < count; i++)
+        {
+            if (table[i].hash == hash && !strcmp(table[i].name, name))
+                return i;
+        }
+        return -1;
+    }
+
+    static bool parseOp(const char *op, RuleOp &out)
+    {
+        if (!strcmp(op, "<"))  { out = OP_LT; return true; }
+        if (!strcmp(op, "<=")) { out = OP_LE; return true; }
+        if (!strcmp(op, ">"))  { out = OP_GT; return true; }
+        if (!strcmp(op, ">=")) { out = OP_GE; return true; }
+        if (!strcmp(op, "==")) { out = OP_EQ; return true; }
+        if (!strcmp(op, "!=")) { out = OP_NE; return true; }
+        return false;
+    }
+
+    static bool compare(float lhs, RuleOp op, float rhs)
+    {
+        switch (op)
+        {
+        case OP_LT: return lhs < rhs;
+        case OP_LE: return lhs <= rhs;
+        case OP_GT: return lhs > rhs;
+        case OP_GE: return lhs >= rhs;
+        case OP_EQ: return lhs == rhs;
+        case OP_NE: return lhs != rhs;
+        default:    return false;
+        }
+    }
+
+    // ======================================================================================
+    //  RULE SET COMPILER
+    // ======================================================================================
+    //
+    //  Rule sets arrive as JSON on <serialNumber>/rules and are persisted to LittleFS:
+    //
+    //    {
+    //      "rules": [
+    //        { "id": "shallow",
+    //          "when": [ { "signal": "depth", "op": "<", "value": 2.0 } ],
+    //          "then": { "action": "mcp", "pin": 3, "value": 1 },
+    //          "else": { "action": "mcp", "pin": 3, "value": 0 } },
+    //
+    //        { "id": "bilge",
+    //          "when": { "signal": "bilge", "op": ">=", "value": 1 },
+    //          "for": 30000,
+    //          "then": { "action": "publish", "topic": "module/alarm", "payload": "bilge active" } }
+    //      ]
+    //    }
+    //
+    //  • "when" terms are AND-ed (max RULES_MAX_TERMS).
+    //  • "for" holds the condition true for N ms before "then" fires.
+    //  • "then" fires on the false → true edge, "else" on the true → false edge.
+    //
+    //  Each signal keeps a bitmask of the rules that read it (dependency index), so an
+    //  updateValue() only evaluates the rules that actually depend on that signal.
+    //
+    // ======================================================================================
+
+    static bool compileAction(JsonVariantConst src, RuleAction &action, String &error)
+    {
+        memset(&action, 0, sizeof(action));
+
+        if (src.isNull())
+            return true; // optional
+
+        const char *type = src["action"] | "";
+
+        if (!strcmp(type, "mcp"))
+        {
+            int pin = src["pin"] | -1;
+            if (pin < 0 || pin > 7)
+            {
+                error = "mcp pin out of range";
+                return false;
+            }
+
+            action.type = ACTION_MCP;
+            action.pin = (uint8_t)pin;
+            action.level = src["value"].as<bool>();
+            return true;
+        }
+
+        if (!strcmp(type, "publish"))
+        {
+            const char *topic = src["topic"] | "";
+            if (strlen(topic) == 0 || strlen(topic) >= RULES_TOPIC_LEN)
+            {
+                error = "publish topic missing or too long";
+                return false;
+            }
+
+            action.type = ACTION_PUBLISH;
+            strncpy(action.topic, topic, RULES_TOPIC_LEN - 1);
+
+            JsonVariantConst payload = src["payload"];
+            if (payload.is<const char *>())
+                strncpy(action.payload, payload.as<const char *>(), RULES_PAYLOAD_LEN - 1);
+            else if (!payload.isNull())
+                serializeJson(payload, action.payload, RULES_PAYLOAD_LEN);
+
+            return true;
+        }
+
+        error = String("unknown action '") + type + "'";
+        return false;
+    }
+
+    static bool compileTerm(JsonVariantConst src, uint8_t ruleIndex, RuleTerm &term, String &error)
+    {
+        const char *name = src["signal"] | "";
+        const char *op = src["op"] | "";
+
+        if (strlen(name) == 0 || strlen(name) >= RULES_SIGNAL_NAME_LEN)
+        {
+            error = "signal name missing or too long";
+            return false;
+        }
+
+        if (!parseOp(op, term.op))
+        {
+            error = String("unknown op '") + op + "'";
+            return false;
+        }
+
+        if (!src["value"].is<float>())
+        {
+            error = String("term on '") + name + "' has no numeric value";
+            return false;
+        }
+        term.value = src["value"].as<float>();
+
+        // Intern the signal name
+        uint32_t hash = hashName(name);
+        int idx = findSignal(stagedSignals, stagedSignalCount, name, hash);
+
+        if (idx < 0)
+        {
+            if (stagedSignalCount >= RULES_MAX_SIGNALS)
+            {
+                error = "too many signals";
+                return false;
+            }
+
+            idx = stagedSignalCount++;
+            Signal &s = stagedSignals[idx];
+            memset(&s, 0, sizeof(s));
+            strncpy(s.name, name, RULES_SIGNAL_NAME_LEN - 1);
+            s.hash = hash;
+        }
+
+        stagedSignals[idx].dependents |= (1UL << ruleIndex);
+        term.signal = (uint8_t)idx;
+        return true;
+    }
+
+    static bool compileRuleSet(JsonArrayConst list, String &error)
+    {
+        stagedSignalCount = 0;
+        stagedRuleCount = 0;
+
+        if (list.size() > RULES_MAX_RULES)
+        {
+            error = "too many rules (max " + String(RULES_MAX_RULES) + ")";
+            return false;
+        }
+
+        for (JsonVariantConst src : list)
+        {
+            uint8_t index = stagedRuleCount;
+            Rule &rule = stagedRules[index];
+            memset(&rule, 0, sizeof(rule));
+
+            const char *id = src["id"] | "";
+            strncpy(rule.id, strlen(id) ? id : "rule", RULES_ID_LEN - 1);
+
+            JsonVariantConst when = src["when"];
+            if (when.is<JsonArrayConst>())
+            {
+                for (JsonVariantConst t : when.as<JsonArrayConst>())
+                {
+                    if (rule.termCount >= RULES_MAX_TERMS)
+                    {
+                        error = String(rule.id) + ": too many terms";
+                        return false;
+                    }
+                    if (!compileTerm(t, index, rule.terms[rule.termCount++], error))
+                        return false;
+                }
+            }
+            else if (when.is<JsonObjectConst>())
+            {
+                if (!compileTerm(when, index, rule.terms[rule.termCount++], error))
+                    return false;
+            }
+
+            if (rule.termCount == 0)
+            {
+                error = String(rule.id) + ": missing 'when'";
+                return false;
+            }
+
+            rule.holdMs = src["for"] | 0;
+
+            if (!compileAction(src["then"], rule.onTrue, error) ||
+                !compileAction(src["else"], rule.onFalse, error))
+            {
+                error = String(rule.id) + ": " + error;
+                return false;
+            }
+
+            stagedRuleCount++;
+        }
+
+        return true;
+    }
+
+    // ======================================================================================
+    //  EVALUATION (caller holds rulesMutex)
+    // ======================================================================================
+
+    // Hands the action to the rules task (runAction)
+    static void fire(const Rule &rule, const RuleAction &action)
+    {
+        if (action.type == ACTION_NONE)
+            return;
+
+        FiredAction f;
+        strlcpy(f.ruleId, rule.id, sizeof(f.ruleId));
+        f.action = action;
+
+        if (xQueueSend(actionQueue, &f, 0) != pdTRUE)
+        {
+            logMessage(LOG_WARN, String("⚠️ Rule '") + rule.id + "' action dropped — queue full");
+            return;
+        }
+
+        if (rulesTaskHandle)
+            xTaskNotifyGive(rulesTaskHandle);
+    }
+
+    // Rules task only, rulesMutex NOT held
+    static void runAction(const FiredAction &f)
+    {
+        const RuleAction &action = f.action;
+
+        switch (action.type)
+        {
+        case ACTION_MCP:
+            SmartCore_MCP::digitalWrite(action.pin, action.level);
+            logMessage(LOG_INFO, String("⚙️ Rule '") + f.ruleId + "' → MCP pin " +
+                                     String(action.pin) + " = " + String(action.level ? 1 : 0));
+            break;
+
+        case ACTION_PUBLISH:
+            SmartCore_MQTT::mqttSafePublish(action.topic, 1, false, action.payload);
+            logMessage(LOG_INFO, String("⚙️ Rule '") + f.ruleId + "' → publish " + action.topic);
+            break;
+
+        default:
+            break;
+        }
+    }
+
+    static void evaluateRule(uint8_t index, uint32_t now)
+    {
+        Rule &rule = rules[index];
+
+        bool condition = true;
+        for (uint8_t t = 0; t < rule.termCount && condition; t++)
+        {
+            const RuleTerm &term = rule.terms[t];
+            const Signal &s = signals[term.signal];
+            condition = s.valid && compare(s.value, term.op, term.value);
+        }
+
+        if (condition)
+        {
+            if (rule.active || rule.pending)
+                return;
+
+            if (rule.holdMs == 0)
+            {
+                rule.active = true;
+                fire(rule, rule.onTrue);
+            }
+            else
+            {
+                rule.pending = true;
+                rule.pendingSince = now;
+                pendingMask |= (1UL << index);
+            }
+        }
+        else
+        {
+            if (rule.pending)
+            {
+                rule.pending = false;
+                pendingMask &= ~(1UL << index);
+            }
+
+            if (rule.active)
+            {
+                rule.active = false;
+                fire(rule, rule.onFalse);
+            }
+        }
+    }
+
+    static void evaluateMask(uint32_t mask, uint32_t now)
+    {
+        while (mask)
+        {
+            uint8_t index = __builtin_ctz(mask);
+            mask &= mask - 1;
+            evaluateRule(index, now);
+        }
+    }
+
+    void updateValue(const char *signal, float value)
+    {
+        if (!rulesMutex || rulesLoaded == 0)
+            return;
+
+        uint32_t hash = hashName(signal);
+
+        if (xSemaphoreTake(rulesMutex, pdMS_TO_TICKS(50)) != pdTRUE)
+            return;
+
+        int idx = findSignal(signals, signalCount, signal, hash);
+        if (idx >= 0)
+        {
+            Signal &s = signals[idx];
+
+            // Only changes propagate — unchanged samples cost one lookup
+            if (!s.valid || s.value != value)
+            {
+                s.value = value;
+                s.valid = true;
+                evaluateMask(s.dependents, millis());
+            }
+        }
+
+        xSemaphoreGive(rulesMutex);
+    }
+
+    // ======================================================================================
+    //  RULE SET LIFECYCLE
+    // ======================================================================================
+
+    static bool applyRuleSet(JsonArrayConst list, String &error)
+    {
+        if (!rulesMutex)
+        {
+            error = "rules engine not initialised";
+            return false;
+        }
+
+        if (!compileRuleSet(list, error))
+            return false;
+
+        if (xSemaphoreTake(rulesMutex, pdMS_TO_TICKS(500)) != pdTRUE)
+        {
+            error = "rules engine busy";
+            return false;
+        }
+
+        // Carry known values across so rules evaluate immediately
+        for (uint8_t i = 0; i < stagedSignalCount; i++)
+        {
+            Signal &s = stagedSignals[i];
+            int old = findSignal(signals, signalCount, s.name, s.hash);
+            if (old >= 0)
+            {
+                s.value = signals[old].value;
+                s.valid = signals[old].valid;
+            }
+        }
+
+        memcpy(signals, stagedSignals, sizeof(Signal) * stagedSignalCount);
+        memcpy(rules, stagedRules, sizeof(Rule) * stagedRuleCount);
+        signalCount = stagedSignalCount;
+        rulesLoaded = stagedRuleCount;
+        pendingMask = 0;
+
+        for (uint8_t i = 0; i < rulesLoaded; i++)
+        {
+            if (rules[i].onTrue.type == ACTION_MCP)
+                SmartCore_MCP::setPinMode(rules[i].onTrue.pin, OUTPUT);
+            if (rules[i].onFalse.type == ACTION_MCP)
+                SmartCore_MCP::setPinMode(rules[i].onFalse.pin, OUTPUT);
+        }
+
+        evaluateMask(rulesLoaded >= 32 ? 0xFFFFFFFFUL : ((1UL << rulesLoaded) - 1), millis());
+
+        xSemaphoreGive(rulesMutex);
+
+        logMessage(LOG_INFO, "📐 Rule set loaded: " + String(rulesLoaded) + " rules, " +
+                                 String(signalCount) + " signals");
+        return true;
+    }
+
+    bool loadRuleSet(const char *json, size_t len, bool persist)
+    {
+        DynamicJsonDocument doc(RULES_DOC_SIZE);
+        DeserializationError err = deserializeJson(doc, json, len);
+
+        if (err)
+        {
+            logMessage(LOG_WARN, String("❌ Failed to parse rule set: ") + err.c_str());
+            return false;
+        }
+
+        String error;
+        if (!applyRuleSet(doc["rules"].as<JsonArrayConst>(), error))
+        {
+            logMessage(LOG_WARN, "❌ Rule set rejected: " + error);
+            return false;
+        }
+
+        if (persist)
+        {
+            File f = LittleFS.open(RULES_FILE, "w");
+            if (f)
+            {
+                f.write((const uint8_t *)json, len);
+                f.close();
+            }
+            else
+            {
+                logMessage(LOG_WARN, "⚠️ Could not persist rule set to LittleFS");
+            }
+        }
+
+        return true;
+    }
+
+    void clearRules()
+    {
+        if (!rulesMutex)
+            return;
+
+        if (xSemaphoreTake(rulesMutex, pdMS_TO_TICKS(500)) == pdTRUE)
+        {
+            rulesLoaded = 0;
+            signalCount = 0;
+            pendingMask = 0;
+            xSemaphoreGive(rulesMutex);
+        }
+
+        LittleFS.remove(RULES_FILE);
+        logMessage(LOG_INFO, "🧹 Rule set cleared");
+    }
+
+    uint8_t ruleCount()
+    {
+        return rulesLoaded;
+    }
+
+    static void publishRulesStatus(const char *status, const String &error)
+    {
+        StaticJsonDocument<256> doc;
+        doc["serialNumber"] = serialNumber;
+        doc["status"] = status;
+        doc["rules"] = rulesLoaded;
+        doc["signals"] = signalCount;
+        if (error.length())
+            doc["error"] = error;
+
+        char payload[256];
+        size_t len = serializeJson(doc, payload, sizeof(payload));
+        SmartCore_RPC::respond("module/rules", 1, false, payload, len);
+    }
+
+    void handleRulesMessage(const char *payload, size_t len)
+    {
+        Serial.println("📐 Rules message received");
+
+        DynamicJsonDocument doc(RULES_DOC_SIZE);
+        DeserializationError err = deserializeJson(doc, payload, len);
+
+        if (err)
+        {
+            publishRulesStatus("error", String("bad JSON: ") + err.c_str());
+            return;
+        }
+
+        const char *action = doc["action"] | "set";
+
+        if (!strcmp(action, "clear"))
+        {
+            clearRules();
+            publishRulesStatus("cleared", "");
+        }
+        else if (!strcmp(action, "status"))
+        {
+            publishRulesStatus("status", "");
+        }
+        else if (!strcmp(action, "set"))
+        {
+            String error;
+            if (!applyRuleSet(doc["rules"].as<JsonArrayConst>(), error))
+            {
+                publishRulesStatus("error", error);
+                return;
+            }
+
+            File f = LittleFS.open(RULES_FILE, "w");
+            if (f)
+            {
+                f.write((const uint8_t *)payload, len);
+                f.close();
+            }
+
+            publishRulesStatus("loaded", "");
+        }
+        else
+        {
+            publishRulesStatus("error", String("unsupported action '") + action + "'");
+        }
+    }
+
+    void rulesTask(void *parameter)
+    {
+        FiredAction f;
+
+        for (;;)
+        {
+            if (pendingMask && xSemaphoreTake(rulesMutex, pdMS_TO_TICKS(50)) == pdTRUE)
+            {
+                uint32_t now = millis();
+                uint32_t mask = pendingMask;
+
+                while (mask)
+                {
+                    uint8_t index = __builtin_ctz(mask);
+                    mask &= mask - 1;
+
+                    Rule &rule = rules[index];
+                    if (now - rule.pendingSince >= rule.holdMs)
+                    {
+                        rule.pending = false;
+                        rule.active = true;
+                        pendingMask &= ~(1UL << index);
+                        fire(rule, rule.onTrue);
+                    }
+                }
+
+                xSemaphoreGive(rulesMutex);
+            }
+
+            // ⚙️ Fired actions, in order, outside the lock
+            while (xQueueReceive(actionQueue, &f, 0) == pdTRUE)
+                runAction(f);
+
+            // Woken early when updateValue() fires something
+            ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(RULES_TICK_MS));
+        }
+    }
+
+    void init()
+    {
+        if (!rulesMutex)
+            rulesMutex = xSemaphoreCreateMutex();
+        if (!actionQueue)
+            actionQueue = xQueueCreate(RULES_ACTION_QUEUE, sizeof(FiredAction));
+
+        if (!rulesMutex || !actionQueue)
+        {
+            logMessage(LOG_ERROR, "❌ Failed to create rules mutex");
+            return;
+        }
+
+        if (LittleFS.exists(RULES_FILE))
+        {
+            File f = LittleFS.open(RULES_FILE, "r");
+            if (f)
+            {
+                String json = f.readString();
+                f.close();
+                loadRuleSet(json.c_str(), json.length(), false);
+            }
+        }
+
+        if (!rulesTaskHandle)
+            xTaskCreatePinnedToCore(rulesTask, "Rules Task", 3072, NULL, 1, &rulesTaskHandle, 1);
+    }
+}
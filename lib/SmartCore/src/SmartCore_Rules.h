@@ -0,0 +1,44 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Rule engine limits (override externally if needed)
+#ifndef RULES_MAX_RULES
+#define RULES_MAX_RULES 32 // must stay <= 32 (dependency bitmask)
+#endif
+
+#ifndef RULES_MAX_SIGNALS
+#define RULES_MAX_SIGNALS 32
+#endif
+
+#define RULES_MAX_TERMS 3
+#define RULES_SIGNAL_NAME_LEN 32
+#define RULES_ID_LEN 24
+#define RULES_TOPIC_LEN 48
+#define RULES_PAYLOAD_LEN 64
+#define RULES_TICK_MS 100
+#define RULES_ACTION_QUEUE 8 // fired actions waiting for the rules task
+
+#define RULES_FILE "/rules.json"
+#define RULES_DOC_SIZE 6144
+
+namespace SmartCore_Rules
+{
+    extern TaskHandle_t rulesTaskHandle;
+
+    // Startup (loads persisted rule set from LittleFS)
+    void init();
+
+    // Rule set management
+    bool loadRuleSet(const char *json, size_t len, bool persist);
+    void clearRules();
+    uint8_t ruleCount();
+
+    // Inputs — call whenever a value is produced (SmartNet, sensors, module code)
+    void updateValue(const char *signal, float value);
+
+    // MQTT entry point (<serialNumber>/rules)
+    void handleRulesMessage(const char *payload, size_t len);
+
+    void rulesTask(void *parameter);
+}
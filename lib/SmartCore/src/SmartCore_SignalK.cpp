@@ -0,0 +1,576 @@
+#include "SmartCore_SignalK.h"
+#include <ArduinoJson.h>
+#include <AsyncWebSocket.h>
+#include <WiFi.h>
+#include <time.h>
+#include "SmartCore_Network.h"
+#include "SmartCore_Time.h"
+#include "SmartCore_Log.h"
+#include "config.h"
+
+#ifdef SMARTBOX_BUILD
+
+namespace SmartCore_SignalK
+{
+    TaskHandle_t signalKTaskHandle = NULL;
+
+    static AsyncWebSocket ws(SIGNALK_STREAM_PATH);
+    static SemaphoreHandle_t skMutex = nullptr;
+    static bool started = false;
+
+    // ======================================================================================
+    //  PATH TABLE
+    // ======================================================================================
+    //
+    //  SmartNet field names → Signal K paths, converted to SI units on the way through
+    //  (SK wants Kelvin and 0..1 ratios). pitch and roll both land in the
+    //  navigation.attitude object, so they share one path slot.
+    //
+    // ======================================================================================
+
+    enum PathKind : uint8_t
+    {
+        PATH_NUMBER,
+        PATH_ATTITUDE_PITCH,
+        PATH_ATTITUDE_ROLL,
+    };
+
+    struct FieldMap
+    {
+        const char *field;
+        uint8_t path;
+        PathKind kind;
+        float scale;
+        float offset;
+    };
+
+    static const char *const paths[] = {
+        "environment.depth.belowTransducer",
+        "navigation.headingMagnetic",
+        "navigation.attitude",
+        "steering.rudderAngle",
+        "navigation.rateOfTurn",
+        "environment.heave",
+        "navigation.speedThroughWater",
+        "navigation.speedOverGround",
+        "environment.outside.temperature",
+        "environment.outside.pressure",
+        "environment.outside.relativeHumidity",
+    };
+
+    static constexpr uint8_t PATH_COUNT = sizeof(paths) / sizeof(paths[0]);
+    static constexpr uint8_t PATH_ATTITUDE = 2;
+
+    static const FieldMap fieldMap[] = {
+        {"depth", 0, PATH_NUMBER, 1.0f, 0.0f},
+        {"heading", 1, PATH_NUMBER, 1.0f, 0.0f},
+        {"pitch", PATH_ATTITUDE, PATH_ATTITUDE_PITCH, 1.0f, 0.0f},
+        {"roll", PATH_ATTITUDE, PATH_ATTITUDE_ROLL, 1.0f, 0.0f},
+        {"rudderAngle", 3, PATH_NUMBER, 1.0f, 0.0f},
+        {"rateOfTurn", 4, PATH_NUMBER, 1.0f, 0.0f},
+        {"heave", 5, PATH_NUMBER, 1.0f, 0.0f},
+        {"speedThroughWater", 6, PATH_NUMBER, 1.0f, 0.0f},
+        {"speedOverGround", 7, PATH_NUMBER, 1.0f, 0.0f},
+        {"temperature", 8, PATH_NUMBER, 1.0f, 273.15f}, // °C → K
+        {"pressure", 9, PATH_NUMBER, 1.0f, 0.0f},
+        {"humidity", 10, PATH_NUMBER, 0.01f, 0.0f}, // % → ratio
+    };
+
+    struct PathValue
+    {
+        float value;
+        float pitch;
+        float roll;
+        uint8_t src;
+        bool valid;
+    };
+
+    static PathValue values[PATH_COUNT];
+
+    // ======================================================================================
+    //  SUBSCRIPTIONS
+    // ======================================================================================
+    //
+    //  Per client, per path:
+    //      instant → every change, no faster than minPeriod
+    //      ideal   → like instant, plus a resend every period when nothing changed
+    //      fixed   → exactly every period
+    //
+    //  Client → module (SK subscription protocol):
+    //      { "context": "vessels.self",
+    //        "subscribe": [ { "path": "navigation.*", "period": 1000,
+    //                         "minPeriod": 200, "policy": "instant" } ] }
+    //      { "context": "*", "unsubscribe": [ { "path": "*" } ] }
+    //
+    //  On connect, ?subscribe=none starts with nothing; self/all (default) subscribes
+    //  every path with the instant policy.
+    //
+    // ======================================================================================
+
+    enum Policy : uint8_t
+    {
+        POLICY_NONE,
+        POLICY_INSTANT,
+        POLICY_IDEAL,
+        POLICY_FIXED,
+    };
+
+    struct PathSub
+    {
+        Policy policy;
+        uint16_t minPeriod;
+        uint32_t period;
+        uint32_t lastSent;
+    };
+
+    struct ClientSlot
+    {
+        uint32_t id;
+        bool used;
+        PathSub subs[PATH_COUNT];
+    };
+
+    static ClientSlot clients[SIGNALK_MAX_CLIENTS];
+    static char selfContext[64];
+
+    static ClientSlot *findClient(uint32_t id)
+    {
+        for (uint8_t i = 0; i < SIGNALK_MAX_CLIENTS; i++)
+        {
+            if (clients[i].used && clients[i].id == id)
+                return &clients[i];
+        }
+        return nullptr;
+    }
+
+    // "*" matches any run of characters, everything else is literal
+    static bool pathMatches(const char *pattern, const char *path)
+    {
+        while (*pattern)
+        {
+            if (*pattern == '*')
+            {
+                pattern++;
+                if (!*pattern)
+                    return true;
+                for (; *path; path++)
+                {
+                    if (pathMatches(pattern, path))
+                        return true;
+                }
+                return false;
+            }
+
+            if (*pattern++ != *path++)
+                return false;
+        }
+        return *path == '\0';
+    }
+
+    static bool contextMatches(const char *context)
+    {
+        return !*context || !strcmp(context, "*") || !strcmp(context, "vessels.*") ||
+               !strcmp(context, "vessels.self") || !strcmp(context, selfContext);
+    }
+
+    static void subscribeAll(ClientSlot &c, Policy policy)
+    {
+        for (uint8_t p = 0; p < PATH_COUNT; p++)
+        {
+            c.subs[p].policy = policy;
+            c.subs[p].period = 1000;
+            c.subs[p].minPeriod = 0;
+            c.subs[p].lastSent = 0;
+        }
+    }
+
+    static Policy parsePolicy(const char *policy, Policy fallback)
+    {
+        if (!strcmp(policy, "instant"))
+            return POLICY_INSTANT;
+        if (!strcmp(policy, "ideal"))
+            return POLICY_IDEAL;
+        if (!strcmp(policy, "fixed"))
+            return POLICY_FIXED;
+        return fallback;
+    }
+
+    static void handleClientMessage(uint32_t id, const char *data, size_t len)
+    {
+        StaticJsonDocument<1024> doc;
+        DeserializationError err = deserializeJson(doc, data, len);
+
+        if (err)
+        {
+            Serial.printf("❌ Failed to parse Signal K message: %s\n", err.c_str());
+            return;
+        }
+
+        if (!contextMatches(doc["context"] | ""))
+            return; // other vessels / AIS — nothing we publish
+
+        xSemaphoreTake(skMutex, portMAX_DELAY);
+
+        ClientSlot *c = findClient(id);
+        if (c)
+        {
+            for (JsonObjectConst s : doc["unsubscribe"].as<JsonArrayConst>())
+            {
+                const char *pattern = s["path"] | "*";
+                for (uint8_t p = 0; p < PATH_COUNT; p++)
+                {
+                    if (pathMatches(pattern, paths[p]))
+                        c->subs[p].policy = POLICY_NONE;
+                }
+            }
+
+            for (JsonObjectConst s : doc["subscribe"].as<JsonArrayConst>())
+            {
+                const char *pattern = s["path"] | "*";
+                uint32_t period = s["period"] | 1000;
+                uint16_t minPeriod = s["minPeriod"] | 0;
+
+                // SK default: "ideal" when only a period is given, "instant" with minPeriod
+                Policy fallback = s.containsKey("minPeriod") ? POLICY_INSTANT : POLICY_IDEAL;
+                Policy policy = parsePolicy(s["policy"] | "", fallback);
+
+                if (period < SIGNALK_TICK_MS)
+                    period = SIGNALK_TICK_MS;
+
+                for (uint8_t p = 0; p < PATH_COUNT; p++)
+                {
+                    if (!pathMatches(pattern, paths[p]))
+                        continue;
+
+                    c->subs[p].policy = policy;
+                    c->subs[p].period = period;
+                    c->subs[p].minPeriod = minPeriod;
+                    c->subs[p].lastSent = 0;
+                }
+            }
+        }
+
+        xSemaphoreGive(skMutex);
+    }
+
+    // ======================================================================================
+    //  DELTA FAN-OUT
+    // ======================================================================================
+    //
+    //  A delta for one path is serialized once into a shared WebSocket buffer and queued
+    //  on every client that is due for it — no per-client JSON, no per-client copies.
+    //  Clients whose send queue is already full are skipped for this update rather than
+    //  letting a slow chartplotter hold everyone else's memory.
+    //
+    //  Called with skMutex held.
+    //
+    // ======================================================================================
+
+    static void formatTimestamp(char *out, size_t len)
+    {
+        out[0] = '\0';
+        uint64_t ms = getSmartBoatTimeMs();
+        if (ms == 0)
+            return;
+
+        time_t secs = ms / 1000;
+        struct tm tmUtc;
+        gmtime_r(&secs, &tmUtc);
+
+        size_t n = strftime(out, len, "%Y-%m-%dT%H:%M:%S", &tmUtc);
+        snprintf(out + n, len - n, ".%03luZ", (unsigned long)(ms % 1000));
+    }
+
+    static void sendPath(uint8_t p, const bool *due)
+    {
+        const PathValue &pv = values[p];
+
+        StaticJsonDocument<384> doc;
+        doc["context"] = (const char *)selfContext;
+
+        JsonObject update = doc.createNestedArray("updates").createNestedObject();
+
+        char source[16];
+        snprintf(source, sizeof(source), "smartnet.%u", pv.src);
+        update["$source"] = (const char *)source;
+
+        char ts[32];
+        formatTimestamp(ts, sizeof(ts));
+        if (ts[0])
+            update["timestamp"] = (const char *)ts;
+
+        JsonObject v = update.createNestedArray("values").createNestedObject();
+        v["path"] = paths[p];
+
+        if (p == PATH_ATTITUDE)
+        {
+            JsonObject att = v.createNestedObject("value");
+            att["pitch"] = pv.pitch;
+            att["roll"] = pv.roll;
+        }
+        else
+        {
+            v["value"] = pv.value;
+        }
+
+        // Only some clients get this delta, so no shared makeBuffer() — it is released
+        // by textAll() alone. Each client->text() copies the message.
+        char msg[512];
+        if (measureJson(doc) >= sizeof(msg))
+            return;
+        size_t len = serializeJson(doc, msg, sizeof(msg));
+
+        uint32_t now = millis();
+        for (uint8_t i = 0; i < SIGNALK_MAX_CLIENTS; i++)
+        {
+            if (!due[i])
+                continue;
+
+            AsyncWebSocketClient *client = ws.client(clients[i].id);
+            if (!client || client->status() != WS_CONNECTED || client->queueIsFull())
+                continue;
+
+            client->text(msg, len);
+            clients[i].subs[p].lastSent = now;
+        }
+    }
+
+    // Value changed → instant / ideal subscribers past their minPeriod
+    static void pushChange(uint8_t p)
+    {
+        bool due[SIGNALK_MAX_CLIENTS] = {false};
+        bool any = false;
+        uint32_t now = millis();
+
+        for (uint8_t i = 0; i < SIGNALK_MAX_CLIENTS; i++)
+        {
+            const PathSub &s = clients[i].subs[p];
+            if (!clients[i].used || (s.policy != POLICY_INSTANT && s.policy != POLICY_IDEAL))
+                continue;
+
+            if (s.lastSent && now - s.lastSent < s.minPeriod)
+                continue;
+
+            due[i] = any = true;
+        }
+
+        if (any)
+            sendPath(p, due);
+    }
+
+    // Timer → fixed subscribers every period, ideal subscribers that went quiet
+    static void pushPeriodic()
+    {
+        uint32_t now = millis();
+
+        for (uint8_t p = 0; p < PATH_COUNT; p++)
+        {
+            if (!values[p].valid)
+                continue;
+
+            bool due[SIGNALK_MAX_CLIENTS] = {false};
+            bool any = false;
+
+            for (uint8_t i = 0; i < SIGNALK_MAX_CLIENTS; i++)
+            {
+                const PathSub &s = clients[i].subs[p];
+                if (!clients[i].used || (s.policy != POLICY_FIXED && s.policy != POLICY_IDEAL))
+                    continue;
+
+                if (now - s.lastSent < s.period)
+                    continue;
+
+                due[i] = any = true;
+            }
+
+            if (any)
+                sendPath(p, due);
+        }
+    }
+
+    void updateValue(const char *field, float value, uint8_t src)
+    {
+        if (!skMutex)
+            return;
+
+        const FieldMap *m = nullptr;
+        for (const FieldMap &f : fieldMap)
+        {
+            if (!strcmp(f.field, field))
+            {
+                m = &f;
+                break;
+            }
+        }
+
+        if (!m)
+            return;
+
+        xSemaphoreTake(skMutex, portMAX_DELAY);
+
+        PathValue &pv = values[m->path];
+        float converted = value * m->scale + m->offset;
+
+        if (m->kind == PATH_ATTITUDE_PITCH)
+            pv.pitch = converted;
+        else if (m->kind == PATH_ATTITUDE_ROLL)
+            pv.roll = converted;
+        else
+            pv.value = converted;
+
+        pv.src = src;
+        pv.valid = true;
+
+        if (ws.count() > 0)
+            pushChange(m->path);
+
+        xSemaphoreGive(skMutex);
+    }
+
+    uint8_t clientCount()
+    {
+        return ws.count();
+    }
+
+    // ======================================================================================
+    //  SERVER SIDE
+    // ======================================================================================
+
+    static void sendHello(AsyncWebSocketClient *client)
+    {
+        StaticJsonDocument<256> doc;
+        doc["name"] = "SmartCore";
+        doc["version"] = SIGNALK_VERSION;
+        doc["self"] = (const char *)selfContext;
+        doc.createNestedArray("roles").add("master");
+
+        char ts[32];
+        formatTimestamp(ts, sizeof(ts));
+        if (ts[0])
+            doc["timestamp"] = (const char *)ts;
+
+        char payload[256];
+        size_t len = serializeJson(doc, payload, sizeof(payload));
+        client->text(payload, len);
+    }
+
+    static void onEvent(AsyncWebSocket *server, AsyncWebSocketClient *client,
+                        AwsEventType type, void *arg, uint8_t *data, size_t len)
+    {
+        if (type == WS_EVT_CONNECT)
+        {
+            AsyncWebServerRequest *request = (AsyncWebServerRequest *)arg;
+            String mode = (request && request->hasParam("subscribe"))
+                              ? request->getParam("subscribe")->value()
+                              : String("self");
+
+            xSemaphoreTake(skMutex, portMAX_DELAY);
+
+            ClientSlot *slot = nullptr;
+            for (uint8_t i = 0; i < SIGNALK_MAX_CLIENTS && !slot; i++)
+            {
+                if (!clients[i].used)
+                    slot = &clients[i];
+            }
+
+            if (slot)
+            {
+                memset(slot, 0, sizeof(*slot));
+                slot->id = client->id();
+                slot->used = true;
+                subscribeAll(*slot, mode == "none" ? POLICY_NONE : POLICY_INSTANT);
+            }
+
+            xSemaphoreGive(skMutex);
+
+            if (!slot)
+            {
+                logMessage(LOG_WARN, "⚠️ Signal K: client limit reached — closing new connection");
+                client->close(1013);
+                return;
+            }
+
+            sendHello(client);
+            logMessage(LOG_INFO, "🧭 Signal K client connected (#" + String(client->id()) + ")");
+        }
+        else if (type == WS_EVT_DISCONNECT)
+        {
+            xSemaphoreTake(skMutex, portMAX_DELAY);
+            ClientSlot *slot = findClient(client->id());
+            if (slot)
+                slot->used = false;
+            xSemaphoreGive(skMutex);
+
+            logMessage(LOG_INFO, "👋 Signal K client disconnected (#" + String(client->id()) + ")");
+        }
+        else if (type == WS_EVT_DATA)
+        {
+            AwsFrameInfo *info = (AwsFrameInfo *)arg;
+
+            // Subscription messages are tiny — only single-frame text is accepted
+            if (info->final && info->index == 0 && info->len == len && info->opcode == WS_TEXT)
+                handleClientMessage(client->id(), (const char *)data, len);
+        }
+    }
+
+    static void handleDiscovery(AsyncWebServerRequest *request)
+    {
+        StaticJsonDocument<384> doc;
+        JsonObject v1 = doc.createNestedObject("endpoints").createNestedObject("v1");
+        v1["version"] = SIGNALK_VERSION;
+        v1["signalk-ws"] = "ws://" + WiFi.localIP().toString() + ":5000" SIGNALK_STREAM_PATH;
+
+        JsonObject srv = doc.createNestedObject("server");
+        srv["id"] = "smartcore";
+        srv["version"] = SIGNALK_VERSION;
+
+        String payload;
+        serializeJson(doc, payload);
+        request->send(200, "application/json", payload);
+    }
+
+    void begin(AsyncWebServer &server)
+    {
+        if (started)
+            return;
+
+        skMutex = xSemaphoreCreateMutex();
+        snprintf(selfContext, sizeof(selfContext), "vessels.urn:mrn:signalk:smartboat:%s", serialNumber);
+
+        ws.onEvent(onEvent);
+        server.addHandler(&ws);
+        server.on("/signalk", HTTP_GET, handleDiscovery);
+        server.begin();
+        started = true;
+
+        xTaskCreatePinnedToCore(signalKTask, "SignalK Task", 4096, NULL, 1, &signalKTaskHandle, 1);
+
+        logMessage(LOG_INFO, "🧭 Signal K delta stream on ws://" + WiFi.localIP().toString() +
+                                 ":5000" SIGNALK_STREAM_PATH);
+    }
+
+    void signalKTask(void *parameter)
+    {
+        uint32_t lastCleanup = millis();
+
+        for (;;)
+        {
+            vTaskDelay(pdMS_TO_TICKS(SIGNALK_TICK_MS));
+
+            if (ws.count() > 0)
+            {
+                xSemaphoreTake(skMutex, portMAX_DELAY);
+                pushPeriodic();
+                xSemaphoreGive(skMutex);
+            }
+
+            if (millis() - lastCleanup >= 1000)
+            {
+                ws.cleanupClients(SIGNALK_MAX_CLIENTS);
+                lastCleanup = millis();
+            }
+        }
+    }
+}
+
+#endif // SMARTBOX_BUILD
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <Arduino.h>
+#include <ESPAsyncWebServer.h>
+
+// Signal K delta stream limits (override externally if needed)
+#ifndef SIGNALK_MAX_CLIENTS
+#define SIGNALK_MAX_CLIENTS 4
+#endif
+
+#define SIGNALK_VERSION "1.7.0"
+#define SIGNALK_STREAM_PATH "/signalk/v1/stream"
+#define SIGNALK_TICK_MS 100 // resolution of fixed / ideal period sends
+
+namespace SmartCore_SignalK
+{
+    extern TaskHandle_t signalKTaskHandle;
+
+    // Attaches /signalk + the delta WebSocket to the module web server and starts it
+    void begin(AsyncWebServer &server);
+
+    // Decoded SmartNet field → Signal K delta (unknown fields are ignored)
+    void updateValue(const char *field, float value, uint8_t src);
+
+    uint8_t clientCount();
+
+    void signalKTask(void *parameter);
+}
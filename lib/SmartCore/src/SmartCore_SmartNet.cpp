@@ -9,6 +9,10 @@
 #include "config.h"
 #include "SmartCore_Log.h"
 #include "SmartCore_System.h"
+#include "SmartCore_Rules.h"
+#include "SmartCore_Alarms.h"
+#include "SmartCore_History.h"
+#include "SmartCore_SignalK.h"
 
 #ifdef SMARTBOX_BUILD
 
@@ -18,6 +22,7 @@ namespace SmartCore_SmartNet
 
     static uint8_t smartNetAddress = SMARTNET_ADDR_UNASSIGNED;
     TaskHandle_t smartNetTaskHandle = NULL;
+    static SmartNetStats stats = {}; // written by the SmartNet task only
 
     /*bool initSmartNet()
     {
@@ -354,6 +359,8 @@ namespace SmartCore_SmartNet
         if (twai_receive(&msg, pdMS_TO_TICKS(10)) != ESP_OK)
             return;
 
+        stats.frames++;
+
         uint32_t id = msg.identifier;
         uint8_t src = id & 0xFF;
         uint32_t pgn = extractPGN(id);
@@ -601,10 +608,105 @@ namespace SmartCore_SmartNet
         // --------------------------------------------------
         default:
             // Known unknowns get ignored cleanly
+            stats.unhandled++;
             break;
         }
     }
 
+    // ======================================================================================
+    //  PER-FIELD TOPICS
+    // ======================================================================================
+    //
+    //  Every decoded field goes to its own topic:
+    //
+    //      smartnet/<src>/<pgn>/<field>      e.g. smartnet/35/127250/heading
+    //      {"value":0.5236,"units":"rad","timestamp":123456}
+    //
+    //  so subscribers filter with wildcards (smartnet/+/127250/#) instead of parsing
+    //  every message, and one field no longer overwrites another's retained value.
+    //
+    //  The publish policy is a property of the PGN (pgnClasses, default TELEMETRY):
+    //      TELEMETRY  attitude, heading, speed…  QoS 0, no retain — no PUBACK per value
+    //      STATE      environment                QoS 1, retained, outboxed offline
+    //
+    //  Topic strings are built once per (src, pgn, field) and interned in an
+    //  open-addressed table keyed on the field pointer; a publish is then one hash
+    //  probe plus a short snprintf of the payload. Only the SmartNet task publishes,
+    //  so the table needs no lock. A full table falls back to building on the stack.
+    //
+    // ======================================================================================
+
+    struct PgnClass
+    {
+        uint32_t pgn;
+        SmartNetClass cls;
+    };
+
+    static const PgnClass pgnClasses[] = {
+        {130311, SMARTNET_STATE}, // Environmental — slow, last value matters
+    };
+
+    struct InternedTopic
+    {
+        const char *field; // nullptr = free slot
+        uint32_t pgn;
+        uint8_t src;
+        SmartNetClass cls;
+        char topic[SMARTNET_TOPIC_LEN];
+    };
+
+    static InternedTopic topicCache[SMARTNET_TOPIC_SLOTS];
+    static uint16_t topicCacheUsed = 0;
+
+    static SmartNetClass classOf(uint32_t pgn)
+    {
+        for (const PgnClass &c : pgnClasses)
+        {
+            if (c.pgn == pgn)
+                return c.cls;
+        }
+        return SMARTNET_TELEMETRY;
+    }
+
+    static void buildTopic(char *out, uint8_t src, uint32_t pgn, const char *field)
+    {
+        snprintf(out, SMARTNET_TOPIC_LEN, SMARTNET_TOPIC_ROOT "/%u/%lu/%s",
+                 (unsigned)src, (unsigned long)pgn, field);
+    }
+
+    // nullptr when the table is full
+    static const InternedTopic *internTopic(uint8_t src, uint32_t pgn, const char *field)
+    {
+        uint32_t h = (pgn * 2654435761UL) ^ ((uint32_t)(uintptr_t)field >> 2) ^ ((uint32_t)src << 24);
+        h ^= h >> 15;
+
+        for (uint16_t probe = 0; probe < SMARTNET_TOPIC_SLOTS; probe++)
+        {
+            InternedTopic &t = topicCache[(h + probe) & (SMARTNET_TOPIC_SLOTS - 1)];
+
+            if (t.field == field && t.pgn == pgn && t.src == src)
+                return &t;
+
+            if (t.field == nullptr)
+            {
+                if (topicCacheUsed >= SMARTNET_TOPIC_SLOTS * 3 / 4)
+                    return nullptr; // keep probes short
+
+                t.field = field;
+                t.pgn = pgn;
+                t.src = src;
+                t.cls = classOf(pgn);
+                buildTopic(t.topic, src, pgn, field);
+                topicCacheUsed++;
+
+                if (topicCacheUsed == SMARTNET_TOPIC_SLOTS * 3 / 4)
+                    logMessage(LOG_WARN, "⚠️ SmartNet topic cache full — new fields build topics per message");
+                return &t;
+            }
+        }
+        return nullptr;
+    }
+
     void publishField(
         uint32_t pgn,
         const char *pgnName,
@@ -613,6 +715,48 @@ namespace SmartCore_SmartNet
         float value,
         const char *units)
     {
+        // ⚙️ Local automations see the value before (and regardless of) MQTT
+        SmartCore_Rules::updateValue(field, value);
+        SmartCore_Alarms::updateValue(field, value);
+        SmartCore_History::record(field, value);
+        SmartCore_SignalK::updateValue(field, value, src);
+
+        stats.fields++;
+
+        char fallback[SMARTNET_TOPIC_LEN];
+        const char *topic;
+        SmartNetClass cls;
+
+        const InternedTopic *t = internTopic(src, pgn, field);
+        if (t)
+        {
+            topic = t->topic;
+            cls = t->cls;
+        }
+        else
+        {
+            buildTopic(fallback, src, pgn, field);
+            topic = fallback;
+            cls = classOf(pgn);
+        }
+
+        char payload[96];
+        size_t len = snprintf(payload, sizeof(payload), "{\"value\":%.6g,\"units\":\"%s\",\"timestamp\":%lu}",
+                              value, units, (unsigned long)millis()); // monotonic, safe
+
+        if (cls == SMARTNET_STATE)
+        {
+            // Offline → LittleFS outbox, replayed in order once MQTT is back
+            if (!SmartCore_MQTT::mqttStoreAndForward(OUTBOX_TELEMETRY, topic, 1, true, payload, len))
+                logMessage(LOG_WARN, String("❌ Outbox unavailable — dropping ") + topic);
+        }
+        else
+        {
+            // Superseded within a second — not worth a PUBACK or a flash write
+            SmartCore_MQTT::mqttSafePublish(topic, 0, false, payload, len, PUB_PRIO_TELEMETRY);
+        }
+
+#ifdef SMARTNET_LEGACY_TOPIC
         DynamicJsonDocument doc(256);
 
         doc["bus"] = "nmea2000";
@@ -622,22 +766,18 @@ namespace SmartCore_SmartNet
         doc["field"] = field;
         doc["value"] = value;
         doc["units"] = units;
-        doc["timestamp"] = millis(); // monotonic, safe
-
-        String payload;
-        serializeJson(doc, payload);
+        doc["timestamp"] = millis();
 
-        const char *topic = "smartnet/data";
+        String legacy;
+        serializeJson(doc, legacy);
+        SmartCore_MQTT::mqttSafePublish("smartnet/data", 0, false, legacy.c_str(), legacy.length(), PUB_PRIO_TELEMETRY);
+#endif
+    }
 
-        if (mqttClient && mqttClient->connected())
-        {
-            mqttClient->publish(topic, 1, true, payload.c_str());
-            logMessage(LOG_INFO, "📤 smartnet/data → " + payload);
-        }
-        else
-        {
-            logMessage(LOG_WARN, "❌ MQTT not connected — dropping smartnet/data");
-        }
+    void getStats(SmartNetStats &out)
+    {
+        out = stats;
+        out.topics = topicCacheUsed;
     }
 
 }
@@ -22,6 +22,30 @@
 
 #define SMARTBOAT_MANUFACTURER_ID 2025
 
+// Per-field MQTT topics "smartnet/<src>/<pgn>/<field>" (override externally if needed)
+#ifndef SMARTNET_TOPIC_SLOTS
+#define SMARTNET_TOPIC_SLOTS 64 // interned (src, pgn, field) topics; power of two
+#endif
+#define SMARTNET_TOPIC_LEN 48
+#define SMARTNET_TOPIC_ROOT "smartnet"
+// Build with -DSMARTNET_LEGACY_TOPIC to also publish every field to smartnet/data
+// (the former single retained topic) for consumers that still read it
+
+// Publish policy, chosen per PGN
+enum SmartNetClass : uint8_t
+{
+    SMARTNET_TELEMETRY = 0, // high-rate: QoS 0, not retained, dropped while offline
+    SMARTNET_STATE,         // state-like: QoS 1, retained, kept in the outbox while offline
+};
+
+struct SmartNetStats
+{
+    uint32_t frames;    // CAN frames received
+    uint32_t fields;    // decoded values published
+    uint32_t unhandled; // frames of PGNs we do not decode
+    uint16_t topics;    // interned per-field topics
+};
+
 namespace SmartCore_SmartNet
 {
 
@@ -66,6 +90,8 @@ namespace SmartCore_SmartNet
     void sniffBus();
     void smartNetTask(void *pvParameters);
     void dispatchPGN(uint32_t pgn, uint8_t src, const uint8_t *data, uint8_t len);
+    // field must be a string literal (or otherwise static) — the topic cache keys
+    // on the pointer
     void publishField(
         uint32_t pgn,
         const char *pgnName,
@@ -73,6 +99,7 @@ namespace SmartCore_SmartNet
         const char *field,
         float value,
         const char *units);
+    void getStats(SmartNetStats &out);
 
     // PGN Switch
     void decodeEnvironmental(uint8_t src, const uint8_t *data, uint8_t len);
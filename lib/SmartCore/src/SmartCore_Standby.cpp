@@ -0,0 +1,223 @@
+#include "SmartCore_Standby.h"
+#include <WiFi.h>
+#include "SmartCore_MQTT.h"
+#include "SmartCore_MQTTConn.h"
+#include "SmartCore_BrokerHealth.h"
+#include "SmartCore_Publisher.h"
+#include "SmartCore_Network.h"
+#include "SmartCore_Log.h"
+#include "SmartCore_Hash.h"
+
+#ifdef MQTT_HOT_STANDBY
+
+namespace SmartCore_Standby
+{
+    TaskHandle_t standbyTaskHandle = NULL;
+
+    // ======================================================================================
+    //  HOT STANDBY
+    // ======================================================================================
+    //
+    //  While the active connection is up, a second AsyncMqttClient keeps an idle,
+    //  subscribe-only session to the next broker in rank order (never the active one):
+    //
+    //      active  ──► broker A   (publishes, subscriptions, will)
+    //      standby ──► broker B   (subscriptions only, no will)
+    //
+    //  When the active client drops, onMqttDisconnect() calls promote(): the two client
+    //  pointers swap and mqttClient is connected again before anything else notices —
+    //  no TCP handshake, no CONNECT, no re-subscribe. The old active object becomes the
+    //  spare and this task re-establishes a standby when it can.
+    //
+    //  • Both clients' callbacks are role-aware (they compare against mqttClient), so a
+    //    swap needs no re-registration.
+    //  • The standby only forwards single-segment messages; while both sessions are up,
+    //    every inbound message passes isDuplicate() (topic + payload hash seen on the
+    //    other connection within STANDBY_DEDUP_WINDOW_MS) so bridged brokers don't
+    //    deliver twice — a command repeated on one connection still gets through.
+    //  • A promoted client has no will; the next regular reconnect restores it.
+    //
+    // ======================================================================================
+
+    static AsyncMqttClient *standby = nullptr;
+    static volatile bool standbyConnected = false;
+    static bool standbyConnecting = false;
+    static int8_t standbyIndex = -1;
+    static uint32_t attemptMs = 0;
+    static uint32_t lastAttemptMs = 0;
+    static volatile int8_t pendingIndex = -1; // target of the attempt in flight
+
+    static char standbyId[16];
+    static char standbyHost[40];
+
+    struct SeenMessage
+    {
+        uint32_t hash;
+        uint32_t ms;
+        const AsyncMqttClient *source;
+    };
+
+    static SeenMessage seen[STANDBY_DEDUP_SLOTS];
+    static uint8_t seenNext = 0;
+
+    void init(AsyncMqttClient *spare)
+    {
+        if (standbyTaskHandle)
+            return;
+
+        standby = spare;
+
+        uint8_t mac[6];
+        WiFi.macAddress(mac);
+        snprintf(standbyId, sizeof(standbyId), "%02X%02X%02X%02X%02X%02X-s",
+                 mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
+
+        xTaskCreatePinnedToCore(standbyTask, "MQTT Standby", 3072, NULL, 1, &standbyTaskHandle, 0);
+        logMessage(LOG_INFO, "🪢 MQTT hot standby enabled");
+    }
+
+    void onConnect(AsyncMqttClient *client, bool sessionPresent)
+    {
+        if (client != standby)
+            return;
+
+        standbyIndex = pendingIndex;
+        standbyConnecting = false;
+
+        SmartCore_MQTT::subscribeModuleTopics(client);
+
+        standbyConnected = true;
+        Serial.printf("🪢 Standby connected → %s\n", standbyHost);
+    }
+
+    void onDisconnect(AsyncMqttClient *client, AsyncMqttClientDisconnectReason reason)
+    {
+        if (client != standby)
+            return;
+
+        if (standbyConnected)
+            Serial.printf("🪢 Standby lost (%s)\n", SmartCore_MQTT::mqttDisconnectReasonToStr(reason));
+
+        standbyConnected = false;
+        standbyConnecting = false;
+        standbyIndex = -1;
+    }
+
+    bool live()
+    {
+        return standbyConnected && mqttIsConnected;
+    }
+
+    bool promote()
+    {
+        if (!standbyConnected || !standby || standbyIndex < 0)
+            return false;
+
+        int8_t idx = standbyIndex;
+
+        SmartCore_Publisher::lockClient();
+        AsyncMqttClient *old = mqttClient;
+        mqttClient = standby;
+        standby = old;
+        standbyConnected = false;
+        standbyConnecting = false;
+        standbyIndex = -1;
+        SmartCore_Publisher::unlockClient();
+
+        SmartCore_MQTT::currentBrokerIP = mqttPriorityList[idx];
+        SmartCore_MQTT::currentBrokerPort = mqtt_port;
+        SmartCore_MQTTConn::adopted(idx);
+
+        lastAttemptMs = millis(); // give the dead broker a moment before re-using the spare
+
+        logMessage(LOG_WARN, "⚡ Standby promoted → " + SmartCore_MQTT::currentBrokerIP +
+                                 " (priority " + String(idx) + ")");
+        return true;
+    }
+
+    static uint32_t hashMessage(const char *topic, const char *payload, size_t len)
+    {
+        return SmartCore_Hash::fnv1aBytes(payload, len, SmartCore_Hash::fnv1a(topic));
+    }
+
+    bool isDuplicate(const AsyncMqttClient *source, const char *topic, const char *payload, size_t len)
+    {
+        uint32_t h = hashMessage(topic, payload, len);
+        uint32_t now = millis();
+
+        for (uint8_t i = 0; i < STANDBY_DEDUP_SLOTS; i++)
+        {
+            if (seen[i].hash == h && seen[i].ms && seen[i].source != source &&
+                now - seen[i].ms < STANDBY_DEDUP_WINDOW_MS)
+            {
+                seen[i].ms = 0; // one suppressed copy per delivery
+                return true;
+            }
+        }
+
+        seen[seenNext] = {h, now ? now : 1, source};
+        seenNext = (seenNext + 1) % STANDBY_DEDUP_SLOTS;
+        return false;
+    }
+
+    // Next broker in rank order that is not the active one
+    static int8_t pickTarget()
+    {
+        uint8_t order[BROKER_PROBE_MAX];
+        uint8_t n = SmartCore_BrokerHealth::rank(order);
+        int8_t active = SmartCore_BrokerHealth::indexOf(SmartCore_MQTT::currentBrokerIP);
+
+        for (uint8_t k = 0; k < n; k++)
+        {
+            uint8_t i = order[k];
+            if ((int8_t)i != active && mqttPriorityList[i][0] != '\0' &&
+                strcmp(mqttPriorityList[i], "0.0.0.0") != 0)
+                return i;
+        }
+        return -1;
+    }
+
+    void standbyTask(void *parameter)
+    {
+        for (;;)
+        {
+            vTaskDelay(pdMS_TO_TICKS(STANDBY_TICK_MS));
+
+            uint32_t now = millis();
+            int8_t target = mqttIsConnected ? pickTarget() : -1;
+
+            SmartCore_Publisher::lockClient();
+
+            if (standbyConnected && standbyIndex != target && mqttIsConnected)
+            {
+                // Ranking changed or the active client moved onto our broker
+                standby->disconnect(true);
+            }
+            else if (standbyConnecting && now - attemptMs > MQTT_CONNECT_TIMEOUT_MS)
+            {
+                standbyConnecting = false;
+                standby->disconnect(true);
+            }
+            else if (!standbyConnected && !standbyConnecting && target >= 0 &&
+                     WiFi.status() == WL_CONNECTED && now - lastAttemptMs >= STANDBY_RETRY_MS)
+            {
+                lastAttemptMs = now;
+                attemptMs = now;
+                pendingIndex = target;
+                standbyConnecting = true;
+
+                strlcpy(standbyHost, mqttPriorityList[target], sizeof(standbyHost));
+                standby->setClientId(standbyId);
+                standby->setWill(nullptr, 0, false, nullptr, 0);
+                standby->setKeepAlive(MQTT_KEEPALIVE_S);
+                standby->setCleanSession(true); // may be the former active object
+                standby->setServer(standbyHost, mqtt_port);
+                standby->connect();
+            }
+
+            SmartCore_Publisher::unlockClient();
+        }
+    }
+}
+
+#endif
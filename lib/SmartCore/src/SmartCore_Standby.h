@@ -0,0 +1,36 @@
+#pragma once
+
+#include <Arduino.h>
+#include <AsyncMqttClient.h>
+
+// Hot standby (build with -DMQTT_HOT_STANDBY): a second, subscribe-only connection to
+// the next broker, promoted in place when the active one drops
+#define STANDBY_TICK_MS 1000
+#define STANDBY_RETRY_MS 10000     // between standby connect attempts
+#define STANDBY_DEDUP_SLOTS 16
+#define STANDBY_DEDUP_WINDOW_MS 1000
+
+namespace SmartCore_Standby
+{
+    extern TaskHandle_t standbyTaskHandle;
+
+    // Hands over the spare client object (called once by setupMQTTClient)
+    void init(AsyncMqttClient *spare);
+
+    // Callbacks of whichever client currently is the standby
+    void onConnect(AsyncMqttClient *client, bool sessionPresent);
+    void onDisconnect(AsyncMqttClient *client, AsyncMqttClientDisconnectReason reason);
+
+    // Active connection lost: swap the standby in. True = mqttClient now points at a
+    // connected client and nothing else needs to happen.
+    bool promote();
+
+    // Both connections up (duplicate suppression active)
+    bool live();
+
+    // True if the same topic + payload already arrived via the *other* connection within
+    // the window; a repeat on the same connection is a new message
+    bool isDuplicate(const AsyncMqttClient *source, const char *topic, const char *payload, size_t len);
+
+    void standbyTask(void *parameter);
+}
@@ -18,6 +18,10 @@
 #include "SmartCore_SmartNet.h"
 #include "SmartCore_OTA.h"
 #include "SmartCore_MCP.h"
+#include "SmartCore_Rules.h"
+#include "SmartCore_Alarms.h"
+#include "SmartCore_History.h"
+#include "SmartCore_Outbox.h"
 #include "SmartCore_OTA.h"
 #include "config.h"
 #include "module_reset.h"
@@ -207,6 +211,17 @@ namespace SmartCore_System
         logMessage(LOG_WARN,
             "⚠️ SAFE MODE — module tasks skipped, network allowed");
     }
+    else
+    {
+        // ─────────────────────────────────────────────
+        // Local rules + alarm engines, telemetry history,
+        // store-and-forward outbox (all on LittleFS)
+        // ─────────────────────────────────────────────
+        SmartCore_Outbox::init();
+        SmartCore_Rules::init();
+        SmartCore_Alarms::init();
+        SmartCore_History::init();
+    }
 
     // ─────────────────────────────────────────────
     // WiFi + MQTT are ALWAYS allowed
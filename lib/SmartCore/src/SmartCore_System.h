@@ -26,7 +26,8 @@ enum CrashCounterType
 enum ModuleErrorCode {
     ERR_BOOT_CRASH_LIMIT   = 1001,
     ERR_LITTLEFS_MOUNT     = 1002,
-    ERR_SAFE_BOOT_ACTIVE   = 1003
+    ERR_SAFE_BOOT_ACTIVE   = 1003,
+    ERR_ALARM_BASE         = 2000   // edge alarms default to 2000 + index
 };
 
 
@@ -1,13 +1,299 @@
 #include "SmartCore_Time.h"
-#include "SmartCore_Network.h"  // for smartBoatEnabled, smartBoatEpoch, smartBoatEpochSyncMillis
-
-uint32_t getCurrentSmartBoatTime() {
-    if (smartBoatEpoch > 0) {
-        uint32_t deltaMs = millis() - smartBoatEpochSyncMillis;
-        Serial.printf("[DEBUG] SmartBoatTime = %lu + (%lu - %lu)/1000 = %lu\n",
-                      smartBoatEpoch, millis(), smartBoatEpochSyncMillis,
-                      smartBoatEpoch + deltaMs / 1000);
-        return smartBoatEpoch + (deltaMs / 1000);
-    }
-    return millis() / 1000;
-}
\ No newline at end of file
+#include <esp_timer.h>
+#include "SmartCore_Network.h" // for smartBoatEpoch, smartBoatEpochSyncMillis, awaitingSmartboatTimeSync
+#include "SmartCore_Log.h"
+
+// ======================================================================================
+//  SMARTBOAT TIME
+// ======================================================================================
+//
+//  Exchange (NTP-style, over module/update → "<serial>/update"):
+//
+//      module   t1 = local µs   → {"action":"gettime","t1":t1}
+//      SmartBoat  t2 = receive, t3 = transmit (epoch ms, fractions allowed)
+//               ← {"update":"time","t1":t1,"t2":t2,"t3":t3}
+//      module   t4 = local µs on arrival
+//
+//  The t1 in the payload only tags the request: the publish task reports when it
+//  actually went out (onRequestSent), and t4 is stamped in onMqttMessage — so
+//  neither the publish queue nor the worker queue ends up inside the offset.
+//
+//      rtt    = (t4 − t1) − (t3 − t2)
+//      offset = ((t2 − t1) + (t3 − t4)) / 2       epoch = local + offset
+//
+//  A round sends TIMESYNC_BURST requests; only the lowest-RTT reply is used (queueing
+//  delay is what makes a path asymmetric, and the fastest exchange has the least).
+//
+//  Clock model (local = esp_timer µs, monotonic):
+//
+//      epoch(t) = base + (t − t0)·(1 + drift) + slew·min(1, (t − t0) / slewTime)
+//
+//  On every sample, err = measured − epoch(t4):
+//      |err| > TIMESYNC_STEP_MS or first sync → step: base = measured, drift kept
+//      otherwise → re-anchor at epoch(t4) and slew err in at TIMESYNC_SLEW_PPM, so
+//                  the clock never jumps; err (minus any slew still pending) over the
+//                  time since the last sample nudges the drift estimate.
+//
+//  A SmartBoat that only answers {"epoch": s} still works: the first reply (or one
+//  more than a second off) sets the clock to the middle of that second.
+//
+//  smartBoatEpoch / smartBoatEpochSyncMillis are kept in step for older code.
+//
+// ======================================================================================
+
+struct ClockModel
+{
+    bool valid;
+    int64_t t0;     // local µs of the anchor
+    int64_t base;   // epoch µs at t0
+    double drift;   // fractional rate correction
+    int64_t slew;   // µs still being slewed in from t0
+    int64_t slewUs; // over this long
+};
+
+struct TimeSample
+{
+    int64_t local; // t4
+    int64_t epoch; // t4 + offset
+    int64_t rtt;
+};
+
+static ClockModel model = {};
+static portMUX_TYPE timeMux = portMUX_INITIALIZER_UNLOCKED;
+
+struct PendingRequest
+{
+    int64_t tag;    // t1 as sent in the payload
+    int64_t sentUs; // when it actually went out (0 = still queued)
+};
+
+static PendingRequest pending[TIMESYNC_BURST]; // requests awaiting a reply
+static uint8_t pendingNext = 0;
+static TimeSample best;
+static bool haveBest = false;
+
+static int64_t lastSampleLocal = 0;
+static TimeSyncStats stats = {};
+
+// Caller holds timeMux (or owns a copy)
+static int64_t modelAt(const ClockModel &m, int64_t local)
+{
+    int64_t dt = local - m.t0;
+    int64_t v = m.base + dt + (int64_t)(dt * m.drift);
+
+    if (m.slewUs <= 0 || dt >= m.slewUs)
+        v += m.slew;
+    else if (dt > 0)
+        v += m.slew * dt / m.slewUs;
+
+    return v;
+}
+
+static int64_t slewPending(const ClockModel &m, int64_t local)
+{
+    int64_t dt = local - m.t0;
+    if (m.slewUs <= 0 || dt >= m.slewUs)
+        return 0;
+    return dt > 0 ? m.slew - m.slew * dt / m.slewUs : m.slew;
+}
+
+uint64_t getSmartBoatTimeUs()
+{
+    ClockModel m;
+    portENTER_CRITICAL(&timeMux);
+    m = model;
+    portEXIT_CRITICAL(&timeMux);
+
+    return m.valid ? (uint64_t)modelAt(m, esp_timer_get_time()) : 0;
+}
+
+uint64_t getSmartBoatTimeMs()
+{
+    return getSmartBoatTimeUs() / 1000;
+}
+
+bool smartBoatTimeValid()
+{
+    return model.valid;
+}
+
+uint32_t getCurrentSmartBoatTime()
+{
+    uint64_t ms = getSmartBoatTimeMs();
+    return ms ? (uint32_t)(ms / 1000) : millis() / 1000;
+}
+
+namespace SmartCore_Time
+{
+    static void publishLegacy(int64_t epochUs)
+    {
+        uint32_t ms = (uint32_t)((epochUs / 1000) % 1000);
+        smartBoatEpochSyncMillis = millis() - ms;
+        smartBoatEpoch = (uint32_t)(epochUs / 1000000);
+        awaitingSmartboatTimeSync = false;
+    }
+
+    // Sample measured at local time s.local; runs on the time sync or MQTT worker task
+    static void apply(const TimeSample &s, bool precise)
+    {
+        bool stepped;
+        int64_t err;
+        double drift;
+
+        portENTER_CRITICAL(&timeMux);
+        err = model.valid ? s.epoch - modelAt(model, s.local) : 0;
+        stepped = !model.valid || llabs(err) > (int64_t)TIMESYNC_STEP_MS * 1000;
+
+        if (stepped)
+        {
+            model.t0 = s.local;
+            model.base = s.epoch;
+            model.slew = 0;
+            model.slewUs = 0;
+            model.valid = true;
+        }
+        else
+        {
+            int64_t since = s.local - lastSampleLocal;
+            if (precise && lastSampleLocal && since > 10000000LL)
+            {
+                int64_t rateErr = err - slewPending(model, s.local);
+                double limit = TIMESYNC_MAX_DRIFT_PPM / 1e6;
+                model.drift = constrain(model.drift + TIMESYNC_DRIFT_GAIN * (double)rateErr / since, -limit, limit);
+            }
+
+            model.base = modelAt(model, s.local);
+            model.t0 = s.local;
+            model.slew = err;
+            model.slewUs = llabs(err) * 1000000LL / TIMESYNC_SLEW_PPM;
+        }
+        drift = model.drift;
+        portEXIT_CRITICAL(&timeMux);
+
+        lastSampleLocal = s.local;
+        publishLegacy(s.epoch);
+
+        stats.lastRttUs = (uint32_t)s.rtt;
+        stats.lastErrorUs = (int32_t)constrain(err, (int64_t)INT32_MIN, (int64_t)INT32_MAX);
+        stats.driftPpm = drift * 1e6;
+        stats.precise = precise;
+        stats.valid = true;
+        if (stepped)
+            stats.steps++;
+
+        if (stepped)
+            logMessage(LOG_INFO, "🕒 SmartBoat time set (rtt " + String((uint32_t)(s.rtt / 1000)) + " ms" +
+                                     (precise ? "" : ", epoch only") + ")");
+        else
+            Serial.printf("🕒 SmartBoat time slewing %ld µs (rtt %lu µs, drift %.2f ppm)\n",
+                          (long)stats.lastErrorUs, (unsigned long)stats.lastRttUs, stats.driftPpm);
+    }
+
+    int64_t beginExchange()
+    {
+        int64_t t1 = esp_timer_get_time();
+
+        portENTER_CRITICAL(&timeMux);
+        pending[pendingNext] = {t1, 0};
+        pendingNext = (pendingNext + 1) % TIMESYNC_BURST;
+        portEXIT_CRITICAL(&timeMux);
+
+        return t1;
+    }
+
+    void onRequestSent(int64_t t1, int64_t sentUs)
+    {
+        portENTER_CRITICAL(&timeMux);
+        for (uint8_t i = 0; i < TIMESYNC_BURST; i++)
+        {
+            if (t1 && pending[i].tag == t1)
+            {
+                pending[i].sentUs = sentUs;
+                break;
+            }
+        }
+        portEXIT_CRITICAL(&timeMux);
+    }
+
+    bool onReply(int64_t tag, int64_t t2, int64_t t3, int64_t t4)
+    {
+        int64_t t1 = 0;
+
+        portENTER_CRITICAL(&timeMux);
+        for (uint8_t i = 0; i < TIMESYNC_BURST; i++)
+        {
+            if (tag && pending[i].tag == tag)
+            {
+                t1 = pending[i].sentUs;
+                pending[i] = {0, 0};
+                break;
+            }
+        }
+        portEXIT_CRITICAL(&timeMux);
+
+        bool matched = t1 != 0; // a reply to a request never sent is bogus
+
+        int64_t rtt = (t4 - t1) - (t3 - t2);
+        if (!matched || rtt < 0 || rtt > (int64_t)TIMESYNC_MAX_RTT_MS * 1000)
+        {
+            stats.rejected++;
+            return false;
+        }
+
+        TimeSample s = {t4, t4 + ((t2 - t1) + (t3 - t4)) / 2, rtt};
+
+        portENTER_CRITICAL(&timeMux);
+        if (!haveBest || rtt < best.rtt)
+        {
+            best = s;
+            haveBest = true;
+        }
+        portEXIT_CRITICAL(&timeMux);
+
+        stats.exchanges++;
+        return true;
+    }
+
+    void onLegacyEpoch(uint32_t epoch)
+    {
+        int64_t now = esp_timer_get_time();
+        int64_t measured = (int64_t)epoch * 1000000LL + 500000LL; // somewhere in that second
+
+        ClockModel m;
+        portENTER_CRITICAL(&timeMux);
+        m = model;
+        portEXIT_CRITICAL(&timeMux);
+
+        // A precise clock is not overruled by a whole-second reading unless it is clearly off
+        if (m.valid && llabs(measured - modelAt(m, now)) <= 1500000LL)
+            return;
+
+        TimeSample s = {now, measured, 0};
+        apply(s, false);
+    }
+
+    bool endRound()
+    {
+        TimeSample s;
+        bool have;
+
+        portENTER_CRITICAL(&timeMux);
+        have = haveBest;
+        s = best;
+        haveBest = false;
+        for (uint8_t i = 0; i < TIMESYNC_BURST; i++)
+            pending[i] = {0, 0}; // late replies are rejected
+        portEXIT_CRITICAL(&timeMux);
+
+        stats.rounds++;
+        if (have)
+            apply(s, true);
+        return have;
+    }
+
+    void getStats(TimeSyncStats &out)
+    {
+        out = stats;
+        out.ageMs = lastSampleLocal ? (uint32_t)((esp_timer_get_time() - lastSampleLocal) / 1000) : 0;
+    }
+}
@@ -2,4 +2,61 @@
 
 #include <Arduino.h>
 
-uint32_t getCurrentSmartBoatTime();
\ No newline at end of file
+// SmartBoat time sync (override externally if needed)
+#ifndef TIMESYNC_INTERVAL_MS
+#define TIMESYNC_INTERVAL_MS 600000 // between sync rounds once locked
+#endif
+#define TIMESYNC_RETRY_MS 30000       // ...until the first good sync
+#define TIMESYNC_BURST 4              // exchanges per round; the fastest one counts
+#define TIMESYNC_BURST_SPACING_MS 250
+#define TIMESYNC_ROUND_WAIT_MS 2000   // replies arriving later are ignored
+#define TIMESYNC_MAX_RTT_MS 1000
+#define TIMESYNC_STEP_MS 500          // larger errors step the clock instead of slewing
+#define TIMESYNC_SLEW_PPM 500         // slew rate: 0.5 ms per second
+#define TIMESYNC_MAX_DRIFT_PPM 200
+#define TIMESYNC_DRIFT_GAIN 0.5f
+
+struct TimeSyncStats
+{
+    uint32_t rounds;
+    uint32_t exchanges;  // replies matched to a request
+    uint32_t rejected;   // unmatched, RTT out of range, or too late
+    uint32_t steps;      // clock set instead of slewed
+    uint32_t lastRttUs;  // of the sample applied last
+    int32_t lastErrorUs; // measured − our clock, before the correction
+    float driftPpm;      // estimated crystal drift (+ = local clock slow)
+    uint32_t ageMs;      // since the last applied sample
+    bool precise;        // last sample from a t1..t4 exchange (false = legacy epoch)
+    bool valid;
+};
+
+// Seconds since the Unix epoch; millis()/1000 until SmartBoat time is known
+uint32_t getCurrentSmartBoatTime();
+
+// SmartBoat time, drift-corrected and slewed (only steps when off by more than
+// TIMESYNC_STEP_MS); 0 until the first sync
+uint64_t getSmartBoatTimeMs();
+uint64_t getSmartBoatTimeUs();
+bool smartBoatTimeValid();
+
+namespace SmartCore_Time
+{
+    // Tag of a new request (local µs); remembered so the reply can be matched
+    int64_t beginExchange();
+
+    // Publisher hook: the request tagged t1 went out at sentUs — the real t1
+    void onRequestSent(int64_t t1, int64_t sentUs);
+
+    // NTP-style reply: t1 echoed, t2/t3 = SmartBoat receive / transmit time (epoch µs),
+    // t4 = local µs the reply came off the network (SmartCore_MQTT::messageArrivalUs).
+    // Keeps the best sample of the round; false if it does not match or is unusable.
+    bool onReply(int64_t t1, int64_t t2, int64_t t3, int64_t t4);
+
+    // SmartBoat without t2/t3 — {"epoch": seconds} only
+    void onLegacyEpoch(uint32_t epoch);
+
+    // Applies the lowest-RTT sample of the round; false if none arrived
+    bool endRound();
+
+    void getStats(TimeSyncStats &out);
+}
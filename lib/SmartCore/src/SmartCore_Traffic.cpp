@@ -0,0 +1,201 @@
+#include "SmartCore_Traffic.h"
+#include <ArduinoJson.h>
+#include "SmartCore_Network.h"
+#include "SmartCore_RPC.h"
+#include "SmartCore_Log.h"
+#include "SmartCore_Hash.h"
+
+namespace SmartCore_Traffic
+{
+    // ======================================================================================
+    //  TRAFFIC ACCOUNTING
+    // ======================================================================================
+    //
+    //  Every message in and out is charged to its topic prefix — the first
+    //  TRAFFIC_PREFIX_LEVELS levels:
+    //
+    //      smartnet/35/127250/heading   → smartnet/35/127250   (one row per source + PGN)
+    //      module/config/update         → module/config/update
+    //      <serial>/config              → <serial>/config
+    //
+    //  Counted where the bytes actually move:
+    //      in   onMqttMessage (first piece, full size); drops = reassembly / worker queue
+    //      out  publish task after mqttClient->publish(); drops = no slot, too large,
+    //           telemetry shed, offline with nowhere to store
+    //
+    //  The table is fixed (TRAFFIC_SLOTS); once full, new prefixes are charged to the
+    //  last row, "#other". Counters run from boot (or the last reset) and wrap at 2³².
+    //
+    //  Dump on demand: {"action":"dump"} on "<serial>/traffic" publishes the whole
+    //  table to module/traffic in pages of TRAFFIC_DUMP_PAGE rows:
+    //      {"page":0,"pages":3,"uptime":s,"rows":[[prefix, inMsgs, inBytes, inDrops,
+    //                                               outMsgs, outBytes, outDrops], ...]}
+    //
+    // ======================================================================================
+
+    struct Slot
+    {
+        uint32_t hash;
+        TrafficEntry e;
+    };
+
+    static Slot table[TRAFFIC_SLOTS];
+    static uint8_t used = 0;
+    static portMUX_TYPE trafficMux = portMUX_INITIALIZER_UNLOCKED;
+
+    static TrafficEntry dumpScratch[TRAFFIC_SLOTS]; // MQTT worker only
+
+    // Prefix of topic into out; returns its FNV-1a hash
+    static uint32_t prefixOf(const char *topic, char *out)
+    {
+        uint32_t h = SmartCore_Hash::FNV1A_SEED;
+        uint8_t levels = 0;
+        size_t n = 0;
+
+        for (const char *p = topic; *p && n < TRAFFIC_PREFIX_LEN - 1; p++)
+        {
+            if (*p == '/' && ++levels >= TRAFFIC_PREFIX_LEVELS)
+                break;
+
+            out[n++] = *p;
+            h = SmartCore_Hash::fnv1aStep(h, (uint8_t)*p);
+        }
+
+        out[n] = '\0';
+        return h;
+    }
+
+    // Caller holds trafficMux
+    static TrafficEntry &entryFor(const char *prefix, uint32_t hash)
+    {
+        for (uint8_t i = 0; i < used; i++)
+        {
+            if (table[i].hash == hash && !strcmp(table[i].e.prefix, prefix))
+                return table[i].e;
+        }
+
+        if (used < TRAFFIC_SLOTS - 1)
+        {
+            Slot &s = table[used++];
+            memset(&s, 0, sizeof(s));
+            s.hash = hash;
+            strlcpy(s.e.prefix, prefix, sizeof(s.e.prefix));
+            return s.e;
+        }
+
+        Slot &other = table[TRAFFIC_SLOTS - 1];
+        if (used < TRAFFIC_SLOTS)
+        {
+            memset(&other, 0, sizeof(other));
+            strlcpy(other.e.prefix, "#other", sizeof(other.e.prefix));
+            used = TRAFFIC_SLOTS;
+        }
+        return other.e;
+    }
+
+    void count(const char *topic, TrafficDir dir, size_t bytes)
+    {
+        char prefix[TRAFFIC_PREFIX_LEN];
+        uint32_t hash = prefixOf(topic, prefix);
+
+        portENTER_CRITICAL(&trafficMux);
+        TrafficEntry &e = entryFor(prefix, hash);
+        e.messages[dir]++;
+        e.bytes[dir] += bytes;
+        portEXIT_CRITICAL(&trafficMux);
+    }
+
+    void dropped(const char *topic, TrafficDir dir)
+    {
+        char prefix[TRAFFIC_PREFIX_LEN];
+        uint32_t hash = prefixOf(topic, prefix);
+
+        portENTER_CRITICAL(&trafficMux);
+        entryFor(prefix, hash).drops[dir]++;
+        portEXIT_CRITICAL(&trafficMux);
+    }
+
+    uint8_t snapshot(TrafficEntry *out, uint8_t max)
+    {
+        portENTER_CRITICAL(&trafficMux);
+        uint8_t n = min<uint8_t>(used, max);
+        for (uint8_t i = 0; i < n; i++)
+            out[i] = table[i].e;
+        portEXIT_CRITICAL(&trafficMux);
+
+        return n;
+    }
+
+    void reset()
+    {
+        portENTER_CRITICAL(&trafficMux);
+        used = 0;
+        portEXIT_CRITICAL(&trafficMux);
+    }
+
+    // One reply per page, each carrying the reqId. The request is marked deferred, so
+    // the RPC cache keeps none of them: a retried dump is answered with a fresh, complete
+    // set of pages instead of a replayed page 0.
+    static void publishDump()
+    {
+        uint8_t n = snapshot(dumpScratch, TRAFFIC_SLOTS);
+        uint8_t pages = max<uint8_t>(1, (n + TRAFFIC_DUMP_PAGE - 1) / TRAFFIC_DUMP_PAGE);
+
+        for (uint8_t page = 0; page < pages; page++)
+        {
+            DynamicJsonDocument doc(2048);
+            doc["serialNumber"] = serialNumber;
+            doc["page"] = page;
+            doc["pages"] = pages;
+            doc["uptime"] = millis() / 1000;
+
+            JsonArray rows = doc.createNestedArray("rows");
+            for (uint8_t i = page * TRAFFIC_DUMP_PAGE; i < n && i < (page + 1) * TRAFFIC_DUMP_PAGE; i++)
+            {
+                const TrafficEntry &e = dumpScratch[i];
+                JsonArray row = rows.createNestedArray();
+                row.add((const char *)e.prefix);
+                row.add(e.messages[TRAFFIC_IN]);
+                row.add(e.bytes[TRAFFIC_IN]);
+                row.add(e.drops[TRAFFIC_IN]);
+                row.add(e.messages[TRAFFIC_OUT]);
+                row.add(e.bytes[TRAFFIC_OUT]);
+                row.add(e.drops[TRAFFIC_OUT]);
+            }
+
+            String payload;
+            serializeJson(doc, payload);
+            SmartCore_RPC::respond("module/traffic", 1, false, payload.c_str(), payload.length());
+        }
+    }
+
+    void handleTrafficMessage(const char *payload, size_t len)
+    {
+        StaticJsonDocument<128> doc;
+        if (deserializeJson(doc, payload, len))
+        {
+            logMessage(LOG_WARN, "❌ Failed to parse traffic JSON");
+            SmartCore_RPC::fail("bad JSON");
+            return;
+        }
+
+        const char *action = doc["action"] | "dump";
+
+        if (!strcmp(action, "dump"))
+        {
+            SmartCore_RPC::deferred();
+            publishDump();
+            if (doc["reset"] | false)
+                reset();
+        }
+        else if (!strcmp(action, "reset"))
+        {
+            reset();
+            logMessage(LOG_INFO, "📶 Traffic counters reset");
+        }
+        else
+        {
+            SmartCore_RPC::fail("unsupported action");
+        }
+    }
+}
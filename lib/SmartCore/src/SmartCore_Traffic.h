@@ -0,0 +1,44 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Per-topic-prefix MQTT traffic accounting (override externally if needed)
+#ifndef TRAFFIC_SLOTS
+#define TRAFFIC_SLOTS 32 // last slot collects everything that did not fit ("#other")
+#endif
+#ifndef TRAFFIC_PREFIX_LEVELS
+#define TRAFFIC_PREFIX_LEVELS 3 // smartnet/<src>/<pgn>, module/config/update, ...
+#endif
+#define TRAFFIC_PREFIX_LEN 40
+#define TRAFFIC_DUMP_PAGE 12   // rows per module/traffic message
+#define TRAFFIC_METRICS_TOP 5  // busiest prefixes in module/metrics
+
+enum TrafficDir : uint8_t
+{
+    TRAFFIC_IN = 0,
+    TRAFFIC_OUT,
+    TRAFFIC_DIRS
+};
+
+struct TrafficEntry
+{
+    char prefix[TRAFFIC_PREFIX_LEN];
+    uint32_t messages[TRAFFIC_DIRS];
+    uint32_t bytes[TRAFFIC_DIRS];
+    uint32_t drops[TRAFFIC_DIRS];
+};
+
+namespace SmartCore_Traffic
+{
+    // Any task / AsyncTCP callback; a short critical section each
+    void count(const char *topic, TrafficDir dir, size_t bytes);
+    void dropped(const char *topic, TrafficDir dir);
+
+    // Copies the table; returns the number of entries in use
+    uint8_t snapshot(TrafficEntry *out, uint8_t max);
+
+    void reset();
+
+    // "<serial>/traffic": {"action":"dump"|"reset", "reset": true} → module/traffic
+    void handleTrafficMessage(const char *payload, size_t len);
+}
@@ -1,5 +1,6 @@
 #include "SmartCore_Wifi.h"
 #include "SmartCore_MQTT.h"
+#include "SmartCore_MQTTConn.h"
 #include "SmartCore_EEPROM.h"
 #include "SmartCore_LED.h"
 #include "SmartCore_Log.h"
@@ -7,6 +8,7 @@
 #include "SmartCore_Network.h"
 #include "esp_task_wdt.h"
 #include "SmartCore_System.h"
+#include "SmartCore_SignalK.h"
 #include <ESPmDNS.h>
 #include <ArduinoJson.h>
 #include <WiFi.h>
@@ -499,8 +501,13 @@ namespace SmartCore_WiFi
     //
     //  2) On boot:
     //       - We load the last used priority index.
-    //       - If it was 0 → normal boot; connect to primary.
-    //       - If it was >0 → we TEST PRIORITY 0 *3 times only*.
+    //       - All configured brokers are probed in parallel (one TCP connect
+    //         each, ≤ BROKER_PROBE_TIMEOUT_MS) and we connect to the
+    //         highest-priority one that answers — normally priority 0.
+    //       - Nobody answers → try priority 0, then the saved index.
+    //
+    //       This runs in SmartCore_MQTTConn as a non-blocking connect plan;
+    //       startup does not wait for it.
     //
     //       This gives:
     //         • Fast reconnect to backup if primary is still down
@@ -508,7 +515,7 @@ namespace SmartCore_WiFi
     //         • No endless switching or prolonged delays
     //
     //  3) If priority 0 responds → we switch back to it and save index 0 to EEPROM.
-    //     If priority 0 does NOT respond → we silently continue using the backup.
+    //     If priority 0 does NOT respond → we continue with the best backup.
     //
     //  4) Normal failover still occurs later inside wifiMqttCheckTask:
     //         - MQTT reconnection attempts
@@ -568,101 +575,26 @@ void startNetworkServices(bool mqttRequired = true)
     SmartCore_MQTT::currentPriorityIndex = savedIndex;
 
     // -------------------------------------------------------------
-    // Try PRIORITY 0 first if we were previously using a backup
+    // Sanity check: primary must be a real address
     // -------------------------------------------------------------
-    const int TRY_PRIMARY_ON_BOOT = 3;
+    String ip = mqttPriorityList[0];
 
-    if (savedIndex != 0)
+    if (savedIndex == 0 && (ip.length() == 0 || ip == "0.0.0.0" || ip == "127.0.0.1"))
     {
-        logMessage(
-            LOG_INFO,
-            "🔍 Previously using backup priority " + String(savedIndex) +
-            ". Testing priority 0..."
-        );
-
-        String primaryIP = mqttPriorityList[0];
-        uint16_t primaryPort = mqtt_port;
-
-        bool primaryConnected = false;
-
-        for (int attempt = 1; attempt <= TRY_PRIMARY_ON_BOOT; attempt++)
-        {
-            SmartCore_MQTT::hardResetClient();
-
-            logMessage(
-                LOG_INFO,
-                "🧪 Testing PRIMARY broker attempt " + String(attempt) +
-                " → " + primaryIP + ":" + String(primaryPort)
-            );
-
-            SmartCore_MQTT::setupMQTTClient(primaryIP, primaryPort);
-
-            // ---------------------------------------------------------
-            // Wait up to ~2 seconds for connection (poll, not blind)
-            // ---------------------------------------------------------
-            for (int wait = 0; wait < 20; wait++)
-            {
-                if (mqttIsConnected)
-                {
-                    primaryConnected = true;
-                    break;
-                }
-                vTaskDelay(pdMS_TO_TICKS(100));
-            }
-
-            if (primaryConnected)
-            {
-                logMessage(
-                    LOG_INFO,
-                    "🎉 PRIMARY is back online! Using priority 0."
-                );
-
-                SmartCore_MQTT::currentPriorityIndex = 0;
-
-                // Persist the change immediately
-                SmartCore_EEPROM::writeByteToEEPROM(
-                    MQTT_LAST_PRIORITY_ADDR, 0
-                );
-                EEPROM.commit();
-
-                break;
-            }
-        }
-
-        if (!primaryConnected)
-        {
-            logMessage(
-                LOG_WARN,
-                "⚠️ PRIMARY still offline → using backup priority " +
-                String(savedIndex)
-            );
-
-            SmartCore_MQTT::setupMQTTClient(
-                mqttPriorityList[savedIndex],
-                mqtt_port
-            );
-        }
+        Serial.println("⚠️ MQTT not started: No valid broker IP found");
+        return;
     }
-    else
-    {
-        // -------------------------------------------------------------
-        // Normal boot using priority 0
-        // -------------------------------------------------------------
-        String ip = mqttPriorityList[0];
-
-        if (ip.length() == 0 || ip == "0.0.0.0" || ip == "127.0.0.1")
-        {
-            Serial.println("⚠️ MQTT not started: No valid broker IP found");
-            return;
-        }
 
-        logMessage(
-            LOG_INFO,
-            "🚀 Starting MQTT using primary → " + ip
-        );
+    // -------------------------------------------------------------
+    // Hand the connect sequence to the connection manager:
+    //   probe all brokers → best responder
+    //   nobody answers   → primary, then the saved backup
+    // Returns immediately; the rest of startup runs while it connects.
+    // -------------------------------------------------------------
+    if (savedIndex == 0)
+        logMessage(LOG_INFO, "🚀 Starting MQTT using primary → " + ip);
 
-        SmartCore_MQTT::setupMQTTClient(ip, mqtt_port);
-    }
+    SmartCore_MQTTConn::bootConnect(savedIndex);
 
     // -------------------------------------------------------------
     // Start WiFi/MQTT health monitor
@@ -715,6 +647,9 @@ void startNetworkServices(bool mqttRequired = true)
         Serial.println("ℹ️ SmartNet already running — task not restarted");
     }
 
+    // Signal K delta stream for chartplotters (served from the module web server)
+    SmartCore_SignalK::begin(server);
+
 #endif // SMARTBOX_BUILD
 }
 
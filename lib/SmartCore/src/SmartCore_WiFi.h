@@ -10,6 +10,7 @@ extern char mqttPriorityList[3][17];
 namespace SmartCore_WiFi
 {
     extern TaskHandle_t wifiProvisionTaskHandle;
+    extern AsyncWebServer server;
 
     void startWiFiProvisionTask();                // To start the FreeRTOS WiFi task
     void wifiProvisionTask(void *parameter);      // wifimanager task
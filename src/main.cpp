@@ -32,6 +32,8 @@ SmartCoreSettings myModuleSettings = {
 
 //////////////////////////////////////////////////////////////
 
+#ifndef PIO_UNIT_TESTING // the on-target tests bring their own setup()/loop()
+
 // --- Setup Function ---
 void setup() {
     SmartCore_System::preinit();
@@ -66,6 +68,8 @@ void loop() {
   // This loop runs continuously after setup()
 }
 
+#endif
+
 
 // ========================= Module-Specific Configuration =========================
 
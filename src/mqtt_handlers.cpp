@@ -19,7 +19,7 @@ void handleModuleSpecificModule(const JsonObject &doc)
     }
 }
 
-void handleModuleSpecificErrors(const String &message)
+void handleModuleSpecificErrors(const char *payload, size_t len)
 {
     Serial.println("📦 [Template] handleModuleSpecificErrors() called.");
     // TODO: Add error-specific logic here
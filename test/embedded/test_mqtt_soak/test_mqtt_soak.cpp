@@ -0,0 +1,137 @@
+#include <Arduino.h>
+#include <WiFi.h>
+#include <unity.h>
+#include <esp_heap_caps.h>
+#include "SmartCore_MQTT.h"
+#include "SmartCore_Network.h"
+#include "SmartCore_Publisher.h"
+
+// ======================================================================================
+//  MQTT CLIENT SOAK (on target)
+// ======================================================================================
+//
+//  setupMQTTClient() reconfigures the one long-lived AsyncMqttClient instead of
+//  building a new one. This loops SOAK_CYCLES reconnect cycles and checks that the
+//  free heap and the largest free block stay flat. Anything a cycle leaks or
+//  fragments shows up as a steady slide.
+//
+//      warm-up   SOAK_WARMUP cycles (tasks, queues, pools are created once)
+//      baseline  free heap / largest block after the warm-up
+//      soak      every SOAK_SAMPLE_EVERY cycles both must stay within SOAK_HEAP_SLACK
+//                of the baseline
+//
+//  Every cycle must really connect and disconnect: without WiFi, setupMQTTClient()
+//  stops before connect() and the loop would prove nothing, so the test fails if WiFi
+//  is not up and asserts that each cycle reached CONNACK. Needs, in build_flags:
+//
+//      -DSOAK_WIFI_SSID=\"boat\" -DSOAK_WIFI_PASS=\"...\" -DSOAK_BROKER=\"192.168.4.1\"
+//
+//      pio test -e esp32-s3-devkitc-1 -f embedded/test_mqtt_soak
+//
+// ======================================================================================
+
+#ifndef SOAK_CYCLES
+#define SOAK_CYCLES 2000
+#endif
+#ifndef SOAK_BROKER
+#define SOAK_BROKER "192.168.4.1"
+#endif
+#define SOAK_WARMUP 20
+#define SOAK_SAMPLE_EVERY 100
+#define SOAK_HEAP_SLACK 4096       // bytes either value may sit below the baseline
+#define SOAK_CONNECT_WAIT_MS 3000
+#define SOAK_DISCONNECT_WAIT_MS 2000
+
+static bool waitForConnected(bool value, uint32_t ms)
+{
+    uint32_t start = millis();
+    while (mqttIsConnected != value && millis() - start < ms)
+        vTaskDelay(pdMS_TO_TICKS(10));
+    return mqttIsConnected == value;
+}
+
+// True once the cycle went through connect → CONNACK → disconnect
+static bool cycle()
+{
+    SmartCore_MQTT::setupMQTTClient(SOAK_BROKER, 1883);
+    bool connected = waitForConnected(true, SOAK_CONNECT_WAIT_MS);
+
+    SmartCore_Publisher::lockClient();
+    if (mqttClient)
+        mqttClient->disconnect(true);
+    SmartCore_Publisher::unlockClient();
+
+    bool disconnected = waitForConnected(false, SOAK_DISCONNECT_WAIT_MS);
+
+    vTaskDelay(pdMS_TO_TICKS(5)); // let the publish / worker tasks run
+    return connected && disconnected;
+}
+
+void test_reconnect_cycles_keep_heap_flat(void)
+{
+    if (WiFi.status() != WL_CONNECTED)
+        TEST_FAIL_MESSAGE("WiFi not connected — set SOAK_WIFI_SSID / SOAK_WIFI_PASS");
+
+    for (uint16_t i = 0; i < SOAK_WARMUP; i++)
+        TEST_ASSERT_TRUE_MESSAGE(cycle(), "warm-up cycle did not connect to SOAK_BROKER");
+
+    size_t baseFree = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+    size_t baseBlock = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+    size_t minFree = baseFree, minBlock = baseBlock;
+
+    char line[128];
+    snprintf(line, sizeof(line), "baseline: free %u, largest block %u", (unsigned)baseFree, (unsigned)baseBlock);
+    TEST_MESSAGE(line);
+
+    for (uint32_t i = 1; i <= SOAK_CYCLES; i++)
+    {
+        if (!cycle())
+        {
+            snprintf(line, sizeof(line), "cycle %u did not connect and disconnect", (unsigned)i);
+            TEST_FAIL_MESSAGE(line);
+        }
+
+        if (i % SOAK_SAMPLE_EVERY)
+            continue;
+
+        size_t freeNow = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+        size_t blockNow = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+        minFree = min(minFree, freeNow);
+        minBlock = min(minBlock, blockNow);
+
+        snprintf(line, sizeof(line), "cycle %u: free %u, largest block %u",
+                 (unsigned)i, (unsigned)freeNow, (unsigned)blockNow);
+        TEST_MESSAGE(line);
+
+        TEST_ASSERT_GREATER_OR_EQUAL_UINT32_MESSAGE(baseFree - SOAK_HEAP_SLACK, freeNow, "free heap is sliding");
+        TEST_ASSERT_GREATER_OR_EQUAL_UINT32_MESSAGE(baseBlock - SOAK_HEAP_SLACK, blockNow, "heap is fragmenting");
+    }
+
+    snprintf(line, sizeof(line), "%u cycles: free heap -%d, largest block -%d (worst vs baseline)",
+             (unsigned)SOAK_CYCLES, (int)(baseFree - minFree), (int)(baseBlock - minBlock));
+    TEST_MESSAGE(line);
+}
+
+void setUp(void) {}
+void tearDown(void) {}
+
+void setup()
+{
+    delay(2000); // give the serial monitor time to attach
+
+    WiFi.mode(WIFI_STA);
+
+#ifdef SOAK_WIFI_SSID
+    WiFi.begin(SOAK_WIFI_SSID, SOAK_WIFI_PASS);
+    for (uint8_t i = 0; i < 100 && WiFi.status() != WL_CONNECTED; i++)
+        delay(100);
+#endif
+
+    UNITY_BEGIN();
+    RUN_TEST(test_reconnect_cycles_keep_heap_flat);
+    UNITY_END();
+}
+
+void loop()
+{
+}
@@ -0,0 +1,212 @@
+#include <unity.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <chrono>
+
+// Framework-free source, built straight into the host test (the library itself is Arduino-only)
+#include "SmartCore_Gorilla.cpp"
+
+// ======================================================================================
+//  GORILLA CODEC — ROUND TRIP + BENCHMARK
+// ======================================================================================
+//
+//  There is no recorded boat data in the tree, so each series below is a synthetic
+//  stand-in built to look like what SmartCore_History stores. Values are quantized to
+//  the resolution SmartNet decodes them at (NMEA 2000 field resolution), and times
+//  run at the rate the history tiers sample. The generator is seeded, so every run
+//  measures the same data.
+//
+//      heading        1 s    random walk, 0.1°, wraps at 360
+//      water temp    10 s    slow sine + drift, 0.01 °C
+//      battery V      1 s    12.6 V ± noise, 0.01 V, charger steps
+//      depth          1 s    swell on a slope, 0.01 m, ~2 % of samples missing
+//      engine rpm     1 s    long runs of the same value, 0.25 rpm
+//      wind speed    60 s    gusty, 0.01 m/s (minute tier)
+//
+//  Blocks are HISTORY_BLOCK_SAMPLES (60) samples, as written by SmartCore_History.
+//  Reported per series: bytes/sample (raw = 8) and host encode/decode throughput.
+//
+//      pio test -e native -f native/test_gorilla -v
+//
+// ======================================================================================
+
+#define BENCH_BLOCK 60       // HISTORY_BLOCK_SAMPLES
+#define BENCH_SAMPLES 86400  // one day at 1 s
+#define BENCH_ROUNDS 20      // repeats for the timing
+#define BENCH_BLOCKS (BENCH_SAMPLES / BENCH_BLOCK)
+#define BENCH_T0 1700000000U
+
+static GorillaSample series[BENCH_SAMPLES];
+static GorillaSample decoded[BENCH_BLOCK];
+static uint8_t packed[BENCH_BLOCKS][SmartCore_Gorilla::maxEncodedSize(BENCH_BLOCK)];
+static size_t packedLen[BENCH_BLOCKS];
+
+static uint32_t rngState = 12345;
+
+static float uniform() // [-1, 1)
+{
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 17;
+    rngState ^= rngState << 5;
+    return (rngState >> 8) / 8388608.0f - 1.0f;
+}
+
+static float quantize(float v, float step)
+{
+    return roundf(v / step) * step;
+}
+
+typedef void (*SeriesGenerator)(GorillaSample *out, uint32_t n);
+
+static void genHeading(GorillaSample *out, uint32_t n)
+{
+    float h = 180.0f;
+    for (uint32_t i = 0; i < n; i++)
+    {
+        h = fmodf(h + uniform() * 1.5f + 360.0f, 360.0f);
+        out[i] = {BENCH_T0 + i, quantize(h, 0.1f)};
+    }
+}
+
+static void genWaterTemp(GorillaSample *out, uint32_t n)
+{
+    for (uint32_t i = 0; i < n; i++)
+    {
+        float t = 18.0f + 1.5f * sinf(i / 8640.0f * 6.2832f) + 0.02f * uniform();
+        out[i] = {BENCH_T0 + i * 10, quantize(t, 0.01f)};
+    }
+}
+
+static void genBattery(GorillaSample *out, uint32_t n)
+{
+    float base = 12.6f;
+    for (uint32_t i = 0; i < n; i++)
+    {
+        if (i % 3600 == 0)
+            base = uniform() > 0.0f ? 13.8f : 12.4f; // charger on / off
+        out[i] = {BENCH_T0 + i, quantize(base + 0.03f * uniform(), 0.01f)};
+    }
+}
+
+static void genDepth(GorillaSample *out, uint32_t n)
+{
+    uint32_t t = BENCH_T0;
+    for (uint32_t i = 0; i < n; i++)
+    {
+        t += uniform() > 0.96f ? 2 : 1; // a dropped frame now and then
+        float d = 8.0f + i * 0.0001f + 0.4f * sinf(i * 0.7f);
+        out[i] = {t, quantize(d, 0.01f)};
+    }
+}
+
+static void genRpm(GorillaSample *out, uint32_t n)
+{
+    float rpm = 0.0f;
+    for (uint32_t i = 0; i < n; i++)
+    {
+        if (uniform() > 0.995f)
+            rpm = uniform() > -0.5f ? quantize(1800.0f + 600.0f * uniform(), 0.25f) : 0.0f;
+        out[i] = {BENCH_T0 + i, rpm};
+    }
+}
+
+static void genWind(GorillaSample *out, uint32_t n)
+{
+    float w = 6.0f;
+    for (uint32_t i = 0; i < n; i++)
+    {
+        w = fmaxf(0.0f, w + uniform() * 0.8f);
+        out[i] = {BENCH_T0 + i * 60, quantize(w + (uniform() > 0.9f ? 3.0f : 0.0f), 0.01f)};
+    }
+}
+
+static bool sameSample(const GorillaSample &a, const GorillaSample &b)
+{
+    return a.t == b.t && memcmp(&a.v, &b.v, sizeof(float)) == 0;
+}
+
+static void benchSeries(const char *name, SeriesGenerator gen)
+{
+    gen(series, BENCH_SAMPLES);
+
+    // Round trip (bit-exact) and size
+    size_t bytes = 0;
+    for (uint32_t b = 0; b < BENCH_BLOCKS; b++)
+    {
+        const GorillaSample *block = &series[b * BENCH_BLOCK];
+        size_t len = SmartCore_Gorilla::encode(block, BENCH_BLOCK, packed[b], sizeof(packed[b]));
+        TEST_ASSERT_TRUE_MESSAGE(len > 0, "encode failed");
+        TEST_ASSERT_TRUE_MESSAGE(SmartCore_Gorilla::decode(packed[b], len, BENCH_BLOCK, decoded), "decode failed");
+
+        for (uint16_t k = 0; k < BENCH_BLOCK; k++)
+            TEST_ASSERT_TRUE_MESSAGE(sameSample(block[k], decoded[k]), "round trip mismatch");
+
+        packedLen[b] = len;
+        bytes += len;
+    }
+
+    // Throughput
+    using Clock = std::chrono::steady_clock;
+    volatile size_t sink = 0;
+
+    Clock::time_point start = Clock::now();
+    for (uint8_t r = 0; r < BENCH_ROUNDS; r++)
+        for (uint32_t b = 0; b < BENCH_BLOCKS; b++)
+            sink += SmartCore_Gorilla::encode(&series[b * BENCH_BLOCK], BENCH_BLOCK, packed[b], sizeof(packed[b]));
+    double encodeS = std::chrono::duration<double>(Clock::now() - start).count();
+
+    start = Clock::now();
+    for (uint8_t r = 0; r < BENCH_ROUNDS; r++)
+        for (uint32_t b = 0; b < BENCH_BLOCKS; b++)
+            sink += SmartCore_Gorilla::decode(packed[b], packedLen[b], BENCH_BLOCK, decoded);
+    double decodeS = std::chrono::duration<double>(Clock::now() - start).count();
+
+    double samples = (double)BENCH_ROUNDS * BENCH_SAMPLES;
+    double perSample = (double)bytes / BENCH_SAMPLES;
+
+    char line[160];
+    snprintf(line, sizeof(line), "%-11s %5.2f bytes/sample (%4.1fx) | encode %6.1f M samples/s | decode %6.1f M samples/s",
+             name, perSample, 8.0 / perSample, samples / encodeS / 1e6, samples / decodeS / 1e6);
+    TEST_MESSAGE(line);
+
+    TEST_ASSERT_TRUE_MESSAGE(perSample < 8.0, "no smaller than a raw block");
+}
+
+void test_heading(void) { benchSeries("heading", genHeading); }
+void test_water_temp(void) { benchSeries("water temp", genWaterTemp); }
+void test_battery(void) { benchSeries("battery V", genBattery); }
+void test_depth(void) { benchSeries("depth", genDepth); }
+void test_rpm(void) { benchSeries("engine rpm", genRpm); }
+void test_wind(void) { benchSeries("wind speed", genWind); }
+
+void test_truncated_block_is_rejected(void)
+{
+    genHeading(series, BENCH_BLOCK);
+    size_t len = SmartCore_Gorilla::encode(series, BENCH_BLOCK, packed[0], sizeof(packed[0]));
+    TEST_ASSERT_TRUE(len > 8);
+    TEST_ASSERT_FALSE(SmartCore_Gorilla::decode(packed[0], len / 2, BENCH_BLOCK, decoded));
+}
+
+void test_encode_respects_capacity(void)
+{
+    genWind(series, BENCH_BLOCK);
+    TEST_ASSERT_EQUAL_UINT32(0, SmartCore_Gorilla::encode(series, BENCH_BLOCK, packed[0], 16));
+}
+
+void setUp(void) {}
+void tearDown(void) {}
+
+int main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_truncated_block_is_rejected);
+    RUN_TEST(test_encode_respects_capacity);
+    RUN_TEST(test_heading);
+    RUN_TEST(test_water_temp);
+    RUN_TEST(test_battery);
+    RUN_TEST(test_depth);
+    RUN_TEST(test_rpm);
+    RUN_TEST(test_wind);
+    return UNITY_END();
+}
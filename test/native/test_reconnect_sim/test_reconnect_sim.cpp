@@ -0,0 +1,289 @@
+#include <unity.h>
+#include <stdio.h>
+#include <string.h>
+#include "SmartCore_Reconnect.h"
+
+// Framework-free source, built straight into the host test (the library itself is Arduino-only)
+#include "SmartCore_Backoff.cpp"
+
+// ======================================================================================
+//  FLEET RECONNECT SIMULATION
+// ======================================================================================
+//
+//  SIM_MODULES modules lose the SmartBox broker at t = 0 (SmartBox restart); it takes
+//  connections again at SIM_BROKER_DOWN_MS. Each module runs the wifiMqttCheckTask
+//  MQTT logic on its own 1 s tick (random phase):
+//
+//      legacy     attempt on the first tick, then every 10, 20, 40 … 300 s
+//      jitter     firstDelay() with no admission hint, then nextDelay()
+//      admission  firstDelay() in a SIM_WINDOW_MS / SIM_SLOTS admission window
+//
+//  Every mode also does the hard-reset attempt (8 s down) and the failover attempt
+//  (> 10 s down, fresh backoff) of the real task; with one SmartBox both land on the
+//  same broker. An attempt succeeds when the broker is up — connect timeouts and
+//  broker-side limits are not modelled.
+//
+//  Reported per mode: peak connect attempts and peak successful connects in any 1 s
+//  bucket, and how long after the broker came back the last module was connected.
+//
+//      pio test -e native -f native/test_reconnect_sim -v
+//
+// ======================================================================================
+
+#define SIM_MODULES 100
+#define SIM_BROKER_DOWN_MS 30000
+#define SIM_WINDOW_MS 60000
+#define SIM_SLOTS 120
+#define SIM_END_MS 900000
+#define SIM_STEP_MS 10
+#define SIM_TICK_MS 1000
+
+enum SimMode
+{
+    SIM_LEGACY,
+    SIM_JITTER,
+    SIM_ADMISSION
+};
+
+struct SimModule
+{
+    uint32_t phase;
+    uint32_t macHash;
+    uint32_t rng;
+    uint32_t sleepMs; // SmartCore_Reconnect's decorrelated state
+    uint32_t backoff;
+    uint32_t lastAttempt;
+    uint8_t failCount;
+    bool outage;
+    bool attempted;
+    bool hardResetDone;
+    bool connected;
+};
+
+struct SimResult
+{
+    uint32_t peakAttempts;  // per second
+    uint32_t peakConnects;  // per second
+    uint32_t totalAttempts;
+    uint32_t allConnectedMs; // after the broker came back
+    uint16_t connected;
+};
+
+static uint16_t attemptsPerSecond[SIM_END_MS / 1000];
+static uint16_t connectsPerSecond[SIM_END_MS / 1000];
+
+static uint32_t nextDelay(SimModule &m)
+{
+    m.sleepMs = SmartCore_Backoff::decorrelated(m.rng, m.sleepMs, RECONNECT_BASE_MS, RECONNECT_CAP_MS);
+    return m.sleepMs;
+}
+
+static void attempt(SimModule &m, uint32_t now, SimResult &r)
+{
+    attemptsPerSecond[now / 1000]++;
+    r.totalAttempts++;
+
+    if (now >= SIM_BROKER_DOWN_MS)
+    {
+        m.connected = true;
+        connectsPerSecond[now / 1000]++;
+    }
+}
+
+// One pass of wifiMqttCheckTask's MQTT branch (SmartCore_LED.cpp), per mode
+static void tick(SimModule &m, SimMode mode, uint32_t now, SimResult &r)
+{
+    if (mode == SIM_LEGACY)
+    {
+        if (!m.outage)
+        {
+            m.outage = true;
+            m.backoff = RECONNECT_BASE_MS;
+            m.lastAttempt = now - RECONNECT_BASE_MS; // long connected → due at once
+        }
+
+        m.failCount++;
+        if (now - m.lastAttempt >= m.backoff)
+        {
+            m.lastAttempt = now;
+            attempt(m, now, r);
+            m.backoff = m.backoff * 2 < RECONNECT_CAP_MS ? m.backoff * 2 : RECONNECT_CAP_MS;
+        }
+    }
+    else
+    {
+        if (!m.outage)
+        {
+            m.outage = true;
+            m.lastAttempt = now;
+            m.backoff = SmartCore_Backoff::firstDelay(m.rng, m.macHash,
+                                                      mode == SIM_ADMISSION ? SIM_WINDOW_MS : 0,
+                                                      mode == SIM_ADMISSION ? SIM_SLOTS : 0,
+                                                      RECONNECT_SPREAD_MS);
+        }
+
+        if (m.attempted)
+            m.failCount++;
+
+        if (now - m.lastAttempt >= m.backoff)
+        {
+            m.lastAttempt = now;
+            m.attempted = true;
+            attempt(m, now, r);
+            m.backoff = nextDelay(m);
+        }
+    }
+
+    if (m.connected)
+        return;
+
+    if (m.failCount >= 8 && !m.hardResetDone)
+    {
+        m.hardResetDone = true;
+        attempt(m, now, r);
+        if (m.connected)
+            return;
+    }
+
+    if (m.failCount > 10)
+    {
+        attempt(m, now, r); // failover: probes, then connects to the best broker
+        m.failCount = 0;
+        m.hardResetDone = false;
+        m.lastAttempt = now;
+
+        if (mode == SIM_LEGACY)
+        {
+            m.backoff = RECONNECT_BASE_MS;
+        }
+        else
+        {
+            m.sleepMs = RECONNECT_BASE_MS;
+            m.backoff = nextDelay(m);
+        }
+    }
+}
+
+static SimResult simulate(SimMode mode)
+{
+    static SimModule fleet[SIM_MODULES];
+    SimResult r = {};
+
+    memset(attemptsPerSecond, 0, sizeof(attemptsPerSecond));
+    memset(connectsPerSecond, 0, sizeof(connectsPerSecond));
+
+    uint32_t phaseRng = 0x1234567UL;
+    for (uint16_t i = 0; i < SIM_MODULES; i++)
+    {
+        // Made-up but distinct MACs; fixed "esp_random" so runs are repeatable
+        uint8_t mac[6] = {0x24, 0x6F, 0x28, (uint8_t)(i >> 8), (uint8_t)i, (uint8_t)(i * 37)};
+        SimModule &m = fleet[i];
+        memset(&m, 0, sizeof(m));
+        m.macHash = SmartCore_Backoff::hashMac(mac);
+        m.rng = SmartCore_Backoff::seed(m.macHash, 0xA5A5A5A5UL + i * 2654435761UL);
+        m.sleepMs = RECONNECT_BASE_MS;
+        m.phase = SmartCore_Backoff::between(phaseRng, 0, SIM_TICK_MS / SIM_STEP_MS - 1) * SIM_STEP_MS;
+    }
+
+    for (uint32_t now = 0; now < SIM_END_MS && r.connected < SIM_MODULES; now += SIM_STEP_MS)
+    {
+        for (uint16_t i = 0; i < SIM_MODULES; i++)
+        {
+            SimModule &m = fleet[i];
+            if (m.connected || now % SIM_TICK_MS != m.phase)
+                continue;
+
+            tick(m, mode, now, r);
+            if (m.connected)
+            {
+                r.connected++;
+                r.allConnectedMs = now - SIM_BROKER_DOWN_MS;
+            }
+        }
+    }
+
+    for (uint32_t s = 0; s < SIM_END_MS / 1000; s++)
+    {
+        if (attemptsPerSecond[s] > r.peakAttempts)
+            r.peakAttempts = attemptsPerSecond[s];
+        if (connectsPerSecond[s] > r.peakConnects)
+            r.peakConnects = connectsPerSecond[s];
+    }
+
+    return r;
+}
+
+static void report(const char *name, const SimResult &r)
+{
+    char line[160];
+    snprintf(line, sizeof(line),
+             "%-9s peak %3u attempts/s, %3u connects/s | %4u attempts | all connected %6.1f s after broker up",
+             name, (unsigned)r.peakAttempts, (unsigned)r.peakConnects, (unsigned)r.totalAttempts,
+             r.allConnectedMs / 1000.0);
+    TEST_MESSAGE(line);
+    TEST_ASSERT_EQUAL_UINT16_MESSAGE(SIM_MODULES, r.connected, "fleet did not reconnect in the simulated time");
+}
+
+static SimResult legacy, jitter, admission;
+
+void test_legacy_backoff(void)
+{
+    legacy = simulate(SIM_LEGACY);
+    report("legacy", legacy);
+}
+
+void test_jitter_backoff(void)
+{
+    jitter = simulate(SIM_JITTER);
+    report("jitter", jitter);
+
+    TEST_ASSERT_LESS_THAN_UINT32(legacy.peakAttempts, jitter.peakAttempts);
+    TEST_ASSERT_LESS_THAN_UINT32(legacy.peakConnects, jitter.peakConnects);
+}
+
+void test_admission_window(void)
+{
+    admission = simulate(SIM_ADMISSION);
+    report("admission", admission);
+
+    TEST_ASSERT_LESS_THAN_UINT32(legacy.peakAttempts, admission.peakAttempts);
+    TEST_ASSERT_LESS_THAN_UINT32(legacy.peakConnects, admission.peakConnects);
+}
+
+void test_decorrelated_stays_in_bounds(void)
+{
+    uint32_t rng = SmartCore_Backoff::seed(0xDEADBEEFUL, 1);
+    uint32_t sleep = RECONNECT_BASE_MS;
+
+    for (uint16_t i = 0; i < 10000; i++)
+    {
+        sleep = SmartCore_Backoff::decorrelated(rng, sleep, RECONNECT_BASE_MS, RECONNECT_CAP_MS);
+        TEST_ASSERT_GREATER_OR_EQUAL_UINT32(RECONNECT_BASE_MS, sleep);
+        TEST_ASSERT_LESS_OR_EQUAL_UINT32(RECONNECT_CAP_MS, sleep);
+    }
+}
+
+void test_admission_slot_stays_in_window(void)
+{
+    uint32_t rng = SmartCore_Backoff::seed(1, 2);
+
+    for (uint32_t h = 0; h < 5000; h++)
+    {
+        uint32_t d = SmartCore_Backoff::firstDelay(rng, h * 2654435761UL, SIM_WINDOW_MS, SIM_SLOTS, RECONNECT_SPREAD_MS);
+        TEST_ASSERT_LESS_OR_EQUAL_UINT32(SIM_WINDOW_MS, d);
+    }
+}
+
+void setUp(void) {}
+void tearDown(void) {}
+
+int main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_decorrelated_stays_in_bounds);
+    RUN_TEST(test_admission_slot_stays_in_window);
+    RUN_TEST(test_legacy_backoff);
+    RUN_TEST(test_jitter_backoff);
+    RUN_TEST(test_admission_window);
+    return UNITY_END();
+}